@@ -49,6 +49,7 @@
 
 
 #define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 100
+#define ABSTRACT_SERVER_SEND_QUE_MAX_SIZE  (64 * 1024 * 1024) //bytes queued on one connection, more closes it
 
 namespace epee
 {
@@ -91,6 +92,7 @@ namespace net_utils
   private:
     //----------------- i_service_endpoint ---------------------
     virtual bool do_send(const void* ptr, size_t cb);
+    virtual bool do_send_shared(const void* ptr, size_t cb, const boost::shared_ptr<const std::string>& buff, send_priority priority);
     virtual bool close();
     virtual bool call_run_once_service_io();
     virtual bool request_callback();
@@ -107,6 +109,9 @@ namespace net_utils
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code& e, size_t cb);
 
+    /// Start writing the first entry of the send queue.
+    void start_write();
+
     /// Strand to ensure the connection's handlers are not called concurrently.
     boost::asio::io_service::strand strand_;
 
@@ -120,7 +125,16 @@ namespace net_utils
     volatile uint32_t m_want_close_connection;
     std::atomic<bool> m_was_shutdown;
     critical_section m_send_que_lock;
-    std::list<std::string> m_send_que;
+    /// Own bytes (the levin header) followed by a shared buffer (the payload), written with one gathering write.
+    /// The same payload can be queued on many connections.
+    struct send_que_entry
+    {
+      std::string head;
+      boost::shared_ptr<const std::string> body;
+      send_priority priority;
+      size_t size;
+    };
+    std::list<send_que_entry> m_send_que;
     volatile uint32_t& m_ref_sockets_count;
     i_connection_filter* &m_pfilter;
     volatile bool m_is_multithreaded;
@@ -287,6 +287,12 @@ PRAGMA_WARNING_DISABLE_VS(4355)
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
   bool connection<t_protocol_handler>::do_send(const void* ptr, size_t cb)
+  {
+    return do_send_shared(ptr, cb, boost::shared_ptr<const std::string>(), send_priority_normal);
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  bool connection<t_protocol_handler>::do_send_shared(const void* ptr, size_t cb, const boost::shared_ptr<const std::string>& buff, send_priority priority)
   {
     TRY_ENTRY();
     // Use safe_shared_from_this, because of this is public method and it can be called on the object being deleted
@@ -296,9 +302,10 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     if(m_was_shutdown)
       return false;
 
-    LOG_PRINT("[sock " << socket_.native_handle() << "] SEND " << cb, LOG_LEVEL_4);
+    size_t total_cb = buff ? cb + buff->size() : cb;
+    LOG_PRINT("[sock " << socket_.native_handle() << "] SEND " << total_cb, LOG_LEVEL_4);
     context.m_last_send = time(NULL);
-    context.m_send_cnt += cb;
+    context.m_send_cnt += total_cb;
     //some data should be wrote to stream
     //request complete
     
@@ -311,8 +318,26 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       return false;
     }
 
-    m_send_que.resize(m_send_que.size()+1);
-    m_send_que.back().assign((const char*)ptr, cb);
+    //a single entry may be bigger than the limit, it just can not be queued behind others
+    if(!m_send_que.empty() && context.m_send_que_size + total_cb > ABSTRACT_SERVER_SEND_QUE_MAX_SIZE)
+    {
+      send_guard.unlock();
+      LOG_WARNING("send que size is more than ABSTRACT_SERVER_SEND_QUE_MAX_SIZE(" << ABSTRACT_SERVER_SEND_QUE_MAX_SIZE << "), shutting down connection", LOG_LEVEL_2);
+      close();
+      return false;
+    }
+
+    //the front entry is being written, the new one goes behind it and behind all entries of the same or higher priority
+    auto it = m_send_que.end();
+    while(it != m_send_que.begin() && std::prev(it) != m_send_que.begin() && std::prev(it)->priority > priority)
+      --it;
+
+    it = m_send_que.insert(it, send_que_entry());
+    it->head.assign((const char*)ptr, cb);
+    it->body = buff;
+    it->priority = priority;
+    it->size = total_cb;
+    context.m_send_que_size += total_cb;
     
     if(m_send_que.size() > 1)
     {
@@ -326,18 +351,30 @@ PRAGMA_WARNING_DISABLE_VS(4355)
         return false;
       }
 
-      boost::asio::async_write(socket_, boost::asio::buffer(m_send_que.front().data(), m_send_que.front().size()),
-        //strand_.wrap(
-        boost::bind(&connection<t_protocol_handler>::handle_write, self, _1, _2)
-        //)
-        );
-      
-      LOG_PRINT_L4("[sock " << socket_.native_handle() << "] Async send requested " << m_send_que.front().size());
+      start_write();
+      LOG_PRINT_L4("[sock " << socket_.native_handle() << "] Async send requested " << total_cb);
     }
 
     return true;
 
-    CATCH_ENTRY_L0("connection<t_protocol_handler>::do_send", false);
+    CATCH_ENTRY_L0("connection<t_protocol_handler>::do_send_shared", false);
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_write()
+  {
+    //should be called under m_send_que_lock
+    const send_que_entry& entry = m_send_que.front();
+    boost::array<boost::asio::const_buffer, 2> buffers = {{
+      boost::asio::const_buffer(entry.head.data(), entry.head.size()),
+      entry.body ? boost::asio::const_buffer(entry.body->data(), entry.body->size()) : boost::asio::const_buffer()
+    }};
+
+    boost::asio::async_write(socket_, buffers,
+      //strand_.wrap(
+      boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2)
+      //)
+      );
   }
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
@@ -391,6 +428,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       return;
     }
 
+    context.m_send_que_size -= m_send_que.front().size;
     m_send_que.pop_front();
     if(m_send_que.empty())
     {
@@ -401,10 +439,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }else
     {
       //have more data to send
-      boost::asio::async_write(socket_, boost::asio::buffer(m_send_que.front().data(), m_send_que.front().size()),
-        //strand_.wrap(
-          boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2));
-        //);
+      start_write();
     }
     CRITICAL_REGION_END();
 
@@ -73,6 +73,7 @@ public:
   int invoke_async(int command, const std::string& in_buff, boost::uuids::uuid connection_id, callback_t cb, size_t timeout = LEVIN_DEFAULT_TIMEOUT_PRECONFIGURED);
 
   int notify(int command, const std::string& in_buff, boost::uuids::uuid connection_id);
+  int notify(int command, const boost::shared_ptr<const std::string>& in_buff, boost::uuids::uuid connection_id, net_utils::send_priority priority = net_utils::send_priority_normal);
   bool close(boost::uuids::uuid connection_id);
   bool update_connection_context(const t_connection_context& contxt);
   bool request_callback(boost::uuids::uuid connection_id);
@@ -120,7 +121,8 @@ public:
   config_type& m_config;
   t_connection_context& m_connection_context;
 
-  std::string m_cache_in_buffer;
+  std::string m_cache_in_buffer; //header bytes received so far, never more than sizeof(bucket_head2)
+  std::string m_body_buffer; //body of the current packet, received bytes are appended to it in place
   stream_state m_state;
 
   int32_t m_oponent_protocol_ver;
@@ -316,36 +318,37 @@ public:
       return false;
     }
 
-    if(m_cache_in_buffer.size() +  cb > m_config.m_max_packet_size)
+    if(m_cache_in_buffer.size() + m_body_buffer.size() + cb > m_config.m_max_packet_size)
     {
       LOG_ERROR_CC(m_connection_context, "Maximum packet size exceed!, m_max_packet_size = " << m_config.m_max_packet_size 
-                          << ", packet received " << m_cache_in_buffer.size() +  cb 
+                          << ", packet received " << m_cache_in_buffer.size() + m_body_buffer.size() + cb 
                           << ", connection will be closed.");
       return false;
     }
 
-    m_cache_in_buffer.append((const char*)ptr, cb);
-
+    //received bytes are consumed straight from ptr: the header is gathered in m_cache_in_buffer and the body
+    //in m_body_buffer, so nothing is copied twice or shifted when several packets come in one chunk
+    const char* data = (const char*)ptr;
     bool is_continue = true;
     while(is_continue)
     {
       switch(m_state)
       {
       case stream_state_body:
-        if(m_cache_in_buffer.size() < m_current_head.m_cb)
+        {
+          size_t body_cb = (size_t)std::min<uint64_t>(cb, m_current_head.m_cb - m_body_buffer.size());
+          m_body_buffer.append(data, body_cb);
+          data += body_cb;
+          cb -= body_cb;
+        }
+        if(m_body_buffer.size() < m_current_head.m_cb)
         {
           is_continue = false;
           break;
         }
         {
           std::string buff_to_invoke;
-          if(m_cache_in_buffer.size()  == m_current_head.m_cb)
-            buff_to_invoke.swap(m_cache_in_buffer);
-          else
-          {
-            buff_to_invoke.assign(m_cache_in_buffer, 0, (std::string::size_type)m_current_head.m_cb);
-            m_cache_in_buffer.erase(0, (std::string::size_type)m_current_head.m_cb);
-          }
+          buff_to_invoke.swap(m_body_buffer);
 
           bool is_response = (m_oponent_protocol_ver == LEVIN_PROTOCOL_VER_1 && m_current_head.m_flags&LEVIN_PACKET_RESPONSE);
 
@@ -393,20 +396,18 @@ public:
           {
             if(m_current_head.m_have_to_return_data)
             {
-              std::string return_buff;
+              boost::shared_ptr<std::string> return_buff(new std::string());
               m_current_head.m_return_code = m_config.m_pcommands_handler->invoke(
                                                                   m_current_head.m_command, 
                                                                   buff_to_invoke, 
-                                                                  return_buff, 
+                                                                  *return_buff, 
                                                                   m_connection_context);
-              m_current_head.m_cb = return_buff.size();
+              m_current_head.m_cb = return_buff->size();
               m_current_head.m_have_to_return_data = false;
               m_current_head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
               m_current_head.m_flags = LEVIN_PACKET_RESPONSE;
-              std::string send_buff((const char*)&m_current_head, sizeof(m_current_head));
-              send_buff += return_buff;
               CRITICAL_REGION_BEGIN(m_send_lock);
-              if(!m_pservice_endpoint->do_send(send_buff.data(), send_buff.size()))
+              if(!m_pservice_endpoint->do_send_shared(&m_current_head, sizeof(m_current_head), return_buff, net_utils::send_priority_normal))
                 return false;
               CRITICAL_REGION_END();
               LOG_PRINT_CC_L4(m_connection_context, "LEVIN_PACKET_SENT. [len=" << m_current_head.m_cb 
@@ -423,6 +424,10 @@ public:
         break;
       case stream_state_head:
         {
+          size_t head_cb = std::min(cb, sizeof(bucket_head2) - m_cache_in_buffer.size());
+          m_cache_in_buffer.append(data, head_cb);
+          data += head_cb;
+          cb -= head_cb;
           if(m_cache_in_buffer.size() < sizeof(bucket_head2))
           {
             if(m_cache_in_buffer.size() >= sizeof(uint64_t) && *((uint64_t*)m_cache_in_buffer.data()) != LEVIN_SIGNATURE)
@@ -442,7 +447,7 @@ public:
           }
           m_current_head = *phead;
 
-          m_cache_in_buffer.erase(0, sizeof(bucket_head2));
+          m_cache_in_buffer.clear();
           m_state = stream_state_body;
           m_oponent_protocol_ver = m_current_head.m_protocol_version;
           if(m_current_head.m_cb > m_config.m_max_packet_size)
@@ -452,6 +457,8 @@ public:
               << ", connection will be closed.");
             return false;
           }
+          //the size comes from the peer, so only a bounded part of it is allocated ahead
+          m_body_buffer.reserve((size_t)std::min<uint64_t>(m_current_head.m_cb, LEVIN_INITIAL_BODY_RESERVE));
         }
         break;
       default:
@@ -511,20 +518,14 @@ public:
       boost::interprocess::ipcdetail::atomic_write32(&m_invoke_buf_ready, 0);
       CRITICAL_REGION_BEGIN(m_send_lock);
       CRITICAL_REGION_LOCAL1(m_invoke_response_handlers_lock);
-      if(!m_pservice_endpoint->do_send(&head, sizeof(head)))
+      //one queue entry, so the header and the body can not be split by data of a higher priority
+      if(!m_pservice_endpoint->do_send_shared(&head, sizeof(head), boost::make_shared<std::string>(in_buff), net_utils::send_priority_normal))
       {
 //        LOG_ERROR_CC(m_connection_context, "Failed to do_send");
         err_code = LEVIN_ERROR_CONNECTION;
         break;
       }
 
-      if(!m_pservice_endpoint->do_send(in_buff.data(), (int)in_buff.size()))
-      {
-        LOG_ERROR_CC(m_connection_context, "Failed to do_send");
-        err_code = LEVIN_ERROR_CONNECTION;
-        break;
-      }
-
       if(!add_invoke_response_handler(cb, timeout, *this, command))
       {
         err_code = LEVIN_ERROR_CONNECTION_DESTROYED;
@@ -568,13 +569,7 @@ public:
 
     boost::interprocess::ipcdetail::atomic_write32(&m_invoke_buf_ready, 0);
     CRITICAL_REGION_BEGIN(m_send_lock);
-    if(!m_pservice_endpoint->do_send(&head, sizeof(head)))
-    {
-      LOG_ERROR_CC(m_connection_context, "Failed to do_send");
-      return LEVIN_ERROR_CONNECTION;
-    }
-
-    if(!m_pservice_endpoint->do_send(in_buff.data(), (int)in_buff.size()))
+    if(!m_pservice_endpoint->do_send_shared(&head, sizeof(head), boost::make_shared<std::string>(in_buff), net_utils::send_priority_normal))
     {
       LOG_ERROR_CC(m_connection_context, "Failed to do_send");
       return LEVIN_ERROR_CONNECTION;
@@ -613,6 +608,12 @@ public:
   }
 
   int notify(int command, const std::string& in_buff)
+  {
+    return notify(command, boost::shared_ptr<const std::string>(new std::string(in_buff)));
+  }
+
+  //the buffer is handed to the endpoint as is, so one serialized notification can be queued to many connections
+  int notify(int command, const boost::shared_ptr<const std::string>& in_buff, net_utils::send_priority priority = net_utils::send_priority_normal)
   {
     misc_utils::auto_scope_leave_caller scope_exit_handler = misc_utils::create_scope_leave_handler(
                           boost::bind(&async_protocol_handler::finish_outer_call, this));
@@ -628,23 +629,17 @@ public:
     bucket_head2 head = {0};
     head.m_signature = LEVIN_SIGNATURE;
     head.m_have_to_return_data = false;
-    head.m_cb = in_buff.size();
+    head.m_cb = in_buff->size();
 
     head.m_command = command;
     head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
     head.m_flags = LEVIN_PACKET_REQUEST;
     CRITICAL_REGION_BEGIN(m_send_lock);
-    if(!m_pservice_endpoint->do_send(&head, sizeof(head)))
+    if(!m_pservice_endpoint->do_send_shared(&head, sizeof(head), in_buff, priority))
     {
 //      LOG_ERROR_CC(m_connection_context, "Failed to do_send()");
       return -1;
     }
-
-    if(!m_pservice_endpoint->do_send(in_buff.data(), (int)in_buff.size()))
-    {
-      LOG_ERROR("Failed to do_send()");
-      return -1;
-    }
     CRITICAL_REGION_END();
     LOG_PRINT_CC_L4(m_connection_context, "LEVIN_PACKET_SENT. [len=" << head.m_cb << 
       ", f=" << head.m_flags << 
@@ -742,6 +737,14 @@ int async_protocol_handler_config<t_connection_context>::notify(int command, con
 }
 //------------------------------------------------------------------------------------------
 template<class t_connection_context>
+int async_protocol_handler_config<t_connection_context>::notify(int command, const boost::shared_ptr<const std::string>& in_buff, boost::uuids::uuid connection_id, net_utils::send_priority priority)
+{
+  async_protocol_handler<t_connection_context>* aph;
+  int r = find_and_lock_connection(connection_id, aph);
+  return LEVIN_OK == r ? aph->notify(command, in_buff, priority) : r;
+}
+//------------------------------------------------------------------------------------------
+template<class t_connection_context>
 bool async_protocol_handler_config<t_connection_context>::close(boost::uuids::uuid connection_id)
 {
   CRITICAL_REGION_LOCAL(m_connects_lock);
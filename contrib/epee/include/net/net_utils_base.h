@@ -29,6 +29,8 @@
 #ifndef _NET_UTILS_BASE_H_
 #define _NET_UTILS_BASE_H_
 
+#include <atomic>
+#include <boost/shared_ptr.hpp>
 #include <boost/uuid/uuid.hpp>
 #include "string_tools.h"
 
@@ -60,6 +62,9 @@ namespace net_utils
     time_t   m_last_send;
     uint64_t m_recv_cnt;
     uint64_t m_send_cnt;
+    //bytes queued for sending and not written to the socket yet, changed under the send queue lock of the connection
+    //and read without it by the protocol handler
+    std::atomic<uint64_t> m_send_que_size;
 
     connection_context_base(boost::uuids::uuid connection_id,
                             long remote_ip, int remote_port, bool is_income,
@@ -73,7 +78,8 @@ namespace net_utils
                                             m_last_recv(last_recv),
                                             m_last_send(last_send),
                                             m_recv_cnt(recv_cnt),
-                                            m_send_cnt(send_cnt)
+                                            m_send_cnt(send_cnt),
+                                            m_send_que_size(0)
     {}
 
     connection_context_base(): m_connection_id(),
@@ -84,7 +90,20 @@ namespace net_utils
                                m_last_recv(0),
                                m_last_send(0),
                                m_recv_cnt(0),
-                               m_send_cnt(0)
+                               m_send_cnt(0),
+                               m_send_que_size(0)
+    {}
+
+    connection_context_base(const connection_context_base& a): m_connection_id(a.m_connection_id),
+                                                               m_remote_ip(a.m_remote_ip),
+                                                               m_remote_port(a.m_remote_port),
+                                                               m_is_income(a.m_is_income),
+                                                               m_started(a.m_started),
+                                                               m_last_recv(a.m_last_recv),
+                                                               m_last_send(a.m_last_send),
+                                                               m_recv_cnt(a.m_recv_cnt),
+                                                               m_send_cnt(a.m_send_cnt),
+                                                               m_send_que_size(a.m_send_que_size.load())
     {}
 
     connection_context_base& operator=(const connection_context_base& a)
@@ -104,12 +123,25 @@ namespace net_utils
 
 	};
 
+  //queued data of a higher priority is sent ahead of the queued data of the lower ones, in order within one priority
+  enum send_priority
+  {
+    send_priority_high,
+    send_priority_normal,
+    send_priority_bulk
+  };
+
 	/************************************************************************/
 	/*                                                                      */
 	/************************************************************************/
 	struct i_service_endpoint
 	{
 		virtual bool do_send(const void* ptr, size_t cb)=0;
+    //sends cb bytes at ptr followed by buff, which the endpoint may hold on to instead of copying it
+    virtual bool do_send_shared(const void* ptr, size_t cb, const boost::shared_ptr<const std::string>& buff, send_priority priority)
+    {
+      return do_send(ptr, cb) && do_send(buff->data(), buff->size());
+    }
     virtual bool close()=0;
     virtual bool call_run_once_service_io()=0;
     virtual bool request_callback()=0;
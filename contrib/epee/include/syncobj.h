@@ -31,7 +31,9 @@
 #define __WINH_OBJ_H__
 
 #include <condition_variable>
+#include <map>
 #include <mutex>
+#include <thread>
 
 namespace epee
 {
@@ -135,6 +137,133 @@ namespace epee
   };
 
 
+  // Shared/exclusive lock that can be re-entered by its owners. A thread that holds the lock exclusively
+  // may take it again in either mode, a thread that holds it shared may take it shared again even while
+  // writers are waiting. Upgrading a shared lock to exclusive is not supported and deadlocks.
+  class recursive_shared_critical_section
+  {
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::thread::id m_writer;
+    size_t m_writerDepth;
+    size_t m_waitingWriters;
+    std::map<std::thread::id, size_t> m_readers;
+
+    recursive_shared_critical_section(const recursive_shared_critical_section&);
+    recursive_shared_critical_section& operator=(const recursive_shared_critical_section&);
+
+  public:
+    recursive_shared_critical_section() : m_writerDepth(0), m_waitingWriters(0)
+    {
+    }
+
+    void lock()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      std::thread::id self = std::this_thread::get_id();
+      if (m_writerDepth != 0 && m_writer == self)
+      {
+        ++m_writerDepth;
+        return;
+      }
+
+      ++m_waitingWriters;
+      m_released.wait(lock, [this] { return m_writerDepth == 0 && m_readers.empty(); });
+      --m_waitingWriters;
+      m_writer = self;
+      m_writerDepth = 1;
+    }
+
+    void unlock()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (--m_writerDepth == 0)
+      {
+        m_writer = std::thread::id();
+        m_released.notify_all();
+      }
+    }
+
+    void lock_shared()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      std::thread::id self = std::this_thread::get_id();
+      if (m_writerDepth != 0 && m_writer == self)
+      {
+        ++m_writerDepth;
+        return;
+      }
+
+      auto reader = m_readers.find(self);
+      if (reader != m_readers.end())
+      {
+        ++reader->second;
+        return;
+      }
+
+      // waiting writers go first, otherwise a steady stream of readers starves them
+      m_released.wait(lock, [this] { return m_writerDepth == 0 && m_waitingWriters == 0; });
+      m_readers.insert(std::make_pair(self, size_t(1)));
+    }
+
+    void unlock_shared()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      std::thread::id self = std::this_thread::get_id();
+      if (m_writerDepth != 0 && m_writer == self)
+      {
+        --m_writerDepth;
+        if (m_writerDepth == 0)
+        {
+          m_writer = std::thread::id();
+          m_released.notify_all();
+        }
+
+        return;
+      }
+
+      auto reader = m_readers.find(self);
+      if (--reader->second == 0)
+      {
+        m_readers.erase(reader);
+        if (m_readers.empty())
+        {
+          m_released.notify_all();
+        }
+      }
+    }
+  };
+
+  template<class t_lock>
+  class shared_critical_region_t
+  {
+    t_lock&	m_locker;
+    bool m_unlocked;
+
+    shared_critical_region_t(const shared_critical_region_t&) {}
+
+  public:
+    shared_critical_region_t(t_lock& cs): m_locker(cs), m_unlocked(false)
+    {
+      m_locker.lock_shared();
+    }
+
+    ~shared_critical_region_t()
+    {
+      unlock();
+    }
+
+    void unlock()
+    {
+      if (!m_unlocked)
+      {
+        m_locker.unlock_shared();
+        m_unlocked = true;
+      }
+    }
+  };
+
+
 #if defined(WINDWOS_PLATFORM)
   class shared_critical_section
   {
@@ -207,7 +336,7 @@ namespace epee
   };
 #endif
 
-#define  SHARED_CRITICAL_REGION_BEGIN(x) { shared_guard   critical_region_var(x)
+#define  SHARED_CRITICAL_REGION_BEGIN(x) { epee::shared_critical_region_t<decltype(x)>   critical_region_var(x)
 #define  EXCLUSIVE_CRITICAL_REGION_BEGIN(x) { exclusive_guard   critical_region_var(x)
 
 #define  CRITICAL_REGION_LOCAL(x) epee::critical_region_t<decltype(x)>   critical_region_var(x)
@@ -217,6 +346,9 @@ namespace epee
 
 #define  CRITICAL_REGION_END() }
 
+#define  SHARED_CRITICAL_REGION_LOCAL(x) epee::shared_critical_region_t<decltype(x)>   critical_region_var(x)
+#define  SHARED_CRITICAL_REGION_LOCAL1(x) epee::shared_critical_region_t<decltype(x)>   critical_region_var1(x)
+
 
 #if defined(WINDWOS_PLATFORM)
   inline const char* get_wait_for_result_as_text(DWORD res)
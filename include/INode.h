@@ -40,6 +40,9 @@ struct BlockCompleteEntry {
   crypto::hash blockHash;
   cryptonote::blobdata block;
   std::list<cryptonote::blobdata> txs;
+  // Global indexes of the outputs of the miner transaction and then of txs. Empty if the node did not send them,
+  // then they are requested with getTransactionOutsGlobalIndices.
+  std::vector<uint64_t> globalOutputIndexes;
 };
 
 class INode {
@@ -39,9 +39,17 @@ extern "C"
 #define ALIGN
 #endif
 
+// State and keys are passed in as __m128i and byte buffers, words are read and written through a type that may
+// alias them. Otherwise the optimizer is free to reorder these accesses and the rounds compute garbage.
+#if defined(__GNUC__)
+typedef uint32_t __attribute__((__may_alias__)) aesb_word;
+#else
+typedef uint32_t aesb_word;
+#endif
+
 #define rf1(r,c) (r)
-#define word_in(x,c) (*((uint32_t*)(x)+(c)))
-#define word_out(x,c,v) (*((uint32_t*)(x)+(c)) = (v))
+#define word_in(x,c) (*((aesb_word*)(x)+(c)))
+#define word_out(x,c,v) (*((aesb_word*)(x)+(c)) = (v))
 
 #define s(x,c) x[c]
 #define si(y,x,c) (s(y,c) = word_in(x, c))
@@ -143,7 +151,7 @@ d_4(uint32_t, t_dec(f,n), sb_data, u0, u1, u2, u3);
 void aesb_single_round(const uint8_t *in, uint8_t *out, uint8_t *expandedKey)
 {
     uint32_t b0[4], b1[4];
-    const uint32_t  *kp = (uint32_t *) expandedKey;
+    const aesb_word *kp = (aesb_word *) expandedKey;
     state_in(b0, in);
 
     round(fwd_rnd,  b1, b0, kp);
@@ -154,7 +162,7 @@ void aesb_single_round(const uint8_t *in, uint8_t *out, uint8_t *expandedKey)
 void aesb_pseudo_round(const uint8_t *in, uint8_t *out, uint8_t *expandedKey)
 {
     uint32_t b0[4], b1[4];
-    const uint32_t  *kp = (uint32_t *) expandedKey;
+    const aesb_word *kp = (aesb_word *) expandedKey;
     state_in(b0, in);
 
     round(fwd_rnd,  b1, b0, kp);
@@ -52,6 +52,11 @@ namespace crypto {
     memcpy(&key, &pwd_hash, sizeof(key));
     memset(&pwd_hash, 0, sizeof(pwd_hash));
   }
+
+  inline void generate_chacha8_key(std::string password, chacha_key& key) {
+    crypto::pooled_cn_context context;
+    generate_chacha8_key(context, password, key);
+  }
 }
 
 #endif
@@ -58,6 +58,9 @@ enum {
 void cn_fast_hash(const void *data, size_t length, char *hash);
 
 void cn_slow_hash_f(void *, const void *, size_t, void *);
+// Several hashes of inputs of the same length at once, each context is a separate scratchpad.
+void cn_slow_hash_2_f(void *const *contexts, const void *const *data, size_t length, void *const *hashes);
+void cn_slow_hash_4_f(void *const *contexts, const void *const *data, size_t length, void *const *hashes);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <memory>
 
 #include "common/pod-class.h"
 #include "generic-ops.h"
@@ -51,13 +52,60 @@ namespace crypto {
   private:
 
     void *data;
+    std::size_t size;
     friend inline void cn_slow_hash(cn_context &, const void *, std::size_t, hash &);
+    friend inline void cn_slow_hash_2(cn_context *const *, const void *const *, std::size_t, hash *);
+    friend inline void cn_slow_hash_4(cn_context *const *, const void *const *, std::size_t, hash *);
+  };
+
+  /*
+    Process-wide cache of slow hash contexts. Creating a context maps and faults in more than 2 MiB, so the miner,
+    block validation and key derivation borrow one through pooled_cn_context instead of making their own.
+  */
+  class cn_context_pool {
+  public:
+    static std::unique_ptr<cn_context> acquire();
+    static void release(std::unique_ptr<cn_context> &&context);
+    static std::size_t idle();
+  };
+
+  class pooled_cn_context {
+  public:
+    pooled_cn_context() : context(cn_context_pool::acquire()) {}
+    ~pooled_cn_context() { cn_context_pool::release(std::move(context)); }
+#if !defined(_MSC_VER) || _MSC_VER >= 1800
+    pooled_cn_context(const pooled_cn_context &) = delete;
+    void operator=(const pooled_cn_context &) = delete;
+#endif
+
+    cn_context &get() { return *context; }
+    operator cn_context &() { return *context; }
+
+  private:
+    std::unique_ptr<cn_context> context;
   };
 
   inline void cn_slow_hash(cn_context &context, const void *data, std::size_t length, hash &hash) {
     (*cn_slow_hash_f)(context.data, data, length, reinterpret_cast<void *>(&hash));
   }
 
+  /*
+    Interleaved variants: hash 2 or 4 inputs of the same length, each on its own context.
+    hashes[i] is exactly what cn_slow_hash would return for data[i].
+  */
+
+  inline void cn_slow_hash_2(cn_context *const *contexts, const void *const *data, std::size_t length, hash *hashes) {
+    void *scratchpads[2] = { contexts[0]->data, contexts[1]->data };
+    void *results[2] = { &hashes[0], &hashes[1] };
+    cn_slow_hash_2_f(scratchpads, data, length, results);
+  }
+
+  inline void cn_slow_hash_4(cn_context *const *contexts, const void *const *data, std::size_t length, hash *hashes) {
+    void *scratchpads[4] = { contexts[0]->data, contexts[1]->data, contexts[2]->data, contexts[3]->data };
+    void *results[4] = { &hashes[0], &hashes[1], &hashes[2], &hashes[3] };
+    cn_slow_hash_4_f(scratchpads, data, length, results);
+  }
+
   inline void tree_hash(const hash *hashes, std::size_t count, hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
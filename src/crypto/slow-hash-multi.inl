@@ -0,0 +1,192 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// CN_SLOW_HASH_WAYS hashes of equal length computed together, each on its own scratchpad. Every step is done for
+// all of them before the next one starts, so the random scratchpad accesses of one hash overlap the arithmetic of
+// the others. Results are identical to cn_slow_hash_aesni/cn_slow_hash_noaesni on every input.
+static void
+CN_SLOW_HASH_MULTI
+(void *const *contexts, const void *const *data, size_t length, void *const *hashes)
+{
+  struct cn_ctx *cns[CN_SLOW_HASH_WAYS];
+  ALIGNED_DECL(uint8_t ExpandedKey[CN_SLOW_HASH_WAYS][256], 16);
+  size_t i, j, k;
+  __m128i *longoutput[CN_SLOW_HASH_WAYS], *expkey[CN_SLOW_HASH_WAYS], *xmminput[CN_SLOW_HASH_WAYS], b_x[CN_SLOW_HASH_WAYS];
+  ALIGNED_DECL(uint64_t a[CN_SLOW_HASH_WAYS][2], 16);
+
+  for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+  {
+    cns[k] = (struct cn_ctx *) contexts[k];
+    hash_process(&cns[k]->state.hs, (const uint8_t*) data[k], length);
+
+    memcpy(cns[k]->text, cns[k]->state.init, INIT_SIZE_BYTE);
+#if defined(AESNI)
+    memcpy(ExpandedKey[k], cns[k]->state.hs.b, AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[k]);
+#else
+    cns[k]->aes_ctx = oaes_alloc();
+    oaes_key_import_data(cns[k]->aes_ctx, cns[k]->state.hs.b, AES_KEY_SIZE);
+    memcpy(ExpandedKey[k], cns[k]->aes_ctx->key->exp_data, cns[k]->aes_ctx->key->exp_data_len);
+#endif
+
+    longoutput[k] = (__m128i *) cns[k]->long_state;
+    expkey[k] = (__m128i *) ExpandedKey[k];
+    xmminput[k] = (__m128i *) cns[k]->text;
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+    {
+#if defined(AESNI)
+      for(j = 0; j < 10; j++)
+      {
+        xmminput[k][0] = _mm_aesenc_si128(xmminput[k][0], expkey[k][j]);
+        xmminput[k][1] = _mm_aesenc_si128(xmminput[k][1], expkey[k][j]);
+        xmminput[k][2] = _mm_aesenc_si128(xmminput[k][2], expkey[k][j]);
+        xmminput[k][3] = _mm_aesenc_si128(xmminput[k][3], expkey[k][j]);
+        xmminput[k][4] = _mm_aesenc_si128(xmminput[k][4], expkey[k][j]);
+        xmminput[k][5] = _mm_aesenc_si128(xmminput[k][5], expkey[k][j]);
+        xmminput[k][6] = _mm_aesenc_si128(xmminput[k][6], expkey[k][j]);
+        xmminput[k][7] = _mm_aesenc_si128(xmminput[k][7], expkey[k][j]);
+      }
+#else
+      for(j = 0; j < 8; j++)
+      {
+        aesb_pseudo_round((uint8_t *) &xmminput[k][j], (uint8_t *) &xmminput[k][j], (uint8_t *) expkey[k]);
+      }
+#endif
+      for(j = 0; j < 8; j++)
+      {
+        _mm_store_si128(&(longoutput[k][(i >> 4) + j]), xmminput[k][j]);
+      }
+    }
+  }
+
+  for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      cns[k]->a[i] = ((uint64_t *)cns[k]->state.k)[i] ^  ((uint64_t *)cns[k]->state.k)[i+4];
+      cns[k]->b[i] = ((uint64_t *)cns[k]->state.k)[i+2] ^  ((uint64_t *)cns[k]->state.k)[i+6];
+    }
+
+    b_x[k] = _mm_load_si128((__m128i *)cns[k]->b);
+    a[k][0] = cns[k]->a[0];
+    a[k][1] = cns[k]->a[1];
+  }
+
+  for(i = 0; likely(i < 0x80000); i++)
+  {
+    __m128i c_x[CN_SLOW_HASH_WAYS];
+    ALIGNED_DECL(uint64_t c[CN_SLOW_HASH_WAYS][2], 16);
+
+    // first half of the step for every hash: the AES round, then prefetch the block the second half reads
+    for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+    {
+      __m128i a_x = _mm_load_si128((__m128i *)a[k]);
+      c_x[k] = _mm_load_si128((__m128i *)&cns[k]->long_state[a[k][0] & 0x1FFFF0]);
+
+#if defined(AESNI)
+      c_x[k] = _mm_aesenc_si128(c_x[k], a_x);
+#else
+      aesb_single_round((uint8_t *) &c_x[k], (uint8_t *) &c_x[k], (uint8_t *) &a_x);
+#endif
+
+      _mm_store_si128((__m128i *)c[k], c_x[k]);
+      _mm_prefetch((const char *)&cns[k]->long_state[c[k][0] & 0x1FFFF0], _MM_HINT_T0);
+
+      b_x[k] = _mm_xor_si128(b_x[k], c_x[k]);
+      _mm_store_si128((__m128i *)&cns[k]->long_state[a[k][0] & 0x1FFFF0], b_x[k]);
+    }
+
+    // second half: multiply with the prefetched block and write it back
+    for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+    {
+      ALIGNED_DECL(uint64_t b[2], 16);
+      uint64_t *nextblock, *dst;
+      uint64_t hi, lo;
+
+      nextblock = (uint64_t *)&cns[k]->long_state[c[k][0] & 0x1FFFF0];
+      b[0] = nextblock[0];
+      b[1] = nextblock[1];
+
+#if defined(__GNUC__) && defined(__x86_64__)
+      __asm__("mulq %3\n\t"
+        : "=d" (hi),
+        "=a" (lo)
+        : "%a" (c[k][0]),
+        "rm" (b[0])
+        : "cc" );
+#else
+      lo = mul128(c[k][0], b[0], &hi);
+#endif
+
+      a[k][0] += hi;
+      a[k][1] += lo;
+
+      dst = (uint64_t *) &cns[k]->long_state[c[k][0] & 0x1FFFF0];
+      dst[0] = a[k][0];
+      dst[1] = a[k][1];
+
+      a[k][0] ^= b[0];
+      a[k][1] ^= b[1];
+      b_x[k] = c_x[k];
+    }
+  }
+
+  for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+  {
+    memcpy(cns[k]->text, cns[k]->state.init, INIT_SIZE_BYTE);
+#if defined(AESNI)
+    memcpy(ExpandedKey[k], &cns[k]->state.hs.b[32], AES_KEY_SIZE);
+    ExpandAESKey256(ExpandedKey[k]);
+#else
+    oaes_key_import_data(cns[k]->aes_ctx, &cns[k]->state.hs.b[32], AES_KEY_SIZE);
+    memcpy(ExpandedKey[k], cns[k]->aes_ctx->key->exp_data, cns[k]->aes_ctx->key->exp_data_len);
+#endif
+  }
+
+  for (i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE)
+  {
+    for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+    {
+      for(j = 0; j < 8; j++)
+      {
+        xmminput[k][j] = _mm_xor_si128(longoutput[k][(i >> 4) + j], xmminput[k][j]);
+      }
+
+#if defined(AESNI)
+      for(j = 0; j < 10; j++)
+      {
+        xmminput[k][0] = _mm_aesenc_si128(xmminput[k][0], expkey[k][j]);
+        xmminput[k][1] = _mm_aesenc_si128(xmminput[k][1], expkey[k][j]);
+        xmminput[k][2] = _mm_aesenc_si128(xmminput[k][2], expkey[k][j]);
+        xmminput[k][3] = _mm_aesenc_si128(xmminput[k][3], expkey[k][j]);
+        xmminput[k][4] = _mm_aesenc_si128(xmminput[k][4], expkey[k][j]);
+        xmminput[k][5] = _mm_aesenc_si128(xmminput[k][5], expkey[k][j]);
+        xmminput[k][6] = _mm_aesenc_si128(xmminput[k][6], expkey[k][j]);
+        xmminput[k][7] = _mm_aesenc_si128(xmminput[k][7], expkey[k][j]);
+      }
+#else
+      for(j = 0; j < 8; j++)
+      {
+        aesb_pseudo_round((uint8_t *) &xmminput[k][j], (uint8_t *) &xmminput[k][j], (uint8_t *) expkey[k]);
+      }
+#endif
+    }
+  }
+
+  for (k = 0; k < CN_SLOW_HASH_WAYS; k++)
+  {
+#if !defined(AESNI)
+    oaes_free((OAES_CTX **) &cns[k]->aes_ctx);
+#endif
+
+    memcpy(cns[k]->state.init, cns[k]->text, INIT_SIZE_BYTE);
+    hash_permutation(&cns[k]->state.hs);
+    extra_hashes[cns[k]->state.hs.b[0] & 3](&cns[k]->state, 200, hashes[k]);
+  }
+}
@@ -28,6 +28,17 @@ void cn_slow_hash_f(void * a, const void * b, size_t c, void * d){
 (*cn_slow_hash_fp)(a, b, c, d);
 }
 
+void (*cn_slow_hash_2_fp)(void *const *, const void *const *, size_t, void *const *);
+void (*cn_slow_hash_4_fp)(void *const *, const void *const *, size_t, void *const *);
+
+void cn_slow_hash_2_f(void *const *contexts, const void *const *data, size_t length, void *const *hashes) {
+  (*cn_slow_hash_2_fp)(contexts, data, length, hashes);
+}
+
+void cn_slow_hash_4_f(void *const *contexts, const void *const *data, size_t length, void *const *hashes) {
+  (*cn_slow_hash_4_fp)(contexts, data, length, hashes);
+}
+
 #if defined(__GNUC__)
 #define likely(x) (__builtin_expect(!!(x), 1))
 #define unlikely(x) (__builtin_expect(!!(x), 0))
@@ -164,8 +175,29 @@ static void (*const extra_hashes[4])(const void *, size_t, char *) =
 };
 
 #include "slow-hash.inl"
+#define CN_SLOW_HASH_WAYS 2
+#define CN_SLOW_HASH_MULTI cn_slow_hash_2_noaesni
+#include "slow-hash-multi.inl"
+#undef CN_SLOW_HASH_WAYS
+#undef CN_SLOW_HASH_MULTI
+#define CN_SLOW_HASH_WAYS 4
+#define CN_SLOW_HASH_MULTI cn_slow_hash_4_noaesni
+#include "slow-hash-multi.inl"
+#undef CN_SLOW_HASH_WAYS
+#undef CN_SLOW_HASH_MULTI
+
 #define AESNI
 #include "slow-hash.inl"
+#define CN_SLOW_HASH_WAYS 2
+#define CN_SLOW_HASH_MULTI cn_slow_hash_2_aesni
+#include "slow-hash-multi.inl"
+#undef CN_SLOW_HASH_WAYS
+#undef CN_SLOW_HASH_MULTI
+#define CN_SLOW_HASH_WAYS 4
+#define CN_SLOW_HASH_MULTI cn_slow_hash_4_aesni
+#include "slow-hash-multi.inl"
+#undef CN_SLOW_HASH_WAYS
+#undef CN_SLOW_HASH_MULTI
 
 INITIALIZER(detect_aes) {
   int ecx;
@@ -177,5 +209,13 @@ INITIALIZER(detect_aes) {
   int a, b, d;
   __cpuid(1, a, b, ecx, d);
 #endif
-  cn_slow_hash_fp = (ecx & (1 << 25)) ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+  if (ecx & (1 << 25)) {
+    cn_slow_hash_fp = &cn_slow_hash_aesni;
+    cn_slow_hash_2_fp = &cn_slow_hash_2_aesni;
+    cn_slow_hash_4_fp = &cn_slow_hash_4_aesni;
+  } else {
+    cn_slow_hash_fp = &cn_slow_hash_noaesni;
+    cn_slow_hash_2_fp = &cn_slow_hash_2_noaesni;
+    cn_slow_hash_4_fp = &cn_slow_hash_4_noaesni;
+  }
 }
@@ -3,7 +3,14 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <new>
+#include <thread>
+#include <vector>
 
 #include "hash.h"
 
@@ -18,12 +25,27 @@ using std::bad_alloc;
 namespace crypto {
 
   enum {
-    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff)
+    MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff),
+    HUGE_PAGE_SIZE = 1 << 21
   };
 
+  // The scratchpad is hit at random all over its 2 MiB, with 4 KiB pages nearly every access misses the TLB.
+  // Contexts are therefore placed on huge pages whenever the system lets us, and on normal pages otherwise.
+
 #if defined(WIN32)
 
   cn_context::cn_context() {
+    SIZE_T largePage = GetLargePageMinimum();
+    if (largePage != 0) {
+      size = (MAP_SIZE + largePage - 1) & ~(largePage - 1);
+      // fails without SeLockMemoryPrivilege, which is the common case
+      data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+      if (data != nullptr) {
+        return;
+      }
+    }
+
+    size = MAP_SIZE;
     data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
     if (data == nullptr) {
       throw bad_alloc();
@@ -38,24 +60,133 @@ namespace crypto {
 
 #else
 
-  cn_context::cn_context() {
+  namespace {
+
+#if defined(MAP_HUGETLB)
+    // Explicit huge pages, only available when the administrator reserved some (vm.nr_hugepages).
+    void* mapHugeTlb(std::size_t& size) {
+      std::size_t hugeSize = (MAP_SIZE + HUGE_PAGE_SIZE - 1) & ~static_cast<std::size_t>(HUGE_PAGE_SIZE - 1);
+      void* p = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+      if (p == MAP_FAILED) {
+        return nullptr;
+      }
+
+      size = hugeSize;
+      return p;
+    }
+#endif
+
+#if defined(MADV_HUGEPAGE)
+    // Transparent huge pages: the scratchpad starts on a huge page boundary so the kernel can back it with one huge
+    // page, the few hundred bytes of state after it stay on a normal page.
+    void* mapTransparentHuge(std::size_t& size) {
+      std::size_t reserved = MAP_SIZE + HUGE_PAGE_SIZE;
+      char* p = static_cast<char*>(mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+      if (p == MAP_FAILED) {
+        return nullptr;
+      }
+
+      char* aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + HUGE_PAGE_SIZE - 1) & ~static_cast<std::uintptr_t>(HUGE_PAGE_SIZE - 1));
+      if (aligned != p) {
+        munmap(p, aligned - p);
+      }
+
+      std::size_t tail = (p + reserved) - (aligned + MAP_SIZE);
+      if (tail != 0) {
+        munmap(aligned + MAP_SIZE, tail);
+      }
+
+      if (madvise(aligned, MAP_SIZE, MADV_HUGEPAGE) != 0) {
+        munmap(aligned, MAP_SIZE);
+        return nullptr;
+      }
+
+      // fault the pages in now, after the advice, so they are not populated as 4 KiB pages
+      std::memset(aligned, 0, MAP_SIZE);
+      size = MAP_SIZE;
+      return aligned;
+    }
+#endif
+
+    void* mapSmall(std::size_t& size) {
 #if !defined(__APPLE__)
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      void* p = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
 #else
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+      void* p = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
 #endif
-    if (data == MAP_FAILED) {
+      if (p == MAP_FAILED) {
+        return nullptr;
+      }
+
+      size = MAP_SIZE;
+      return p;
+    }
+  }
+
+  cn_context::cn_context() : data(nullptr), size(0) {
+#if defined(MAP_HUGETLB)
+    data = mapHugeTlb(size);
+#endif
+#if defined(MADV_HUGEPAGE)
+    if (data == nullptr) {
+      data = mapTransparentHuge(size);
+    }
+#endif
+    if (data == nullptr) {
+      data = mapSmall(size);
+    }
+
+    if (data == nullptr) {
       throw bad_alloc();
     }
-    mlock(data, MAP_SIZE);
+    mlock(data, size);
   }
 
   cn_context::~cn_context() {
-    if (munmap(data, MAP_SIZE) != 0) {
+    if (munmap(data, size) != 0) {
       throw bad_alloc();
     }
   }
 
 #endif
 
+  namespace {
+    std::mutex poolMutex;
+    std::vector<std::unique_ptr<cn_context>> poolContexts;
+
+    std::size_t maxIdleContexts() {
+      return std::max<std::size_t>(4, 2 * std::thread::hardware_concurrency());
+    }
+  }
+
+  std::unique_ptr<cn_context> cn_context_pool::acquire() {
+    {
+      std::lock_guard<std::mutex> lock(poolMutex);
+      if (!poolContexts.empty()) {
+        std::unique_ptr<cn_context> context = std::move(poolContexts.back());
+        poolContexts.pop_back();
+        return context;
+      }
+    }
+
+    return std::unique_ptr<cn_context>(new cn_context());
+  }
+
+  void cn_context_pool::release(std::unique_ptr<cn_context>&& context) {
+    std::unique_ptr<cn_context> released = std::move(context);
+    if (!released) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (poolContexts.size() < maxIdleContexts()) {
+      poolContexts.push_back(std::move(released));
+    }
+  }
+
+  std::size_t cn_context_pool::idle() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return poolContexts.size();
+  }
+
 }
@@ -68,6 +68,9 @@ static_assert(UPGRADE_VOTING_WINDOW > 1, "Bad UPGRADE_VOTING_WINDOW");
 const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[]             = "blockscache.dat";
+const char     CRYPTONOTE_KEYIMAGES_FILENAME[]               = "keyimages.dat";
+const char     CRYPTONOTE_TXINDEX_FILENAME[]                 = "txindex.dat";
+const char     CRYPTONOTE_BLOCKHEADERS_FILENAME[]            = "blockheaders.dat";
 const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
 const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
 const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json";
@@ -90,7 +93,14 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  200;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MAX_REQUESTS             =  3;      //requests for blocks in flight on one connection
+const size_t   BLOCKS_SYNCHRONIZING_QUEUE_SIZE               =  2000;   //blocks requested or waiting for validation, all connections together
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
+const size_t   BLOCKCHAIN_STORAGE_CACHE_SIZE                 =  64 * 1024 * 1024; //bytes of serialized blocks kept deserialized in memory
+const size_t   RAW_BLOCKS_CACHE_DEPTH                        =  100; //blocks below the chain tip kept as ready blobs for wallet synchronization requests
+const unsigned BLOCKCHAIN_CACHE_STORE_INTERVAL               =  60 * 10; //seconds between blockchain cache checkpoints
+const size_t   BLOCKCHAIN_CHECKPOINT_ZONE_INDEX_BATCH        =  1000; //blocks whose index entries are written at once below the last checkpoint
+const size_t   RING_SIGNATURE_CACHE_SIZE                     =  100000; //ring signatures remembered as valid, shared by the pool and block validation
 
 const int      P2P_DEFAULT_PORT                              = 42080;
 const int      RPC_DEFAULT_PORT                              = 42081;
@@ -108,6 +118,12 @@ const uint64_t P2P_DEFAULT_INVOKE_TIMEOUT                    = 60 * 2 * 1000; //
 const size_t   P2P_DEFAULT_HANDSHAKE_INVOKE_TIMEOUT          = 5000;          // 5 seconds
 const char     P2P_STAT_TRUSTED_PUB_KEY[]                    = "85ae8734f90bc1ee295ceb0ec05a49852d4dbbc9d1c27a619b5f4bdf26a0196e";
 const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT     = 70;
+const size_t   P2P_TX_INVENTORY_KNOWN_LIMIT                  = 5000;          // transaction ids remembered per peer as known to it, in each of two generations
+const size_t   P2P_TX_INVENTORY_MAX_COUNT                    = 5000;          // transaction ids in one announcement or request
+const uint32_t P2P_TX_REQUEST_TIMEOUT                        = 30;            // seconds before a requested transaction is requested from the next peer that announced it
+const size_t   P2P_SYNC_PEER_SCORES_LIMIT                    = 1000;          // disconnected peers whose block download measurements are remembered
+const uint32_t P2P_SYNC_STALL_TIMEOUT                        = 15;            // seconds a synchronizing peer may hold back the next block of the chain before it is dropped
+const size_t   P2P_SYNC_SERVE_QUEUE_LIMIT                    = 8 * 1024 * 1024; // bytes queued to a peer above which its block requests wait for the queue to go down
 
 const unsigned THREAD_STACK_SIZE                             = 5 * 1024 * 1024;
 
@@ -0,0 +1,250 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockEntryBlob.h"
+
+#include <cstdint>
+
+#include "cryptonote_config.h"
+
+namespace cryptonote {
+
+namespace {
+
+// binary_archive variant tags, see cryptonote_basic.h
+const uint8_t INPUT_GENERATE_TAG = 0xff;
+const uint8_t INPUT_TO_KEY_TAG = 0x2;
+const uint8_t INPUT_MULTISIGNATURE_TAG = 0x3;
+const uint8_t OUTPUT_TO_KEY_TAG = 0x2;
+const uint8_t OUTPUT_MULTISIGNATURE_TAG = 0x3;
+
+const size_t HASH_SIZE = 32;
+const size_t KEY_SIZE = 32;
+const size_t SIGNATURE_SIZE = 64;
+const size_t MAX_VARINT_SIZE = 10;
+
+class BlobReader {
+public:
+  BlobReader(const char* data, size_t size) : m_position(data), m_end(data + size) {
+  }
+
+  const char* position() const {
+    return m_position;
+  }
+
+  bool atEnd() const {
+    return m_position == m_end;
+  }
+
+  bool readByte(uint8_t& value) {
+    if (m_position == m_end) {
+      return false;
+    }
+
+    value = static_cast<uint8_t>(*m_position++);
+    return true;
+  }
+
+  bool readVarint(uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < MAX_VARINT_SIZE; ++i) {
+      uint8_t byte;
+      if (!readByte(byte)) {
+        return false;
+      }
+
+      value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool skipVarint() {
+    uint64_t value;
+    return readVarint(value);
+  }
+
+  bool skipVarints(uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+      if (!skipVarint()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool skip(uint64_t count) {
+    if (count > static_cast<uint64_t>(m_end - m_position)) {
+      return false;
+    }
+
+    m_position += count;
+    return true;
+  }
+
+  // skip(count * itemSize) without overflowing on corrupt counts
+  bool skipItems(uint64_t count, size_t itemSize) {
+    if (count > static_cast<uint64_t>(m_end - m_position) / itemSize) {
+      return false;
+    }
+
+    m_position += count * itemSize;
+    return true;
+  }
+
+private:
+  const char* m_position;
+  const char* m_end;
+};
+
+bool skipTransaction(BlobReader& reader) {
+  uint64_t version;
+  if (!reader.readVarint(version) || version > TRANSACTION_VERSION_2 || !reader.skipVarint()) {
+    return false;
+  }
+
+  uint64_t inputCount;
+  if (!reader.readVarint(inputCount)) {
+    return false;
+  }
+
+  uint64_t signatureCount = 0;
+  for (uint64_t i = 0; i < inputCount; ++i) {
+    uint8_t tag;
+    if (!reader.readByte(tag)) {
+      return false;
+    }
+
+    if (tag == INPUT_GENERATE_TAG) {
+      if (!reader.skipVarint()) {
+        return false;
+      }
+    } else if (tag == INPUT_TO_KEY_TAG) {
+      uint64_t offsetCount;
+      if (!reader.skipVarint() || !reader.readVarint(offsetCount) || !reader.skipVarints(offsetCount) || !reader.skip(KEY_SIZE)) {
+        return false;
+      }
+
+      signatureCount += offsetCount;
+    } else if (tag == INPUT_MULTISIGNATURE_TAG) {
+      uint64_t signatures;
+      if (!reader.skipVarint() || !reader.readVarint(signatures) || !reader.skipVarints(2)) {
+        return false;
+      }
+
+      signatureCount += signatures;
+    } else {
+      return false;
+    }
+  }
+
+  uint64_t outputCount;
+  if (!reader.readVarint(outputCount)) {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < outputCount; ++i) {
+    uint8_t tag;
+    if (!reader.skipVarint() || !reader.readByte(tag)) {
+      return false;
+    }
+
+    if (tag == OUTPUT_TO_KEY_TAG) {
+      if (!reader.skip(KEY_SIZE)) {
+        return false;
+      }
+    } else if (tag == OUTPUT_MULTISIGNATURE_TAG) {
+      uint64_t keyCount;
+      if (!reader.readVarint(keyCount) || !reader.skipItems(keyCount, KEY_SIZE) || !reader.skipVarints(2)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  uint64_t extraSize;
+  if (!reader.readVarint(extraSize) || !reader.skip(extraSize)) {
+    return false;
+  }
+
+  // signatures are written back to back, their count follows from the inputs
+  return reader.skipItems(signatureCount, SIGNATURE_SIZE);
+}
+
+bool skipBlock(BlobReader& reader) {
+  uint64_t majorVersion;
+  if (!reader.readVarint(majorVersion) || majorVersion > BLOCK_MAJOR_VERSION_2) {
+    return false;
+  }
+
+  // minor version, timestamp, previous block id, nonce
+  if (!reader.skipVarints(2) || !reader.skip(HASH_SIZE + sizeof(uint32_t)) || !skipTransaction(reader)) {
+    return false;
+  }
+
+  uint64_t hashCount;
+  return reader.readVarint(hashCount) && reader.skipItems(hashCount, HASH_SIZE);
+}
+
+}
+
+bool splitBlockEntryBlob(const char* data, size_t size, blobdata& block, std::list<blobdata>& txs, std::vector<uint64_t>& globalOutputIndexes) {
+  BlobReader reader(data, size);
+  if (!skipBlock(reader)) {
+    return false;
+  }
+
+  const char* blockEnd = reader.position();
+
+  // height, cumulative size, cumulative difficulty, already generated coins
+  uint64_t transactionCount;
+  if (!reader.skipVarints(4) || !reader.readVarint(transactionCount) || transactionCount == 0) {
+    return false;
+  }
+
+  std::list<blobdata> transactions;
+  std::vector<uint64_t> indexes;
+  for (uint64_t i = 0; i < transactionCount; ++i) {
+    const char* transactionBegin = reader.position();
+    if (!skipTransaction(reader)) {
+      return false;
+    }
+
+    // the first one is the miner transaction, already in the block blob
+    if (i != 0) {
+      transactions.emplace_back(transactionBegin, reader.position());
+    }
+
+    uint64_t indexCount;
+    if (!reader.readVarint(indexCount)) {
+      return false;
+    }
+
+    for (uint64_t j = 0; j < indexCount; ++j) {
+      uint64_t index;
+      if (!reader.readVarint(index)) {
+        return false;
+      }
+
+      indexes.push_back(index);
+    }
+  }
+
+  if (!reader.atEnd()) {
+    return false;
+  }
+
+  block.assign(data, blockEnd);
+  txs.splice(txs.end(), transactions);
+  globalOutputIndexes.insert(globalOutputIndexes.end(), indexes.begin(), indexes.end());
+  return true;
+}
+
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "cryptonote_protocol/blobdatatype.h"
+
+namespace cryptonote {
+
+// Cuts the block blob and the blobs of its transactions out of a serialized blockchain_storage::BlockEntry (block,
+// height, cumulative size and difficulty, generated coins, transactions with their global output indexes) by walking
+// the binary format instead of deserializing it. The blobs are byte for byte what block_to_blob and tx_to_blob
+// return for the stored objects. The miner transaction is part of the block blob and is not added to txs, as in
+// block_complete_entry. The global output indexes of the miner transaction and then of txs, one per output, are
+// appended to globalOutputIndexes. Returns false if the data is not a well-formed block entry.
+bool splitBlockEntryBlob(const char* data, size_t size, blobdata& block, std::list<blobdata>& txs, std::vector<uint64_t>& globalOutputIndexes);
+
+}
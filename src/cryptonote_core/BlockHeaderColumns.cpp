@@ -0,0 +1,124 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockHeaderColumns.h"
+
+#include <cstring>
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace cryptonote {
+
+namespace {
+
+const char FILE_SIGNATURE[8] = { 'B', 'L', 'K', 'H', 'E', 'A', 'D', 'S' };
+const uint32_t FILE_VERSION = 1;
+
+// Followed by the timestamps, cumulative difficulties, cumulative sizes, major and minor versions, all in native
+// byte order.
+struct FileHeader {
+  char signature[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t height;
+  crypto::hash lastBlockHash;
+};
+
+const size_t BYTES_PER_BLOCK = sizeof(uint64_t) + sizeof(difficulty_type) + sizeof(uint64_t) + 2 * sizeof(uint8_t);
+
+template<typename T> void writeColumn(std::ofstream& file, const std::vector<T>& column) {
+  file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+template<typename T> const char* readColumn(const char* data, size_t count, std::vector<T>& column) {
+  column.resize(count);
+  memcpy(column.data(), data, count * sizeof(T));
+  return data + count * sizeof(T);
+}
+
+}
+
+void BlockHeaderColumns::push(uint64_t timestamp, difficulty_type cumulativeDifficulty, uint64_t cumulativeSize, uint8_t majorVersion, uint8_t minorVersion) {
+  m_timestamps.push_back(timestamp);
+  m_cumulativeDifficulties.push_back(cumulativeDifficulty);
+  m_cumulativeSizes.push_back(cumulativeSize);
+  m_majorVersions.push_back(majorVersion);
+  m_minorVersions.push_back(minorVersion);
+}
+
+void BlockHeaderColumns::pop() {
+  m_timestamps.pop_back();
+  m_cumulativeDifficulties.pop_back();
+  m_cumulativeSizes.pop_back();
+  m_majorVersions.pop_back();
+  m_minorVersions.pop_back();
+}
+
+void BlockHeaderColumns::clear() {
+  m_timestamps.clear();
+  m_cumulativeDifficulties.clear();
+  m_cumulativeSizes.clear();
+  m_majorVersions.clear();
+  m_minorVersions.clear();
+}
+
+bool BlockHeaderColumns::save(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) const {
+  std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.signature, FILE_SIGNATURE, sizeof(header.signature));
+  header.version = FILE_VERSION;
+  header.height = height;
+  header.lastBlockHash = lastBlockHash;
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  writeColumn(file, m_timestamps);
+  writeColumn(file, m_cumulativeDifficulties);
+  writeColumn(file, m_cumulativeSizes);
+  writeColumn(file, m_majorVersions);
+  writeColumn(file, m_minorVersions);
+  file.flush();
+  return file.good();
+}
+
+bool BlockHeaderColumns::load(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) {
+  try {
+    boost::interprocess::file_mapping file(fileName.c_str(), boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+    const char* data = static_cast<const char*>(region.get_address());
+    size_t fileSize = region.get_size();
+
+    FileHeader header;
+    if (fileSize < sizeof(header)) {
+      return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.signature, FILE_SIGNATURE, sizeof(header.signature)) != 0 || header.version != FILE_VERSION ||
+      header.height != height || header.lastBlockHash != lastBlockHash || fileSize != sizeof(header) + height * BYTES_PER_BLOCK) {
+      return false;
+    }
+
+    size_t count = static_cast<size_t>(height);
+    data += sizeof(header);
+    data = readColumn(data, count, m_timestamps);
+    data = readColumn(data, count, m_cumulativeDifficulties);
+    data = readColumn(data, count, m_cumulativeSizes);
+    data = readColumn(data, count, m_majorVersions);
+    readColumn(data, count, m_minorVersions);
+  } catch (std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/difficulty.h"
+#include "cryptonote_core/UpgradeDetector.h"
+
+namespace cryptonote {
+
+// Header fields of the main chain blocks by height, one array per field, so that difficulty, timestamp, block size
+// and upgrade voting checks scan arrays instead of deserializing blocks. A block takes 26 bytes.
+//
+// Readers may run concurrently, modifications must be serialized by the owner.
+class BlockHeaderColumns {
+public:
+  void push(uint64_t timestamp, difficulty_type cumulativeDifficulty, uint64_t cumulativeSize, uint8_t majorVersion, uint8_t minorVersion);
+  void pop();
+  void clear();
+
+  size_t size() const { return m_timestamps.size(); }
+  bool empty() const { return m_timestamps.empty(); }
+
+  const std::vector<uint64_t>& timestamps() const { return m_timestamps; }
+  const std::vector<difficulty_type>& cumulativeDifficulties() const { return m_cumulativeDifficulties; }
+  const std::vector<uint64_t>& cumulativeSizes() const { return m_cumulativeSizes; }
+  uint8_t majorVersion(uint64_t height) const { return m_majorVersions[static_cast<size_t>(height)]; }
+  uint8_t minorVersion(uint64_t height) const { return m_minorVersions[static_cast<size_t>(height)]; }
+
+  // The file holds the arrays as they are in memory, loading them is one copy of the mapped file. height and
+  // lastBlockHash identify the chain state the columns describe, load() fails if the file describes another one.
+  bool save(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) const;
+  bool load(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash);
+
+private:
+  std::vector<uint64_t> m_timestamps;
+  std::vector<difficulty_type> m_cumulativeDifficulties;
+  std::vector<uint64_t> m_cumulativeSizes;
+  std::vector<uint8_t> m_majorVersions;
+  std::vector<uint8_t> m_minorVersions;
+};
+
+template<> struct BlockVersionReader<BlockHeaderColumns> {
+  static uint8_t majorVersion(const BlockHeaderColumns& headers, uint64_t height) {
+    return headers.majorVersion(height);
+  }
+
+  static uint8_t minorVersion(const BlockHeaderColumns& headers, uint64_t height) {
+    return headers.minorVersion(height);
+  }
+};
+
+}
@@ -71,5 +71,13 @@ namespace CryptoNote
     return m_container.back();
   }
 
+  void BlockIndex::rebuildIndex() {
+    m_index.clear();
+    m_index.reserve(m_container.size());
+    for (size_t i = 0; i < m_container.size(); ++i) {
+      m_index.insert(static_cast<uint32_t>(i));
+    }
+  }
+
 
 }
@@ -3,43 +3,55 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-// multi index
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/random_access_index.hpp>
+#pragma once
 
-#include "crypto/hash.h"
 #include <list>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_core/FlatHashIndex.h"
 
 namespace CryptoNote
 {
+  // Block hashes by height in a vector, heights by hash in a FlatHashIndex whose entries are the heights alone,
+  // the hash of an entry is read from the vector. A block takes 32 bytes in the vector and 6 bytes per slot of
+  // the index, 39 to 46 bytes in all.
   class BlockIndex {
 
   public:
 
     BlockIndex() : 
-      m_index(m_container.get<1>()) {}
+      m_index(HeightKey(m_container)) {}
+
+    BlockIndex(const BlockIndex& other) :
+      m_container(other.m_container), m_index(other.m_index, HeightKey(m_container)) {}
 
     void pop() {
+      m_index.erase(m_container.back());
       m_container.pop_back();
     }
 
     // returns true if new element was inserted, false if already exists
     bool push(const crypto::hash& h) {
-      auto result = m_container.push_back(h);
-      return result.second;
+      m_container.push_back(h);
+      if (!m_index.insert(static_cast<uint32_t>(m_container.size() - 1))) {
+        m_container.pop_back();
+        return false;
+      }
+
+      return true;
     }
 
     bool hasBlock(const crypto::hash& h) const {
-      return m_index.find(h) != m_index.end();
+      return m_index.find(h) != nullptr;
     }
 
     bool getBlockHeight(const crypto::hash& h, uint64_t& height) const {
-      auto hi = m_index.find(h);
-      if (hi == m_index.end())
+      const uint32_t* entry = m_index.find(h);
+      if (entry == nullptr)
         return false;
 
-      height = std::distance(m_container.begin(), m_container.project<0>(hi));
+      height = *entry;
       return true;
     }
 
@@ -49,6 +61,7 @@ namespace CryptoNote
 
     void clear() {
       m_container.clear();
+      m_index.clear();
     }
 
     crypto::hash getBlockId(uint64_t height) const;
@@ -57,22 +70,31 @@ namespace CryptoNote
     bool getShortChainHistory(std::list<crypto::hash>& ids) const;
     crypto::hash getTailId() const;
 
+    // only the hashes are stored, the index is rebuilt on load
     template <class Archive> void serialize(Archive& ar, const unsigned int version) {
       ar & m_container;
+      if (Archive::is_loading::value) {
+        rebuildIndex();
+      }
     }
 
   private:
 
-    typedef boost::multi_index_container <
-      crypto::hash,
-      boost::multi_index::indexed_by<
-        boost::multi_index::random_access<>,
-        boost::multi_index::hashed_unique<boost::multi_index::identity<crypto::hash>>
-      >
-    > ContainerT;
+    struct HeightKey {
+      explicit HeightKey(const std::vector<crypto::hash>& hashes) : hashes(&hashes) {}
+
+      const crypto::hash& operator()(uint32_t height) const {
+        return (*hashes)[height];
+      }
+
+      const std::vector<crypto::hash>* hashes;
+    };
+
+    std::vector<crypto::hash> m_container;
+    cryptonote::FlatHashIndex<uint32_t, HeightKey> m_index;
 
-    ContainerT m_container;
-    ContainerT::nth_index<1>::type& m_index;
+    BlockIndex& operator=(const BlockIndex&);
 
+    void rebuildIndex();
   };
 }
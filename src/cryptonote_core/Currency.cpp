@@ -31,6 +31,9 @@ namespace cryptonote {
       m_upgradeHeight = 0;
       m_blocksFileName       = "testnet_" + m_blocksFileName;
       m_blocksCacheFileName  = "testnet_" + m_blocksCacheFileName;
+      m_keyImagesFileName    = "testnet_" + m_keyImagesFileName;
+      m_txIndexFileName      = "testnet_" + m_txIndexFileName;
+      m_blockHeadersFileName = "testnet_" + m_blockHeadersFileName;
       m_blockIndexesFileName = "testnet_" + m_blockIndexesFileName;
       m_txPoolFileName       = "testnet_" + m_txPoolFileName;
     }
@@ -178,9 +181,7 @@ namespace cryptonote {
   bool Currency::constructMinerTx(size_t height, size_t medianSize, uint64_t alreadyGeneratedCoins, size_t currentBlockSize,
                                   uint64_t fee, const AccountPublicAddress& minerAddress, Transaction& tx,
                                   const blobdata& extraNonce/* = blobdata()*/, size_t maxOuts/* = 1*/) const {
-      tx.vin.clear();
-      tx.vout.clear();
-      tx.extra.clear();
+      tx.clear();
 
       KeyPair txkey = KeyPair::generate();
       add_tx_pub_key_to_extra(tx, txkey.pub);
@@ -405,6 +406,9 @@ namespace cryptonote {
 
     blocksFileName(parameters::CRYPTONOTE_BLOCKS_FILENAME);
     blocksCacheFileName(parameters::CRYPTONOTE_BLOCKSCACHE_FILENAME);
+    keyImagesFileName(parameters::CRYPTONOTE_KEYIMAGES_FILENAME);
+    txIndexFileName(parameters::CRYPTONOTE_TXINDEX_FILENAME);
+    blockHeadersFileName(parameters::CRYPTONOTE_BLOCKHEADERS_FILENAME);
     blockIndexesFileName(parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME);
     txPoolFileName(parameters::CRYPTONOTE_POOLDATA_FILENAME);
 
@@ -74,6 +74,9 @@ namespace cryptonote
 
     const std::string& blocksFileName() const { return m_blocksFileName; }
     const std::string& blocksCacheFileName() const { return m_blocksCacheFileName; }
+    const std::string& keyImagesFileName() const { return m_keyImagesFileName; }
+    const std::string& txIndexFileName() const { return m_txIndexFileName; }
+    const std::string& blockHeadersFileName() const { return m_blockHeadersFileName; }
     const std::string& blockIndexesFileName() const { return m_blockIndexesFileName; }
     const std::string& txPoolFileName() const { return m_txPoolFileName; }
 
@@ -164,6 +167,9 @@ namespace cryptonote
 
     std::string m_blocksFileName;
     std::string m_blocksCacheFileName;
+    std::string m_keyImagesFileName;
+    std::string m_txIndexFileName;
+    std::string m_blockHeadersFileName;
     std::string m_blockIndexesFileName;
     std::string m_txPoolFileName;
 
@@ -236,6 +242,9 @@ namespace cryptonote
 
     CurrencyBuilder& blocksFileName(const std::string& val) { m_currency.m_blocksFileName = val; return *this; }
     CurrencyBuilder& blocksCacheFileName(const std::string& val) { m_currency.m_blocksCacheFileName = val; return *this; }
+    CurrencyBuilder& keyImagesFileName(const std::string& val) { m_currency.m_keyImagesFileName = val; return *this; }
+    CurrencyBuilder& txIndexFileName(const std::string& val) { m_currency.m_txIndexFileName = val; return *this; }
+    CurrencyBuilder& blockHeadersFileName(const std::string& val) { m_currency.m_blockHeadersFileName = val; return *this; }
     CurrencyBuilder& blockIndexesFileName(const std::string& val) { m_currency.m_blockIndexesFileName = val; return *this; }
     CurrencyBuilder& txPoolFileName(const std::string& val) { m_currency.m_txPoolFileName = val; return *this; }
 
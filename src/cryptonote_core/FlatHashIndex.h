@@ -0,0 +1,312 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "crypto/hash.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cryptonote {
+
+// Bit i of the result is set if tags[i] == value, for a group of eight 16-bit tags.
+inline unsigned matchTagGroup(const uint16_t* tags, uint16_t value) {
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags));
+  __m128i equal = _mm_cmpeq_epi16(group, _mm_set1_epi16(static_cast<short>(value)));
+  return static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(equal, _mm_setzero_si128())));
+#else
+  unsigned mask = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    if (tags[i] == value) {
+      mask |= 1u << i;
+    }
+  }
+
+  return mask;
+#endif
+}
+
+// Open-addressing index of entries keyed by 32-byte hashes or other uniformly random 32-byte keys, like key images.
+// Their bytes are used directly: the first eight pick a group of eight slots, the next two are a 16-bit tag kept
+// apart from the entries.
+// A lookup compares the tags of a group at once and reads an entry only on a tag match, a hit usually costs one
+// cache line of tags and one of entries. KeyOf returns the key of an entry, so an entry may hold its key or KeyOf
+// may look it up elsewhere.
+//
+// A slot takes sizeof(Entry) + 2 bytes. The table grows to twice the entry count once it is 7/8 full, so it is
+// between 7/16 and 7/8 full and an entry takes (sizeof(Entry) + 2) * 8/7 to (sizeof(Entry) + 2) * 16/7 bytes.
+// Erased entries leave their slots marked as deleted until the next rehash.
+//
+// find() may be called concurrently, modifications must be serialized by the owner. Entry must be trivially copyable.
+template<typename Entry, typename KeyOf, typename Key = crypto::hash>
+class FlatHashIndex {
+public:
+  explicit FlatHashIndex(const KeyOf& keyOf = KeyOf()) : m_keyOf(keyOf), m_size(0), m_deleted(0) {
+    rehash(MIN_CAPACITY);
+  }
+
+  // Copies the table of other, with keyOf in place of its KeyOf, for entries whose keys are looked up elsewhere.
+  FlatHashIndex(const FlatHashIndex& other, const KeyOf& keyOf) : m_keyOf(keyOf), m_tags(other.m_tags),
+    m_entries(other.m_entries), m_size(other.m_size), m_deleted(other.m_deleted) {
+  }
+
+  // Returns nullptr if there is no entry with the key. The pointer is valid until the next modification.
+  const Entry* find(const Key& key) const {
+    size_t slot = findSlot(key);
+    return slot == m_tags.size() ? nullptr : &m_entries[slot];
+  }
+
+  // Returns false if there already is an entry with the same key.
+  bool insert(const Entry& entry) {
+    if (findSlot(m_keyOf(entry)) != m_tags.size()) {
+      return false;
+    }
+
+    if ((m_size + m_deleted + 1) * 8 > m_tags.size() * 7) {
+      rehash(capacityFor(m_size + 1));
+    }
+
+    insertNew(entry);
+    return true;
+  }
+
+  // Returns false if there is no entry with the key.
+  bool erase(const Key& key) {
+    size_t slot = findSlot(key);
+    if (slot == m_tags.size()) {
+      return false;
+    }
+
+    // a group that still has an empty slot has never been full, so no lookup has ever probed past it
+    if (matchTagGroup(&m_tags[slot - slot % GROUP_SIZE], EMPTY_TAG) != 0) {
+      m_tags[slot] = EMPTY_TAG;
+    } else {
+      m_tags[slot] = DELETED_TAG;
+      ++m_deleted;
+    }
+
+    --m_size;
+    return true;
+  }
+
+  void clear() {
+    std::vector<uint16_t>().swap(m_tags);
+    std::vector<Entry>().swap(m_entries);
+    rehash(MIN_CAPACITY);
+  }
+
+  void reserve(size_t count) {
+    if (count * 8 > m_tags.size() * 7) {
+      rehash(capacityFor(count));
+    }
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  size_t capacity() const {
+    return m_tags.size();
+  }
+
+  size_t memoryUsage() const {
+    return m_tags.size() * (sizeof(uint16_t) + sizeof(Entry));
+  }
+
+  template<typename Visitor> void forEach(Visitor visitor) const {
+    for (size_t i = 0; i < m_tags.size(); ++i) {
+      if (m_tags[i] != EMPTY_TAG && m_tags[i] != DELETED_TAG) {
+        visitor(m_entries[i]);
+      }
+    }
+  }
+
+  // The file holds the table as it is in memory, in native byte order, loading it is one copy of the mapped file.
+  // height and lastBlockHash identify the chain state the index describes, load() fails if the file describes
+  // another one.
+  bool save(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) const {
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return false;
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.signature, fileSignature(), sizeof(header.signature));
+    header.entrySize = sizeof(Entry);
+    header.height = height;
+    header.lastBlockHash = lastBlockHash;
+    header.size = m_size;
+    header.deleted = m_deleted;
+    header.capacity = m_tags.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_tags.data()), m_tags.size() * sizeof(uint16_t));
+    file.write(reinterpret_cast<const char*>(m_entries.data()), m_entries.size() * sizeof(Entry));
+    file.flush();
+    return file.good();
+  }
+
+  bool load(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) {
+    try {
+      boost::interprocess::file_mapping file(fileName.c_str(), boost::interprocess::read_only);
+      boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+      const char* data = static_cast<const char*>(region.get_address());
+      size_t fileSize = region.get_size();
+
+      FileHeader header;
+      if (fileSize < sizeof(header)) {
+        return false;
+      }
+
+      memcpy(&header, data, sizeof(header));
+      if (memcmp(header.signature, fileSignature(), sizeof(header.signature)) != 0 || header.entrySize != sizeof(Entry) ||
+        header.height != height || header.lastBlockHash != lastBlockHash) {
+        return false;
+      }
+
+      uint64_t capacity = header.capacity;
+      if (capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0 || header.size + header.deleted > capacity ||
+        fileSize != sizeof(header) + capacity * (sizeof(uint16_t) + sizeof(Entry))) {
+        return false;
+      }
+
+      const uint16_t* tags = reinterpret_cast<const uint16_t*>(data + sizeof(header));
+      const char* entries = data + sizeof(header) + capacity * sizeof(uint16_t);
+      m_tags.assign(tags, tags + capacity);
+      m_entries.resize(static_cast<size_t>(capacity));
+      memcpy(m_entries.data(), entries, static_cast<size_t>(capacity) * sizeof(Entry));
+      m_size = static_cast<size_t>(header.size);
+      m_deleted = static_cast<size_t>(header.deleted);
+    } catch (std::exception&) {
+      return false;
+    }
+
+    return true;
+  }
+
+private:
+  static const size_t GROUP_SIZE = 8;
+  static const size_t MIN_CAPACITY = 64;
+  enum : uint16_t { EMPTY_TAG = 0, DELETED_TAG = 1 };
+
+  struct FileHeader {
+    char signature[8];
+    uint32_t entrySize;
+    uint32_t reserved;
+    uint64_t height;
+    crypto::hash lastBlockHash;
+    uint64_t size;
+    uint64_t deleted;
+    uint64_t capacity;
+  };
+
+  KeyOf m_keyOf;
+  std::vector<uint16_t> m_tags;
+  std::vector<Entry> m_entries;
+  size_t m_size;
+  size_t m_deleted;
+
+  // Slot of the entry with the key or capacity() if there is none.
+  size_t findSlot(const Key& key) const {
+    size_t groupMask = m_tags.size() / GROUP_SIZE - 1;
+    size_t group = static_cast<size_t>(groupHash(key)) & groupMask;
+    uint16_t keyTag = tag(key);
+
+    // the table is never more than 7/8 full, a group with an empty slot always comes
+    for (;;) {
+      const uint16_t* groupTags = &m_tags[group * GROUP_SIZE];
+      unsigned matches = matchTagGroup(groupTags, keyTag);
+      for (size_t i = 0; matches != 0; ++i, matches >>= 1) {
+        if ((matches & 1) != 0 && m_keyOf(m_entries[group * GROUP_SIZE + i]) == key) {
+          return group * GROUP_SIZE + i;
+        }
+      }
+
+      if (matchTagGroup(groupTags, EMPTY_TAG) != 0) {
+        return m_tags.size();
+      }
+
+      group = (group + 1) & groupMask;
+    }
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<uint16_t> tags(capacity, EMPTY_TAG);
+    std::vector<Entry> entries(capacity);
+    m_tags.swap(tags);
+    m_entries.swap(entries);
+    m_size = 0;
+    m_deleted = 0;
+
+    for (size_t i = 0; i < tags.size(); ++i) {
+      if (tags[i] != EMPTY_TAG && tags[i] != DELETED_TAG) {
+        insertNew(entries[i]);
+      }
+    }
+  }
+
+  void insertNew(const Entry& entry) {
+    const Key& key = m_keyOf(entry);
+    size_t groupMask = m_tags.size() / GROUP_SIZE - 1;
+    size_t group = static_cast<size_t>(groupHash(key)) & groupMask;
+
+    for (;;) {
+      for (size_t slot = group * GROUP_SIZE; slot < (group + 1) * GROUP_SIZE; ++slot) {
+        if (m_tags[slot] == EMPTY_TAG || m_tags[slot] == DELETED_TAG) {
+          if (m_tags[slot] == DELETED_TAG) {
+            --m_deleted;
+          }
+
+          m_tags[slot] = tag(key);
+          m_entries[slot] = entry;
+          ++m_size;
+          return;
+        }
+      }
+
+      group = (group + 1) & groupMask;
+    }
+  }
+
+  static const char* fileSignature() {
+    return "HASHIDX1";
+  }
+
+  static size_t capacityFor(size_t count) {
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+
+    return capacity;
+  }
+
+  static uint64_t groupHash(const Key& key) {
+    uint64_t value;
+    memcpy(&value, &key, sizeof(value));
+    return value;
+  }
+
+  static uint16_t tag(const Key& key) {
+    uint16_t value;
+    memcpy(&value, reinterpret_cast<const uint8_t*>(&key) + 8, sizeof(value));
+    return value > DELETED_TAG ? value : static_cast<uint16_t>(value + 2);
+  }
+};
+
+}
@@ -34,6 +34,8 @@ namespace CryptoNote {
     virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock) = 0;
     virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) = 0;
     virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx) = 0;
+    // True while the next block is below the last checkpoint, its transactions are then checked when it is pushed.
+    virtual bool isInCheckpointZone() const = 0;
   };
 
 }
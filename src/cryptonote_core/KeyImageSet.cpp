@@ -0,0 +1,115 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "KeyImageSet.h"
+
+#include <cstring>
+
+namespace cryptonote {
+
+namespace {
+
+// 64 slots share one 512-bit filter block, 8 filter bits per slot
+const size_t SLOTS_PER_FILTER_BLOCK = 64;
+const size_t FILTER_HASHES = 6;
+
+uint64_t readWord(const crypto::key_image& keyImage, size_t offset) {
+  uint64_t word;
+  memcpy(&word, reinterpret_cast<const uint8_t*>(&keyImage) + offset, sizeof(word));
+  return word;
+}
+
+size_t filterWords(size_t capacity) {
+  return capacity / SLOTS_PER_FILTER_BLOCK * (512 / 64);
+}
+
+}
+
+KeyImageSet::KeyImageSet() {
+  rebuildFilter();
+}
+
+bool KeyImageSet::contains(const crypto::key_image& keyImage) const {
+  return filterContains(keyImage) && m_index.find(keyImage) != nullptr;
+}
+
+bool KeyImageSet::insert(const crypto::key_image& keyImage) {
+  size_t capacity = m_index.capacity();
+  if (!m_index.insert(keyImage)) {
+    return false;
+  }
+
+  if (m_index.capacity() != capacity) {
+    rebuildFilter();
+  } else {
+    filterInsert(keyImage);
+  }
+
+  return true;
+}
+
+bool KeyImageSet::erase(const crypto::key_image& keyImage) {
+  return filterContains(keyImage) && m_index.erase(keyImage);
+}
+
+void KeyImageSet::clear() {
+  m_index.clear();
+  rebuildFilter();
+}
+
+size_t KeyImageSet::size() const {
+  return m_index.size();
+}
+
+size_t KeyImageSet::capacity() const {
+  return m_index.capacity();
+}
+
+bool KeyImageSet::save(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) const {
+  return m_index.save(fileName, height, lastBlockHash);
+}
+
+bool KeyImageSet::load(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) {
+  if (!m_index.load(fileName, height, lastBlockHash)) {
+    return false;
+  }
+
+  rebuildFilter();
+  return true;
+}
+
+bool KeyImageSet::filterContains(const crypto::key_image& keyImage) const {
+  size_t blockMask = m_filter.size() / FILTER_BLOCK_WORDS - 1;
+  const uint64_t* block = &m_filter[(static_cast<size_t>(readWord(keyImage, 16)) & blockMask) * FILTER_BLOCK_WORDS];
+  uint64_t bits = readWord(keyImage, 24);
+  for (size_t i = 0; i < FILTER_HASHES; ++i, bits >>= 9) {
+    unsigned bit = static_cast<unsigned>(bits & 511);
+    if ((block[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void KeyImageSet::filterInsert(const crypto::key_image& keyImage) {
+  size_t blockMask = m_filter.size() / FILTER_BLOCK_WORDS - 1;
+  uint64_t* block = &m_filter[(static_cast<size_t>(readWord(keyImage, 16)) & blockMask) * FILTER_BLOCK_WORDS];
+  uint64_t bits = readWord(keyImage, 24);
+  for (size_t i = 0; i < FILTER_HASHES; ++i, bits >>= 9) {
+    unsigned bit = static_cast<unsigned>(bits & 511);
+    block[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+}
+
+// The filter is sized by the table capacity, it is rebuilt whenever the table grows.
+void KeyImageSet::rebuildFilter() {
+  m_filter.assign(filterWords(m_index.capacity()), 0);
+  m_index.forEach([this](const crypto::key_image& keyImage) {
+    filterInsert(keyImage);
+  });
+}
+
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "cryptonote_core/FlatHashIndex.h"
+
+namespace cryptonote {
+
+// Set of spent key images in a FlatHashIndex. Most lookups are for unspent key images, a blocked Bloom filter in
+// front of the table answers nearly all of them from one cache line.
+//
+// Erased key images leave their filter bits set until the table grows and the filter is rebuilt.
+// contains() may be called concurrently, modifications must be serialized by the owner.
+class KeyImageSet {
+public:
+  KeyImageSet();
+
+  bool contains(const crypto::key_image& keyImage) const;
+  // Returns false if the key image is already in the set.
+  bool insert(const crypto::key_image& keyImage);
+  // Returns false if the key image is not in the set.
+  bool erase(const crypto::key_image& keyImage);
+  void clear();
+
+  size_t size() const;
+  size_t capacity() const;
+
+  // The file holds the table, see FlatHashIndex::save. The filter is not stored, load() rebuilds it from the keys.
+  bool save(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash) const;
+  bool load(const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash);
+
+private:
+  struct KeyImageKey {
+    const crypto::key_image& operator()(const crypto::key_image& keyImage) const {
+      return keyImage;
+    }
+  };
+
+  static const size_t FILTER_BLOCK_WORDS = 8;
+
+  FlatHashIndex<crypto::key_image, KeyImageKey, crypto::key_image> m_index;
+  std::vector<uint64_t> m_filter;
+
+  bool filterContains(const crypto::key_image& keyImage) const;
+  void filterInsert(const crypto::key_image& keyImage);
+  void rebuildFilter();
+};
+
+}
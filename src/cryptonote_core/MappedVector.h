@@ -0,0 +1,653 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "serialization/binary_archive.h"
+
+// Read-only std::streambuf over a memory range, lets binary_archive parse items in place.
+class MemoryRangeStreamBuf : public std::streambuf {
+public:
+  MemoryRangeStreamBuf(const char* data, std::size_t size) {
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+  }
+
+protected:
+  virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override {
+    if ((mode & std::ios_base::in) == 0) {
+      return pos_type(off_type(-1));
+    }
+
+    off_type position;
+    if (direction == std::ios_base::beg) {
+      position = offset;
+    } else if (direction == std::ios_base::cur) {
+      position = (gptr() - eback()) + offset;
+    } else {
+      position = (egptr() - eback()) + offset;
+    }
+
+    if (position < 0 || position > egptr() - eback()) {
+      return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + position, egptr());
+    return pos_type(position);
+  }
+
+  virtual pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+    return seekoff(off_type(position), std::ios_base::beg, mode);
+  }
+};
+
+struct MappedVectorCacheStatistics {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t items;
+  uint64_t size;
+  uint64_t capacity;
+};
+
+// Append-only vector of serialized items stored in the same file format as SwappedVector (items file plus
+// index file of item sizes). Items are read straight from a read-only memory mapping of the items file,
+// deserialized objects are kept in a sharded cache bounded by the serialized size of cached items.
+//
+// Thread safety: operator[], back(), get(), load(), getBlob(), size() and getCacheStatistics() may be called
+// concurrently with each other and with push_back()/pop_back()/clear(). Modifications must be serialized by the owner.
+// Items are returned as shared pointers, an item stays valid as long as the caller holds it, even after eviction.
+// A popped item's bytes are overwritten by the next push, so every pop_back() and clear() starts a new generation.
+// A read that saw the mapping in an older generation is retried and never cached, getBlob() returns a copy.
+//
+// Item sizes are written to the index file in batches of setIndexBatchSize() items, one item per batch by default.
+// The item count in the index file only covers written batches, so after a crash the vector reopens consistently
+// without the items of the last unwritten batch. flush() writes the pending batch and counts as a modification.
+template<class T> class MappedVector {
+public:
+  typedef T value_type;
+
+  typedef MappedVectorCacheStatistics CacheStatistics;
+
+  class Blob;
+
+  MappedVector();
+  MappedVector(const MappedVector&) = delete;
+  ~MappedVector();
+  MappedVector& operator=(const MappedVector&) = delete;
+
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize);
+  void close();
+
+  bool empty() const;
+  uint64_t size() const;
+  std::shared_ptr<const T> operator[](uint64_t index);
+  std::shared_ptr<const T> back();
+  std::shared_ptr<const T> get(uint64_t index);
+  std::shared_ptr<const T> load(uint64_t index);
+  Blob getBlob(uint64_t index);
+  CacheStatistics getCacheStatistics() const;
+  void clear();
+  void pop_back();
+  void push_back(const T& item);
+  void setIndexBatchSize(size_t batchSize);
+  void flush();
+
+private:
+  struct Mapping {
+    boost::interprocess::mapped_region region;
+    uint64_t size;
+  };
+
+  // Serialized item in the mapping, valid until the generation changes.
+  struct Location {
+    std::shared_ptr<const Mapping> mapping;
+    const char* data;
+    std::size_t size;
+    uint64_t generation;
+  };
+
+public:
+  // Serialized item, copied out of the mapping.
+  class Blob {
+  public:
+    const char* data() const {
+      return m_data.data();
+    }
+
+    std::size_t size() const {
+      return m_data.size();
+    }
+
+    bool empty() const {
+      return m_data.empty();
+    }
+
+    const std::string& str() const {
+      return m_data;
+    }
+
+  private:
+    friend class MappedVector;
+
+    std::string m_data;
+  };
+
+private:
+  struct CacheEntry {
+    std::shared_ptr<const T> item;
+    uint64_t size;
+    std::list<uint64_t>::iterator lruIter;
+  };
+
+  struct CacheShard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, CacheEntry> entries;
+    std::list<uint64_t> lru;
+    uint64_t size;
+  };
+
+  static const size_t CACHE_SHARD_COUNT = 16;
+  static const uint64_t ITEMS_FILE_GROWTH = 64 * 1024 * 1024;
+
+  std::string m_itemsFileName;
+  std::fstream m_itemsFile;
+  std::fstream m_indexesFile;
+  uint64_t m_itemsFileCapacity;
+  size_t m_indexBatchSize;
+  std::vector<uint32_t> m_pendingItemSizes;
+
+  mutable std::mutex m_mutex;
+  std::vector<uint64_t> m_offsets;
+  uint64_t m_itemsFileSize;
+  std::shared_ptr<const Mapping> m_mapping;
+  std::atomic<uint64_t> m_generation;
+
+  mutable CacheShard m_cacheShards[CACHE_SHARD_COUNT];
+  uint64_t m_shardCapacity;
+  std::atomic<uint64_t> m_cacheHits;
+  std::atomic<uint64_t> m_cacheMisses;
+
+  bool locate(uint64_t index, Location& location);
+  bool isCurrent(const Location& location) const;
+  static std::shared_ptr<const T> deserialize(const char* data, std::size_t size);
+  std::shared_ptr<const T> cacheFind(uint64_t index);
+  std::shared_ptr<const T> cacheInsert(uint64_t index, const std::shared_ptr<const T>& item, uint64_t size, uint64_t generation);
+  void cacheErase(uint64_t index);
+  void cacheClear();
+  bool reserve(uint64_t itemsFileSize);
+  bool writeIndexes(uint64_t count);
+};
+
+template<class T> MappedVector<T>::MappedVector() : m_itemsFileCapacity(0), m_indexBatchSize(1), m_itemsFileSize(0), m_generation(0), m_shardCapacity(0), m_cacheHits(0), m_cacheMisses(0) {
+  for (auto& shard : m_cacheShards) {
+    shard.size = 0;
+  }
+}
+
+template<class T> MappedVector<T>::~MappedVector() {
+  close();
+}
+
+template<class T> bool MappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t cacheSize) {
+  m_itemsFile.open(itemFileName, std::ios::in | std::ios::out | std::ios::binary);
+  m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
+  if (m_itemsFile && m_indexesFile) {
+    uint64_t count;
+    m_indexesFile.read(reinterpret_cast<char*>(&count), sizeof count);
+    if (!m_indexesFile) {
+      return false;
+    }
+
+    std::vector<uint64_t> offsets;
+    uint64_t itemsFileSize = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+      uint32_t itemSize;
+      m_indexesFile.read(reinterpret_cast<char*>(&itemSize), sizeof itemSize);
+      if (!m_indexesFile) {
+        return false;
+      }
+
+      offsets.emplace_back(itemsFileSize);
+      itemsFileSize += itemSize;
+    }
+
+    m_itemsFile.seekg(0, std::ios::end);
+    uint64_t itemsFileCapacity = m_itemsFile.tellg();
+    if (!m_itemsFile || itemsFileCapacity < itemsFileSize) {
+      return false;
+    }
+
+    m_offsets.swap(offsets);
+    m_itemsFileSize = itemsFileSize;
+    m_itemsFileCapacity = itemsFileCapacity;
+  } else {
+    m_itemsFile.open(itemFileName, std::ios::out | std::ios::binary);
+    m_itemsFile.close();
+    m_itemsFile.open(itemFileName, std::ios::in | std::ios::out | std::ios::binary);
+    m_indexesFile.open(indexFileName, std::ios::out | std::ios::binary);
+    uint64_t count = 0;
+    m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
+    if (!m_indexesFile) {
+      return false;
+    }
+
+    m_indexesFile.close();
+    m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
+    m_offsets.clear();
+    m_itemsFileSize = 0;
+    m_itemsFileCapacity = 0;
+  }
+
+  m_itemsFileName = itemFileName;
+  m_pendingItemSizes.clear();
+  m_mapping.reset();
+  m_shardCapacity = cacheSize / CACHE_SHARD_COUNT;
+  cacheClear();
+  m_cacheHits = 0;
+  m_cacheMisses = 0;
+  return true;
+}
+
+template<class T> void MappedVector<T>::close() {
+  if (!m_itemsFile.is_open()) {
+    return;
+  }
+
+  writeIndexes(size());
+  m_pendingItemSizes.clear();
+  cacheClear();
+  m_mapping.reset();
+  m_itemsFile.close();
+  m_indexesFile.close();
+
+  // Drop the preallocated tail, so that the items file matches the index again.
+  if (m_itemsFileCapacity > m_itemsFileSize) {
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(m_itemsFileName, m_itemsFileSize, ec);
+  }
+
+  m_itemsFileCapacity = m_itemsFileSize;
+}
+
+template<class T> bool MappedVector<T>::empty() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_offsets.empty();
+}
+
+template<class T> uint64_t MappedVector<T>::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_offsets.size();
+}
+
+template<class T> std::shared_ptr<const T> MappedVector<T>::operator[](uint64_t index) {
+  return get(index);
+}
+
+template<class T> std::shared_ptr<const T> MappedVector<T>::back() {
+  return get(size() - 1);
+}
+
+template<class T> std::shared_ptr<const T> MappedVector<T>::get(uint64_t index) {
+  for (;;) {
+    std::shared_ptr<const T> item = cacheFind(index);
+    if (item) {
+      ++m_cacheHits;
+      return item;
+    }
+
+    Location location;
+    if (!locate(index, location)) {
+      throw std::runtime_error("MappedVector::get");
+    }
+
+    item = deserialize(location.data, location.size);
+    if (!isCurrent(location)) {
+      // the item was popped while it was read, its bytes may be those of the item pushed in its place
+      continue;
+    }
+
+    if (!item) {
+      throw std::runtime_error("MappedVector::get");
+    }
+
+    ++m_cacheMisses;
+    return cacheInsert(index, item, location.size, location.generation);
+  }
+}
+
+// Deserializes the item bypassing the cache, for bulk scans that should not evict the working set.
+template<class T> std::shared_ptr<const T> MappedVector<T>::load(uint64_t index) {
+  for (;;) {
+    std::shared_ptr<const T> item = cacheFind(index);
+    if (item) {
+      return item;
+    }
+
+    Location location;
+    if (!locate(index, location)) {
+      throw std::runtime_error("MappedVector::load");
+    }
+
+    item = deserialize(location.data, location.size);
+    if (!isCurrent(location)) {
+      continue;
+    }
+
+    if (!item) {
+      throw std::runtime_error("MappedVector::load");
+    }
+
+    return item;
+  }
+}
+
+// Returns an empty pointer if the bytes don't parse, they may have been overwritten while they were read.
+template<class T> std::shared_ptr<const T> MappedVector<T>::deserialize(const char* data, std::size_t size) {
+  std::shared_ptr<T> item = std::make_shared<T>();
+  try {
+    MemoryRangeStreamBuf buffer(data, size);
+    std::istream stream(&buffer);
+    binary_archive<false> archive(stream);
+    if (!do_serialize(archive, *item)) {
+      return std::shared_ptr<const T>();
+    }
+  } catch (std::exception&) {
+    return std::shared_ptr<const T>();
+  }
+
+  return item;
+}
+
+template<class T> typename MappedVector<T>::Blob MappedVector<T>::getBlob(uint64_t index) {
+  for (;;) {
+    Location location;
+    if (!locate(index, location)) {
+      throw std::runtime_error("MappedVector::getBlob");
+    }
+
+    Blob blob;
+    blob.m_data.assign(location.data, location.size);
+    if (isCurrent(location)) {
+      return blob;
+    }
+  }
+}
+
+template<class T> typename MappedVector<T>::CacheStatistics MappedVector<T>::getCacheStatistics() const {
+  CacheStatistics statistics = { m_cacheHits, m_cacheMisses, 0, 0, m_shardCapacity * CACHE_SHARD_COUNT };
+  for (auto& shard : m_cacheShards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    statistics.items += shard.entries.size();
+    statistics.size += shard.size;
+  }
+
+  return statistics;
+}
+
+template<class T> void MappedVector<T>::clear() {
+  if (!m_indexesFile) {
+    throw std::runtime_error("MappedVector::clear");
+  }
+
+  m_pendingItemSizes.clear();
+  m_indexesFile.seekp(0);
+  uint64_t count = 0;
+  m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
+  m_indexesFile.flush();
+  if (!m_indexesFile) {
+    throw std::runtime_error("MappedVector::clear");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_offsets.clear();
+    m_itemsFileSize = 0;
+    ++m_generation;
+  }
+
+  cacheClear();
+}
+
+template<class T> void MappedVector<T>::pop_back() {
+  if (!m_indexesFile) {
+    throw std::runtime_error("MappedVector::pop_back");
+  }
+
+  uint64_t count = size() - 1;
+  if (!m_pendingItemSizes.empty()) {
+    // the item never made it to the index file
+    m_pendingItemSizes.pop_back();
+  } else {
+    m_indexesFile.seekp(0);
+    m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
+    m_indexesFile.flush();
+    if (!m_indexesFile) {
+      throw std::runtime_error("MappedVector::pop_back");
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_itemsFileSize = m_offsets.back();
+    m_offsets.pop_back();
+    ++m_generation;
+  }
+
+  cacheErase(count);
+}
+
+template<class T> void MappedVector<T>::push_back(const T& item) {
+  std::stringstream itemStream;
+  binary_archive<true> archive(itemStream);
+  if (!do_serialize(archive, *const_cast<T*>(&item))) {
+    throw std::runtime_error("MappedVector::push_back");
+  }
+
+  std::string itemBlob = itemStream.str();
+  uint64_t itemsFileSize = m_itemsFileSize + itemBlob.size();
+  if (!reserve(itemsFileSize)) {
+    throw std::runtime_error("MappedVector::push_back");
+  }
+
+  {
+    m_itemsFile.seekp(m_itemsFileSize);
+    m_itemsFile.write(itemBlob.data(), itemBlob.size());
+    m_itemsFile.flush();
+    if (!m_itemsFile) {
+      throw std::runtime_error("MappedVector::push_back");
+    }
+  }
+
+  uint64_t count = size();
+  m_pendingItemSizes.push_back(static_cast<uint32_t>(itemBlob.size()));
+  if (m_pendingItemSizes.size() >= m_indexBatchSize && !writeIndexes(count + 1)) {
+    throw std::runtime_error("MappedVector::push_back");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_offsets.push_back(m_itemsFileSize);
+    m_itemsFileSize = itemsFileSize;
+  }
+
+  cacheInsert(count, std::make_shared<T>(item), itemBlob.size(), m_generation);
+}
+
+template<class T> void MappedVector<T>::setIndexBatchSize(size_t batchSize) {
+  m_indexBatchSize = std::max<size_t>(batchSize, 1);
+  if (m_pendingItemSizes.size() >= m_indexBatchSize) {
+    flush();
+  }
+}
+
+template<class T> void MappedVector<T>::flush() {
+  if (!writeIndexes(size())) {
+    throw std::runtime_error("MappedVector::flush");
+  }
+}
+
+// Appends the pending item sizes to the index file and commits them by updating the item count, count includes them.
+template<class T> bool MappedVector<T>::writeIndexes(uint64_t count) {
+  if (m_pendingItemSizes.empty()) {
+    return true;
+  }
+
+  if (!m_indexesFile) {
+    return false;
+  }
+
+  m_indexesFile.seekp(sizeof(uint64_t) + sizeof(uint32_t) * (count - m_pendingItemSizes.size()));
+  m_indexesFile.write(reinterpret_cast<const char*>(m_pendingItemSizes.data()), sizeof(uint32_t) * m_pendingItemSizes.size());
+  if (!m_indexesFile) {
+    return false;
+  }
+
+  m_indexesFile.seekp(0);
+  m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
+  m_indexesFile.flush();
+  if (!m_indexesFile) {
+    return false;
+  }
+
+  m_pendingItemSizes.clear();
+  return true;
+}
+
+template<class T> bool MappedVector<T>::locate(uint64_t index, Location& location) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (index >= m_offsets.size()) {
+    return false;
+  }
+
+  uint64_t offset = m_offsets[index];
+  uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+  if (!m_mapping || m_mapping->size < end) {
+    // The file is preallocated in large steps, so remapping happens once per ITEMS_FILE_GROWTH bytes of items.
+    try {
+      boost::interprocess::file_mapping file(m_itemsFileName.c_str(), boost::interprocess::read_only);
+      std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>();
+      boost::interprocess::mapped_region region(file, boost::interprocess::read_only, 0, static_cast<std::size_t>(m_itemsFileCapacity));
+      mapping->region.swap(region);
+      mapping->size = m_itemsFileCapacity;
+      m_mapping = mapping;
+    } catch (std::exception&) {
+      return false;
+    }
+  }
+
+  location.mapping = m_mapping;
+  location.data = static_cast<const char*>(m_mapping->region.get_address()) + offset;
+  location.size = static_cast<std::size_t>(end - offset);
+  location.generation = m_generation;
+  return true;
+}
+
+// The writer starts a new generation before it overwrites any bytes, so unchanged generation means the bytes read
+// at the location were not touched.
+template<class T> bool MappedVector<T>::isCurrent(const Location& location) const {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return m_generation == location.generation;
+}
+
+template<class T> std::shared_ptr<const T> MappedVector<T>::cacheFind(uint64_t index) {
+  CacheShard& shard = m_cacheShards[index % CACHE_SHARD_COUNT];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto entryIter = shard.entries.find(index);
+  if (entryIter == shard.entries.end()) {
+    return std::shared_ptr<const T>();
+  }
+
+  shard.lru.splice(shard.lru.end(), shard.lru, entryIter->second.lruIter);
+  return entryIter->second.item;
+}
+
+// pop_back() erases the popped item after it starts a new generation, an item read in an older generation must not
+// be inserted after that.
+template<class T> std::shared_ptr<const T> MappedVector<T>::cacheInsert(uint64_t index, const std::shared_ptr<const T>& item, uint64_t size, uint64_t generation) {
+  CacheShard& shard = m_cacheShards[index % CACHE_SHARD_COUNT];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (generation != m_generation) {
+    return item;
+  }
+
+  auto entryIter = shard.entries.find(index);
+  if (entryIter != shard.entries.end()) {
+    // Another reader loaded the same item in the meantime.
+    shard.size -= entryIter->second.size;
+    shard.lru.erase(entryIter->second.lruIter);
+    shard.entries.erase(entryIter);
+  }
+
+  if (size > m_shardCapacity) {
+    return item;
+  }
+
+  while (shard.size + size > m_shardCapacity) {
+    auto oldestIter = shard.entries.find(shard.lru.front());
+    shard.size -= oldestIter->second.size;
+    shard.entries.erase(oldestIter);
+    shard.lru.pop_front();
+  }
+
+  CacheEntry entry = { item, size, shard.lru.insert(shard.lru.end(), index) };
+  shard.entries.insert(std::make_pair(index, entry));
+  shard.size += size;
+  return item;
+}
+
+template<class T> void MappedVector<T>::cacheErase(uint64_t index) {
+  CacheShard& shard = m_cacheShards[index % CACHE_SHARD_COUNT];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto entryIter = shard.entries.find(index);
+  if (entryIter != shard.entries.end()) {
+    shard.size -= entryIter->second.size;
+    shard.lru.erase(entryIter->second.lruIter);
+    shard.entries.erase(entryIter);
+  }
+}
+
+template<class T> void MappedVector<T>::cacheClear() {
+  for (auto& shard : m_cacheShards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.clear();
+    shard.lru.clear();
+    shard.size = 0;
+  }
+}
+
+template<class T> bool MappedVector<T>::reserve(uint64_t itemsFileSize) {
+  if (itemsFileSize <= m_itemsFileCapacity) {
+    return true;
+  }
+
+  uint64_t itemsFileCapacity = (itemsFileSize + ITEMS_FILE_GROWTH - 1) / ITEMS_FILE_GROWTH * ITEMS_FILE_GROWTH;
+  m_itemsFile.seekp(itemsFileCapacity - 1);
+  m_itemsFile.put(0);
+  m_itemsFile.flush();
+  if (!m_itemsFile) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_itemsFileCapacity = itemsFileCapacity;
+  return true;
+}
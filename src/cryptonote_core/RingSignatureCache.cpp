@@ -0,0 +1,78 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RingSignatureCache.h"
+
+#include <string>
+
+#include "RingSignatureVerifier.h"
+
+namespace cryptonote {
+
+RingSignatureCache::RingSignatureCache(size_t capacity) : m_capacity(capacity), m_hits(0), m_misses(0) {
+}
+
+size_t RingSignatureCache::find(const std::vector<RingSignatureJob>& jobs, std::vector<bool>& found) {
+  found.assign(jobs.size(), false);
+  if (m_capacity == 0) {
+    return 0;
+  }
+
+  std::vector<crypto::hash> keys;
+  keys.reserve(jobs.size());
+  for (const RingSignatureJob& job : jobs) {
+    keys.push_back(key(job));
+  }
+
+  size_t count = 0;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (m_keys.count(keys[i]) != 0) {
+      found[i] = true;
+      ++count;
+    }
+  }
+
+  m_hits += count;
+  m_misses += jobs.size() - count;
+  return count;
+}
+
+void RingSignatureCache::insert(const RingSignatureJob& job) {
+  if (m_capacity == 0) {
+    return;
+  }
+
+  crypto::hash jobKey = key(job);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_keys.insert(jobKey).second) {
+    return;
+  }
+
+  m_order.push_back(jobKey);
+  if (m_order.size() > m_capacity) {
+    m_keys.erase(m_order.front());
+    m_order.pop_front();
+  }
+}
+
+RingSignatureCacheStatistics RingSignatureCache::getStatistics() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  RingSignatureCacheStatistics statistics = { m_hits, m_misses, m_keys.size(), m_capacity };
+  return statistics;
+}
+
+crypto::hash RingSignatureCache::key(const RingSignatureJob& job) {
+  std::string data;
+  data.reserve(sizeof(job.prefixHash) + sizeof(job.keyImage) +
+    job.outputKeys.size() * (sizeof(crypto::public_key) + sizeof(crypto::signature)));
+  data.append(reinterpret_cast<const char*>(&job.prefixHash), sizeof(job.prefixHash));
+  data.append(reinterpret_cast<const char*>(&job.keyImage), sizeof(job.keyImage));
+  data.append(reinterpret_cast<const char*>(job.outputKeys.data()), job.outputKeys.size() * sizeof(crypto::public_key));
+  data.append(reinterpret_cast<const char*>(job.signatures), job.outputKeys.size() * sizeof(crypto::signature));
+  return crypto::cn_fast_hash(data.data(), data.size());
+}
+
+}
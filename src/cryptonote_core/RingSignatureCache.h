@@ -0,0 +1,51 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/hash.h"
+
+namespace cryptonote {
+
+struct RingSignatureJob;
+
+struct RingSignatureCacheStatistics {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t items;
+  uint64_t capacity;
+};
+
+// Ring signatures known to be valid, at most capacity of them, the oldest is dropped first.
+// An entry covers the prefix hash, the key image, the keys of the referenced outputs and the signatures, so a hit
+// means the very same check has passed before, whichever chain the outputs were looked up in.
+class RingSignatureCache {
+public:
+  explicit RingSignatureCache(size_t capacity);
+
+  // Sets found[i] for each job already known to be valid, returns the number of such jobs.
+  size_t find(const std::vector<RingSignatureJob>& jobs, std::vector<bool>& found);
+  void insert(const RingSignatureJob& job);
+
+  RingSignatureCacheStatistics getStatistics() const;
+
+  static crypto::hash key(const RingSignatureJob& job);
+
+private:
+  const size_t m_capacity;
+  mutable std::mutex m_mutex;
+  std::unordered_set<crypto::hash> m_keys;
+  std::deque<crypto::hash> m_order;
+  uint64_t m_hits;
+  uint64_t m_misses;
+};
+
+}
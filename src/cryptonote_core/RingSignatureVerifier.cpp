@@ -0,0 +1,169 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RingSignatureVerifier.h"
+
+namespace cryptonote {
+
+RingSignatureVerifier::RingSignatureVerifier(size_t workerCount, size_t cacheCapacity) : m_stop(false), m_jobs(nullptr), m_batch(0),
+  m_activeWorkers(0), m_nextJob(0), m_firstFailure(0), m_cache(cacheCapacity) {
+  for (size_t i = 0; i < workerCount; ++i) {
+    m_workers.emplace_back(&RingSignatureVerifier::workerLoop, this);
+  }
+}
+
+RingSignatureVerifier::~RingSignatureVerifier() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_batchStarted.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+size_t RingSignatureVerifier::verify(const std::vector<RingSignatureJob>& jobs) {
+  std::vector<bool> cached;
+  size_t cachedCount = m_cache.find(jobs, cached);
+  if (cachedCount == jobs.size()) {
+    return jobs.size();
+  }
+
+  // cached signatures are valid, the first failure among the others is the first failure of the batch
+  std::vector<RingSignatureJob> uncachedJobs;
+  std::vector<size_t> uncachedIndexes;
+  if (cachedCount != 0) {
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (!cached[i]) {
+        uncachedJobs.push_back(jobs[i]);
+        uncachedIndexes.push_back(i);
+      }
+    }
+  }
+
+  const std::vector<RingSignatureJob>& checkedJobs = cachedCount == 0 ? jobs : uncachedJobs;
+  size_t failure = verifyBatch(checkedJobs);
+  for (size_t i = 0; i < failure; ++i) {
+    m_cache.insert(checkedJobs[i]);
+  }
+
+  if (failure == checkedJobs.size()) {
+    return jobs.size();
+  }
+
+  return cachedCount == 0 ? failure : uncachedIndexes[failure];
+}
+
+size_t RingSignatureVerifier::verifyBatch(const std::vector<RingSignatureJob>& jobs) {
+  if (jobs.size() < 2 || m_workers.empty()) {
+    return verifySerial(jobs);
+  }
+
+  std::unique_lock<std::mutex> batchLock(m_batchMutex, std::try_to_lock);
+  if (!batchLock.owns_lock()) {
+    return verifySerial(jobs);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs = &jobs;
+    m_nextJob = 0;
+    m_firstFailure = jobs.size();
+    ++m_batch;
+  }
+
+  m_batchStarted.notify_all();
+  processJobs(jobs);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  // close the batch for workers that have not picked it up yet and wait for the ones that did
+  m_jobs = nullptr;
+  m_workerDone.wait(lock, [this] { return m_activeWorkers == 0; });
+  return m_firstFailure;
+}
+
+size_t RingSignatureVerifier::workerCount() const {
+  return m_workers.size();
+}
+
+RingSignatureCacheStatistics RingSignatureVerifier::getCacheStatistics() const {
+  return m_cache.getStatistics();
+}
+
+size_t RingSignatureVerifier::defaultWorkerCount() {
+  size_t cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 0;
+}
+
+bool RingSignatureVerifier::check(const RingSignatureJob& job) {
+  std::vector<const crypto::public_key*> keys;
+  keys.reserve(job.outputKeys.size());
+  for (const crypto::public_key& key : job.outputKeys) {
+    keys.push_back(&key);
+  }
+
+  return crypto::check_ring_signature(job.prefixHash, job.keyImage, keys, job.signatures);
+}
+
+void RingSignatureVerifier::workerLoop() {
+  uint64_t lastBatch = 0;
+  for (;;) {
+    const std::vector<RingSignatureJob>* jobs;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_batchStarted.wait(lock, [this, lastBatch] { return m_stop || m_batch != lastBatch; });
+      if (m_stop) {
+        return;
+      }
+
+      lastBatch = m_batch;
+      jobs = m_jobs;
+      if (jobs == nullptr) {
+        continue;
+      }
+
+      ++m_activeWorkers;
+    }
+
+    processJobs(*jobs);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_activeWorkers;
+    }
+
+    m_workerDone.notify_all();
+  }
+}
+
+void RingSignatureVerifier::processJobs(const std::vector<RingSignatureJob>& jobs) {
+  for (;;) {
+    size_t index = m_nextJob++;
+    // jobs are claimed in order, once past the first known failure nothing later can change the result
+    if (index >= jobs.size() || index > m_firstFailure) {
+      return;
+    }
+
+    if (!check(jobs[index])) {
+      size_t failure = m_firstFailure;
+      while (index < failure && !m_firstFailure.compare_exchange_weak(failure, index)) {
+      }
+    }
+  }
+}
+
+size_t RingSignatureVerifier::verifySerial(const std::vector<RingSignatureJob>& jobs) {
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (!check(jobs[i])) {
+      return i;
+    }
+  }
+
+  return jobs.size();
+}
+
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+#include "RingSignatureCache.h"
+
+namespace cryptonote {
+
+// Everything needed to check the ring signature of one key input. Output keys are copied out of the chain, so
+// a job stays valid after the lock that protected the lookup is released.
+struct RingSignatureJob {
+  crypto::hash prefixHash;
+  crypto::key_image keyImage;
+  std::vector<crypto::public_key> outputKeys;
+  const crypto::signature* signatures;
+};
+
+// Checks batches of ring signatures on a fixed set of worker threads, the calling thread takes part in every
+// batch. Jobs are handed out in order and a failure stops all jobs after it, jobs before it still run, so the
+// reported failure is always the first failing job of the batch, exactly as in a serial loop.
+// One batch runs at a time. A caller that finds the workers busy checks its batch on its own thread.
+// With a non-zero cache capacity signatures that passed once are remembered and not checked again.
+class RingSignatureVerifier {
+public:
+  explicit RingSignatureVerifier(size_t workerCount = defaultWorkerCount(), size_t cacheCapacity = 0);
+  ~RingSignatureVerifier();
+
+  // Returns the index of the first job whose signature is invalid, or jobs.size() if all signatures are valid.
+  size_t verify(const std::vector<RingSignatureJob>& jobs);
+
+  size_t workerCount() const;
+  RingSignatureCacheStatistics getCacheStatistics() const;
+
+  static size_t defaultWorkerCount();
+  static bool check(const RingSignatureJob& job);
+
+private:
+  std::mutex m_batchMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_batchStarted;
+  std::condition_variable m_workerDone;
+  std::vector<std::thread> m_workers;
+  bool m_stop;
+
+  const std::vector<RingSignatureJob>* m_jobs;
+  uint64_t m_batch;
+  size_t m_activeWorkers;
+  std::atomic<size_t> m_nextJob;
+  std::atomic<size_t> m_firstFailure;
+  RingSignatureCache m_cache;
+
+  RingSignatureVerifier(const RingSignatureVerifier&);
+  RingSignatureVerifier& operator=(const RingSignatureVerifier&);
+
+  void workerLoop();
+  size_t verifyBatch(const std::vector<RingSignatureJob>& jobs);
+  void processJobs(const std::vector<RingSignatureJob>& jobs);
+  static size_t verifySerial(const std::vector<RingSignatureJob>& jobs);
+};
+
+}
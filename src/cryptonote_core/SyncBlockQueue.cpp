@@ -0,0 +1,134 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SyncBlockQueue.h"
+
+#include <algorithm>
+
+namespace cryptonote {
+
+SyncBlockQueue::SyncBlockQueue(size_t capacity) : m_capacity(capacity), m_released(false), m_stop(false) {
+}
+
+bool SyncBlockQueue::full() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_claims.size() >= m_capacity;
+}
+
+bool SyncBlockQueue::idle() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_claims.empty();
+}
+
+bool SyncBlockQueue::claim(const crypto::hash& id, uint64_t height, const boost::uuids::uuid& connection, std::chrono::steady_clock::time_point now) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Claim claim = { connection, false, height, now };
+  return m_claims.emplace(id, claim).second;
+}
+
+void SyncBlockQueue::push(SyncBlock&& block) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_claims.find(block.id);
+    if (it == m_claims.end() || it->second.connection != block.source.m_connection_id) {
+      // the connection was released while the block was on its way
+      return;
+    }
+
+    it->second.queued = true;
+    uint64_t height = block.height;
+    m_blocks.emplace(height, std::move(block));
+  }
+
+  m_changed.notify_one();
+}
+
+bool SyncBlockQueue::canPop(uint64_t nextHeight) const {
+  return !m_blocks.empty() && m_blocks.begin()->first <= nextHeight;
+}
+
+bool SyncBlockQueue::pop(uint64_t nextHeight, size_t maxCount, std::vector<SyncBlock>& blocks, std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_changed.wait_for(lock, timeout, [this, nextHeight] { return m_stop || m_released || canPop(nextHeight); });
+  m_released = false;
+  if (m_stop) {
+    return false;
+  }
+
+  while (blocks.size() < maxCount && canPop(nextHeight)) {
+    auto it = m_blocks.begin();
+    nextHeight = std::max(nextHeight, it->first + 1);
+    blocks.push_back(std::move(it->second));
+    m_blocks.erase(it);
+  }
+
+  return !blocks.empty();
+}
+
+void SyncBlockQueue::complete(const crypto::hash& id) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_claims.erase(id);
+}
+
+void SyncBlockQueue::releaseConnection(const boost::uuids::uuid& connection) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+      if (it->second.source.m_connection_id == connection) {
+        it = m_blocks.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    for (auto it = m_claims.begin(); it != m_claims.end();) {
+      if (it->second.connection == connection) {
+        it = m_claims.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    m_waiting.erase(connection);
+    m_released = true;
+  }
+
+  m_changed.notify_one();
+}
+
+std::vector<boost::uuids::uuid> SyncBlockQueue::getStalledConnections(uint64_t nextHeight, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration timeout) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<boost::uuids::uuid> connections;
+  for (const auto& claim : m_claims) {
+    if (!claim.second.queued && claim.second.height == nextHeight && now - claim.second.time >= timeout) {
+      connections.push_back(claim.second.connection);
+    }
+  }
+
+  return connections;
+}
+
+void SyncBlockQueue::addWaiting(const boost::uuids::uuid& connection) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_waiting.insert(connection);
+}
+
+std::set<boost::uuids::uuid> SyncBlockQueue::takeWaiting() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::set<boost::uuids::uuid> waiting;
+  waiting.swap(m_waiting);
+  return waiting;
+}
+
+void SyncBlockQueue::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_changed.notify_all();
+}
+
+}
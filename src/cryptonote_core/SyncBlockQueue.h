@@ -0,0 +1,87 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "net/net_utils_base.h"
+
+#include "crypto/hash.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+
+namespace cryptonote {
+
+struct SyncBlock {
+  uint64_t height;
+  crypto::hash id;
+  block_complete_entry entry;
+  epee::net_utils::connection_context_base source;
+};
+
+// Blocks downloaded during synchronization on their way from the connections to the validation thread.
+// A block is claimed by one connection before it is requested, so connections download disjoint sets of blocks.
+// Downloaded blocks are kept ordered by height and handed out only when the block below them is in the chain,
+// whichever connection they came from. The claim is held until the block is validated, the number of claims
+// bounds both the blocks in flight and the blocks waiting for validation.
+class SyncBlockQueue {
+public:
+  explicit SyncBlockQueue(size_t capacity);
+
+  bool full() const;
+  // True if no block is requested or waiting for validation.
+  bool idle() const;
+
+  // Returns false if another connection has claimed the block already.
+  bool claim(const crypto::hash& id, uint64_t height, const boost::uuids::uuid& connection, std::chrono::steady_clock::time_point now);
+  void push(SyncBlock&& block);
+
+  // Waits up to timeout for blocks to validate, nextHeight is the height of the next block of the chain. Hands out
+  // the queued blocks from the lowest height up as long as their heights follow without a gap, at most maxCount.
+  bool pop(uint64_t nextHeight, size_t maxCount, std::vector<SyncBlock>& blocks, std::chrono::milliseconds timeout);
+  // Releases the claim of a block handed out by pop.
+  void complete(const crypto::hash& id);
+
+  // Forgets the claims of the connection and the queued blocks it delivered.
+  void releaseConnection(const boost::uuids::uuid& connection);
+  // Connections that claimed a block at nextHeight longer than timeout ago and did not deliver it, the chain waits for them.
+  std::vector<boost::uuids::uuid> getStalledConnections(uint64_t nextHeight, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration timeout) const;
+
+  // Connections with nothing to request until blocks are validated or claims released.
+  void addWaiting(const boost::uuids::uuid& connection);
+  std::set<boost::uuids::uuid> takeWaiting();
+
+  void stop();
+
+private:
+  struct Claim {
+    boost::uuids::uuid connection;
+    bool queued;
+    uint64_t height;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  const size_t m_capacity;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::unordered_map<crypto::hash, Claim> m_claims;
+  std::multimap<uint64_t, SyncBlock> m_blocks;
+  std::set<boost::uuids::uuid> m_waiting;
+  bool m_released;
+  bool m_stop;
+
+  bool canPop(uint64_t nextHeight) const;
+};
+
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SyncPeerScores.h"
+
+#include <algorithm>
+
+namespace cryptonote {
+
+namespace {
+
+// weight of the newest measurement in the moving averages
+const uint64_t AVERAGE_DIVISOR = 4;
+// a failed request outweighs this many good responses
+const double FAILURE_WEIGHT = 4;
+// peers with a score this many times below the best one are slow
+const double SLOW_PEER_FACTOR = 4;
+
+bool isMeasured(const SyncPeerScores::PeerStats& stats) {
+  return stats.responses != 0 || stats.invalid != 0 || stats.stalls != 0;
+}
+
+}
+
+SyncPeerScores::SyncPeerScores(size_t disconnectedLimit) : m_disconnectedLimit(disconnectedLimit) {
+}
+
+void SyncPeerScores::addConnection(uint32_t address) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto disconnectedIt = m_disconnectedIndex.find(address);
+  if (disconnectedIt != m_disconnectedIndex.end()) {
+    m_peers[address] = disconnectedIt->second->second;
+    m_disconnected.erase(disconnectedIt->second);
+    m_disconnectedIndex.erase(disconnectedIt);
+  }
+
+  //new entries are value initialized, all zero
+  ++m_peers[address].connections;
+}
+
+void SyncPeerScores::removeConnection(uint32_t address) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it == m_peers.end() || --it->second.connections != 0) {
+    return;
+  }
+
+  //measured peers are remembered for the next connection
+  if (isMeasured(it->second)) {
+    m_disconnectedIndex[address] = m_disconnected.insert(m_disconnected.end(), *it);
+    if (m_disconnected.size() > m_disconnectedLimit) {
+      m_disconnectedIndex.erase(m_disconnected.front().first);
+      m_disconnected.pop_front();
+    }
+  }
+
+  m_peers.erase(it);
+}
+
+void SyncPeerScores::addResponse(uint32_t address, std::chrono::steady_clock::duration roundTrip, std::chrono::steady_clock::duration transferTime, uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it == m_peers.end()) {
+    return;
+  }
+
+  PeerStats& stats = it->second;
+  auto roundTripMs = std::chrono::duration_cast<std::chrono::milliseconds>(roundTrip);
+  //a response that came at once is counted as taking a millisecond
+  uint64_t transferMs = std::max<uint64_t>(1, std::chrono::duration_cast<std::chrono::milliseconds>(transferTime).count());
+  uint64_t bytesPerSecond = bytes * 1000 / transferMs;
+
+  if (stats.responses == 0) {
+    stats.roundTrip = roundTripMs;
+    stats.bytesPerSecond = bytesPerSecond;
+  } else {
+    stats.roundTrip += (roundTripMs - stats.roundTrip) / AVERAGE_DIVISOR;
+    stats.bytesPerSecond = stats.bytesPerSecond - stats.bytesPerSecond / AVERAGE_DIVISOR + bytesPerSecond / AVERAGE_DIVISOR;
+  }
+
+  ++stats.responses;
+  updateScore(stats);
+}
+
+void SyncPeerScores::addInvalid(uint32_t address) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it != m_peers.end()) {
+    ++it->second.invalid;
+    updateScore(it->second);
+  }
+}
+
+void SyncPeerScores::addStall(uint32_t address) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it != m_peers.end()) {
+    ++it->second.stalls;
+    updateScore(it->second);
+  }
+}
+
+double SyncPeerScores::score(uint32_t address) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it == m_peers.end() || !isMeasured(it->second)) {
+    return averageScore();
+  }
+
+  return it->second.score;
+}
+
+bool SyncPeerScores::isSlow(uint32_t address) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_peers.find(address);
+  if (it == m_peers.end() || !isMeasured(it->second)) {
+    return false;
+  }
+
+  return it->second.score * SLOW_PEER_FACTOR < bestScore();
+}
+
+std::vector<std::pair<uint32_t, SyncPeerScores::PeerStats>> SyncPeerScores::getStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  double average = averageScore();
+  std::vector<std::pair<uint32_t, PeerStats>> stats;
+  for (const auto& peer : m_peers) {
+    stats.push_back(peer);
+    if (!isMeasured(peer.second)) {
+      stats.back().second.score = average;
+    }
+  }
+
+  stats.insert(stats.end(), m_disconnected.begin(), m_disconnected.end());
+
+  std::stable_sort(stats.begin(), stats.end(), [](const std::pair<uint32_t, PeerStats>& a, const std::pair<uint32_t, PeerStats>& b) {
+    return a.second.score > b.second.score;
+  });
+
+  return stats;
+}
+
+void SyncPeerScores::updateScore(PeerStats& stats) {
+  double failures = static_cast<double>(stats.invalid + stats.stalls);
+  double responses = static_cast<double>(stats.responses);
+  stats.score = stats.responses == 0 ? 0 : stats.bytesPerSecond * responses / (responses + FAILURE_WEIGHT * failures);
+}
+
+double SyncPeerScores::averageScore() const {
+  double sum = 0;
+  size_t count = 0;
+  for (const auto& peer : m_peers) {
+    if (isMeasured(peer.second)) {
+      sum += peer.second.score;
+      ++count;
+    }
+  }
+
+  return count == 0 ? 0 : sum / count;
+}
+
+double SyncPeerScores::bestScore() const {
+  double best = 0;
+  for (const auto& peer : m_peers) {
+    if (isMeasured(peer.second)) {
+      best = std::max(best, peer.second.score);
+    }
+  }
+
+  return best;
+}
+
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cryptonote {
+
+// How well the peers serve blocks during synchronization, by remote address so the measurements outlive reconnects.
+// Every response to a block request updates the round trip time and the throughput of the peer as moving averages,
+// invalid data and stalled requests count against it. The score is the throughput discounted by the share of failed
+// requests. Peers without measurements score as the average of the measured connected ones, so new peers get tried.
+// The measurements of at most disconnectedLimit disconnected peers are kept, the least recently disconnected are
+// forgotten first.
+class SyncPeerScores {
+public:
+  struct PeerStats {
+    uint32_t connections;
+    uint64_t responses;
+    uint64_t invalid;
+    uint64_t stalls;
+    std::chrono::milliseconds roundTrip;
+    uint64_t bytesPerSecond;
+    double score;
+  };
+
+  explicit SyncPeerScores(size_t disconnectedLimit);
+
+  void addConnection(uint32_t address);
+  void removeConnection(uint32_t address);
+
+  // transferTime is the part of the round trip the response was on its way, without the wait for earlier responses.
+  void addResponse(uint32_t address, std::chrono::steady_clock::duration roundTrip, std::chrono::steady_clock::duration transferTime, uint64_t bytes);
+  void addInvalid(uint32_t address);
+  void addStall(uint32_t address);
+
+  double score(uint32_t address) const;
+  // True if the peer delivers several times slower than the best connected one.
+  bool isSlow(uint32_t address) const;
+
+  // Best score first.
+  std::vector<std::pair<uint32_t, PeerStats>> getStats() const;
+
+private:
+  typedef std::list<std::pair<uint32_t, PeerStats>> DisconnectedPeers;
+
+  const size_t m_disconnectedLimit;
+  mutable std::mutex m_mutex;
+  // peers with connections
+  std::map<uint32_t, PeerStats> m_peers;
+  // measured peers without connections, least recently disconnected first
+  DisconnectedPeers m_disconnected;
+  std::unordered_map<uint32_t, DisconnectedPeers::iterator> m_disconnectedIndex;
+
+  void updateScore(PeerStats& stats);
+  double averageScore() const;
+  double bestScore() const;
+};
+
+}
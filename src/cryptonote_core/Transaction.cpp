@@ -256,6 +256,7 @@ namespace CryptoNote {
   }
 
   void TransactionImpl::invalidateHash() {
+    transaction.invalidateHashes();
     if (transactionHash.is_initialized()) {
       transactionHash = decltype(transactionHash)();
     }
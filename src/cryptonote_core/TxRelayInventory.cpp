@@ -0,0 +1,142 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TxRelayInventory.h"
+
+#include <algorithm>
+
+namespace cryptonote {
+
+bool TxRelayInventory::KnownIds::contains(const crypto::hash& id) const {
+  return current.count(id) != 0 || previous.count(id) != 0;
+}
+
+void TxRelayInventory::KnownIds::insert(const crypto::hash& id, size_t limit) {
+  if (current.size() >= limit) {
+    previous.swap(current);
+    current.clear();
+  }
+
+  current.insert(id);
+}
+
+TxRelayInventory::TxRelayInventory(size_t knownLimit, std::chrono::steady_clock::duration requestTimeout) :
+  m_knownLimit(knownLimit), m_requestTimeout(requestTimeout) {
+}
+
+void TxRelayInventory::addConnection(const boost::uuids::uuid& connection) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_known[connection];
+}
+
+void TxRelayInventory::removeConnection(const boost::uuids::uuid& connection) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_known.erase(connection);
+
+  //the transactions requested from the peer are requested from the next announcer
+  for (auto& requested : m_requested) {
+    Request& request = requested.second;
+    if (request.connection == connection) {
+      request.deadline = std::chrono::steady_clock::time_point::min();
+    }
+
+    request.announcers.erase(std::remove(request.announcers.begin(), request.announcers.end(), connection), request.announcers.end());
+  }
+}
+
+void TxRelayInventory::addKnown(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_known.find(connection);
+  if (it == m_known.end()) {
+    return;
+  }
+
+  for (const crypto::hash& id : ids) {
+    if (!it->second.contains(id)) {
+      it->second.insert(id, m_knownLimit);
+    }
+  }
+}
+
+void TxRelayInventory::takeUnknown(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids, std::vector<crypto::hash>& unknown) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_known.find(connection);
+  if (it == m_known.end()) {
+    unknown.insert(unknown.end(), ids.begin(), ids.end());
+    return;
+  }
+
+  for (const crypto::hash& id : ids) {
+    if (!it->second.contains(id)) {
+      it->second.insert(id, m_knownLimit);
+      unknown.push_back(id);
+    }
+  }
+}
+
+void TxRelayInventory::queue(const std::vector<crypto::hash>& ids) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queued.insert(m_queued.end(), ids.begin(), ids.end());
+}
+
+std::vector<crypto::hash> TxRelayInventory::takeQueued() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<crypto::hash> ids;
+  ids.swap(m_queued);
+  return ids;
+}
+
+void TxRelayInventory::takeRequests(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids, std::chrono::steady_clock::time_point now, std::vector<crypto::hash>& request) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const crypto::hash& id : ids) {
+    auto result = m_requested.emplace(id, Request());
+    Request& entry = result.first->second;
+    if (result.second) {
+      entry.connection = connection;
+      entry.deadline = now + m_requestTimeout;
+      request.push_back(id);
+    } else if (entry.connection != connection &&
+      std::find(entry.announcers.begin(), entry.announcers.end(), connection) == entry.announcers.end()) {
+      entry.announcers.push_back(connection);
+    }
+  }
+}
+
+void TxRelayInventory::received(const std::vector<crypto::hash>& ids) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const crypto::hash& id : ids) {
+    m_requested.erase(id);
+  }
+}
+
+void TxRelayInventory::missed(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const crypto::hash& id : ids) {
+    auto it = m_requested.find(id);
+    if (it != m_requested.end() && it->second.connection == connection) {
+      it->second.deadline = std::chrono::steady_clock::time_point::min();
+    }
+  }
+}
+
+void TxRelayInventory::takeExpiredRequests(std::chrono::steady_clock::time_point now, std::map<boost::uuids::uuid, std::vector<crypto::hash>>& requests) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_requested.begin(); it != m_requested.end();) {
+    Request& request = it->second;
+    if (now < request.deadline) {
+      ++it;
+    } else if (request.announcers.empty()) {
+      it = m_requested.erase(it);
+    } else {
+      request.connection = request.announcers.front();
+      request.deadline = now + m_requestTimeout;
+      request.announcers.erase(request.announcers.begin());
+      requests[request.connection].push_back(it->first);
+      ++it;
+    }
+  }
+}
+
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+
+namespace cryptonote {
+
+// Bookkeeping of the transaction relay by inventory: new transactions are announced to the peers by id, in batches,
+// and sent only to the peers that request them. For every connection the ids known to the peer are remembered, the
+// ones it announced or sent and the ones announced or sent to it, so no transaction is offered to a peer twice or back
+// to the peer it came from. They are kept in two generations of at most knownLimit ids, the older one is forgotten
+// when the newer one is full. A transaction announced by several peers is requested from the first one only, the others
+// are remembered in the order of their announcements. When the transaction does not arrive within the request timeout,
+// the peer answers that it misses it or disconnects, it is requested from the next announcer.
+class TxRelayInventory {
+public:
+  TxRelayInventory(size_t knownLimit, std::chrono::steady_clock::duration requestTimeout);
+
+  void addConnection(const boost::uuids::uuid& connection);
+  void removeConnection(const boost::uuids::uuid& connection);
+
+  // The peer has the transactions, it announced or sent them.
+  void addKnown(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids);
+  // Appends the ids not known to the peer to unknown, they are known to it from now on. Nothing is remembered for
+  // connections that were not added, all ids are unknown to them.
+  void takeUnknown(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids, std::vector<crypto::hash>& unknown);
+
+  // Transactions to announce with the next batch.
+  void queue(const std::vector<crypto::hash>& ids);
+  std::vector<crypto::hash> takeQueued();
+
+  // The peer announced the transactions. Appends the ids not requested yet to request, they count as requested from
+  // the peer from now on. For the others the peer is remembered as an announcer.
+  void takeRequests(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids, std::chrono::steady_clock::time_point now, std::vector<crypto::hash>& request);
+  void received(const std::vector<crypto::hash>& ids);
+  // The peer answered that it does not have the transactions, their requests expire.
+  void missed(const boost::uuids::uuid& connection, const std::vector<crypto::hash>& ids);
+  // Moves the expired requests to the next announcer and appends their ids to requests, by connection. Requests without
+  // announcers left are forgotten.
+  void takeExpiredRequests(std::chrono::steady_clock::time_point now, std::map<boost::uuids::uuid, std::vector<crypto::hash>>& requests);
+
+private:
+  struct KnownIds {
+    std::unordered_set<crypto::hash> current;
+    std::unordered_set<crypto::hash> previous;
+
+    bool contains(const crypto::hash& id) const;
+    void insert(const crypto::hash& id, size_t limit);
+  };
+
+  struct Request {
+    boost::uuids::uuid connection;
+    std::chrono::steady_clock::time_point deadline;
+    std::vector<boost::uuids::uuid> announcers;
+  };
+
+  const size_t m_knownLimit;
+  const std::chrono::steady_clock::duration m_requestTimeout;
+  std::mutex m_mutex;
+  std::map<boost::uuids::uuid, KnownIds> m_known;
+  std::vector<crypto::hash> m_queued;
+  std::unordered_map<crypto::hash, Request> m_requested;
+};
+
+}
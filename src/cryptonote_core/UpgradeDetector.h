@@ -25,6 +25,18 @@ namespace cryptonote {
 
   static_assert(cryptonote::UpgradeDetectorBase::UNDEF_HEIGHT == UINT64_C(0xFFFFFFFFFFFFFFFF), "UpgradeDetectorBase::UNDEF_HEIGHT has invalid value");
 
+  // Reads block versions from the blocks of BC, specialized for chains that keep the versions apart.
+  template <typename BC>
+  struct BlockVersionReader {
+    static uint8_t majorVersion(const BC& blockchain, uint64_t height) {
+      return blockchain[height].bl.majorVersion;
+    }
+
+    static uint8_t minorVersion(const BC& blockchain, uint64_t height) {
+      return blockchain[height].bl.minorVersion;
+    }
+  };
+
   template <typename BC>
   class BasicUpgradeDetector : public UpgradeDetectorBase {
   public:
@@ -40,15 +52,24 @@ namespace cryptonote {
         if (m_blockchain.empty()) {
           m_votingCompleteHeight = UNDEF_HEIGHT;
 
-        } else if (m_targetVersion - 1 == m_blockchain.back().bl.majorVersion) {
+        } else if (m_targetVersion - 1 == majorVersion(m_blockchain.size() - 1)) {
           m_votingCompleteHeight = findVotingCompleteHeight(m_blockchain.size() - 1);
 
-        } else if (m_targetVersion <= m_blockchain.back().bl.majorVersion) {
-          auto it = std::lower_bound(m_blockchain.begin(), m_blockchain.end(), m_targetVersion,
-            [](const typename BC::value_type& b, uint8_t v) { return b.bl.majorVersion < v; });
-          CHECK_AND_ASSERT_MES(it != m_blockchain.end() && it->bl.majorVersion == m_targetVersion, false,
+        } else if (m_targetVersion <= majorVersion(m_blockchain.size() - 1)) {
+          // versions never decrease along the chain, the first block of the target version is the upgrade height
+          uint64_t upgradeHeight = 0;
+          uint64_t end = m_blockchain.size();
+          while (upgradeHeight < end) {
+            uint64_t middle = upgradeHeight + (end - upgradeHeight) / 2;
+            if (majorVersion(middle) < m_targetVersion) {
+              upgradeHeight = middle + 1;
+            } else {
+              end = middle;
+            }
+          }
+
+          CHECK_AND_ASSERT_MES(upgradeHeight < m_blockchain.size() && majorVersion(upgradeHeight) == m_targetVersion, false,
             "Internal error: upgrade height isn't found");
-          uint64_t upgradeHeight = it - m_blockchain.begin();
           m_votingCompleteHeight = findVotingCompleteHeight(upgradeHeight);
           CHECK_AND_ASSERT_MES(m_votingCompleteHeight != UNDEF_HEIGHT, false,
             "Internal error: voting complete height isn't found, upgrade height = " << upgradeHeight);
@@ -58,16 +79,16 @@ namespace cryptonote {
         }
       } else if (!m_blockchain.empty()) {
         if (m_blockchain.size() <= m_currency.upgradeHeight() + 1) {
-          CHECK_AND_ASSERT_MES(m_blockchain.back().bl.majorVersion == m_targetVersion - 1, false,
+          CHECK_AND_ASSERT_MES(majorVersion(m_blockchain.size() - 1) == m_targetVersion - 1, false,
             "Internal error: block at height " << (m_blockchain.size() - 1) << " has invalid version " <<
-            static_cast<int>(m_blockchain.back().bl.majorVersion) << ", expected " << static_cast<int>(m_targetVersion));
+            static_cast<int>(majorVersion(m_blockchain.size() - 1)) << ", expected " << static_cast<int>(m_targetVersion));
         } else {
-          int blockVersionAtUpgradeHeight = m_blockchain[m_currency.upgradeHeight()].bl.majorVersion;
+          int blockVersionAtUpgradeHeight = majorVersion(m_currency.upgradeHeight());
           CHECK_AND_ASSERT_MES(blockVersionAtUpgradeHeight == m_targetVersion - 1, false,
             "Internal error: block at height " << m_currency.upgradeHeight() << " has invalid version " <<
             blockVersionAtUpgradeHeight << ", expected " << static_cast<int>(m_targetVersion - 1));
 
-          int blockVersionAfterUpgradeHeight = m_blockchain[m_currency.upgradeHeight() + 1].bl.majorVersion;
+          int blockVersionAfterUpgradeHeight = majorVersion(m_currency.upgradeHeight() + 1);
           CHECK_AND_ASSERT_MES(blockVersionAfterUpgradeHeight == m_targetVersion, false,
             "Internal error: block at height " << (m_currency.upgradeHeight() + 1) << " has invalid version " <<
             blockVersionAfterUpgradeHeight << ", expected " << static_cast<int>(m_targetVersion));
@@ -93,27 +114,27 @@ namespace cryptonote {
 
       if (m_currency.upgradeHeight() != UNDEF_HEIGHT) {
         if (m_blockchain.size() <= m_currency.upgradeHeight() + 1) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(majorVersion(m_blockchain.size() - 1) == m_targetVersion - 1);
         } else {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion);
+          assert(majorVersion(m_blockchain.size() - 1) == m_targetVersion);
         }
 
       } else if (m_votingCompleteHeight != UNDEF_HEIGHT) {
         assert(m_blockchain.size() > m_votingCompleteHeight);
 
         if (m_blockchain.size() <= upgradeHeight()) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(majorVersion(m_blockchain.size() - 1) == m_targetVersion - 1);
 
           if (m_blockchain.size() % (60 * 60 / m_currency.difficultyTarget()) == 0) {
             LOG_PRINT_GREEN("###### UPGRADE is going to happen after height " << upgradeHeight() << "!", LOG_LEVEL_2);
           }
         } else if (m_blockchain.size() == upgradeHeight() + 1) {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion - 1);
+          assert(majorVersion(m_blockchain.size() - 1) == m_targetVersion - 1);
 
           LOG_PRINT_GREEN("###### UPGRADE has happened! Starting from height " << (upgradeHeight() + 1) <<
             " blocks with major version below " << static_cast<int>(m_targetVersion) << " will be rejected!", LOG_LEVEL_2);
         } else {
-          assert(m_blockchain.back().bl.majorVersion == m_targetVersion);
+          assert(majorVersion(m_blockchain.size() - 1) == m_targetVersion);
         }
 
       } else {
@@ -165,13 +186,20 @@ namespace cryptonote {
 
       unsigned int voteCounter = 0;
       for (size_t i = height + 1 - m_currency.upgradeVotingWindow(); i <= height; ++i) {
-        const auto& b = m_blockchain[i].bl;
-        voteCounter += (b.majorVersion == m_targetVersion - 1) && (b.minorVersion == BLOCK_MINOR_VERSION_1) ? 1 : 0;
+        voteCounter += (majorVersion(i) == m_targetVersion - 1) && (minorVersion(i) == BLOCK_MINOR_VERSION_1) ? 1 : 0;
       }
 
       return m_currency.upgradeVotingThreshold() * m_currency.upgradeVotingWindow() <= 100 * voteCounter;
     }
 
+    uint8_t majorVersion(uint64_t height) const {
+      return BlockVersionReader<BC>::majorVersion(m_blockchain, height);
+    }
+
+    uint8_t minorVersion(uint64_t height) const {
+      return BlockVersionReader<BC>::minorVersion(m_blockchain, height);
+    }
+
   private:
     const Currency& m_currency;
     BC& m_blockchain;
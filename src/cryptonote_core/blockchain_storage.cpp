@@ -8,6 +8,9 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <deque>
+#include <future>
+#include <thread>
 
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
@@ -20,6 +23,7 @@
 
 #include "common/boost_serialization_helper.h"
 #include "common/ShuffleGenerator.h"
+#include "BlockEntryBlob.h"
 #include "cryptonote_format_utils.h"
 #include "cryptonote_boost_serialization.h"
 #include "rpc/core_rpc_server_commands_defs.h"
@@ -34,6 +38,40 @@ namespace {
     result += fileName;
     return result;
   }
+
+  // The files of the cache are written under temporary names first and swapped in once all of them are complete.
+  std::string tempFileName(const std::string& fileName) {
+    return fileName + ".tmp";
+  }
+
+  bool swapInFiles(const std::vector<std::string>& fileNames) {
+    for (const std::string& fileName : fileNames) {
+      std::error_code ec = tools::replace_file(tempFileName(fileName), fileName);
+      if (ec) {
+        LOG_ERROR("Failed to replace " << fileName << ": " << ec.message());
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // A crash while the files are swapped in leaves some of them under the temporary name, every file names the height
+  // and the last block it describes, so the one that matches the cache is taken. The names left to swap in are appended
+  // to unswapped.
+  template<class Index> bool loadIndexFile(Index& index, const std::string& fileName, uint64_t height, const crypto::hash& lastBlockHash,
+    std::vector<std::string>& unswapped) {
+    if (index.load(fileName, height, lastBlockHash)) {
+      return true;
+    }
+
+    if (index.load(tempFileName(fileName), height, lastBlockHash)) {
+      unswapped.push_back(fileName);
+      return true;
+    }
+
+    return false;
+  }
 }
 
 namespace std {
@@ -72,6 +110,12 @@ template<class Archive> void cryptonote::blockchain_storage::TransactionIndex::s
   archive & transaction;
 }
 
+template<class Archive> void cryptonote::blockchain_storage::KeyOutputInfo::serialize(Archive& archive, unsigned int version) {
+  archive & key;
+  archive & unlockTime;
+  archive & height;
+}
+
 template<class Archive> void cryptonote::blockchain_storage::MultisignatureOutputUsage::serialize(Archive& archive, unsigned int version) {
   archive & transactionIndex;
   archive & outputIndex;
@@ -81,49 +125,56 @@ template<class Archive> void cryptonote::blockchain_storage::MultisignatureOutpu
 namespace cryptonote
 {
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 1
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 6
 
   class BlockCacheSerializer {
 
   public:
-    BlockCacheSerializer(blockchain_storage& bs, const crypto::hash lastBlockHash) :
-      m_bs(bs), m_lastBlockHash(lastBlockHash), m_loaded(false) {}
+    BlockCacheSerializer(blockchain_storage& bs) :
+      m_bs(bs), m_snapshot(nullptr), m_height(0), m_blockIndex(bs.m_blockIndex),
+      m_multisignatureOutputs(bs.m_multisignatureOutputs), m_loaded(false) {}
+
+    BlockCacheSerializer(blockchain_storage& bs, blockchain_storage::CacheSnapshot& snapshot) :
+      m_bs(bs), m_snapshot(&snapshot), m_lastBlockHash(snapshot.lastBlockHash), m_height(snapshot.height),
+      m_blockIndex(snapshot.blockIndex), m_multisignatureOutputs(snapshot.multisignatureOutputs), m_loaded(false) {}
 
     template<class Archive> void serialize(Archive& ar, unsigned int version) {
 
-      // ignore old versions, do rebuild
-      if (version < CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER)
+      // older caches lack indexes that only a walk over all the blocks restores, they are not migrated
+      if (version < CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER) {
+        LOG_PRINT_L0("Blockchain cache was written by an older version (format " << version << "), it is rebuilt from the stored blocks");
         return;
+      }
 
       std::string operation;
       if (Archive::is_loading::value) {
         operation = "- loading ";
-        crypto::hash blockHash;
-        ar & blockHash;
+        ar & m_lastBlockHash;
+        ar & m_height;
 
-        if (blockHash != m_lastBlockHash) {
+        // the cache is usable only if it describes a prefix of the stored chain
+        if (m_height == 0 || m_height > m_bs.m_blocks.size() || m_lastBlockHash != get_block_hash(m_bs.m_blocks[m_height - 1]->bl)) {
           return;
         }
 
       } else {
         operation = "- saving ";
         ar & m_lastBlockHash;
+        ar & m_height;
       }
 
       LOG_PRINT_L0(operation << "block index...");
-      ar & m_bs.m_blockIndex;
-
-      LOG_PRINT_L0(operation << "transaction map...");
-      ar & m_bs.m_transactionMap;
-
-      LOG_PRINT_L0(operation << "spend keys...");
-      ar & m_bs.m_spent_keys;
+      ar & m_blockIndex;
 
+      // the transaction map and the spent keys are stored in their own files, see blockchain_storage::storeCache
       LOG_PRINT_L0(operation << "outputs...");
-      ar & m_bs.m_outputs;
+      serializeAmounts(ar, m_bs.m_outputs, m_snapshot != nullptr ? &m_snapshot->outputs : nullptr);
+
+      LOG_PRINT_L0(operation << "key outputs...");
+      serializeAmounts(ar, m_bs.m_keyOutputs, m_snapshot != nullptr ? &m_snapshot->keyOutputs : nullptr);
 
       LOG_PRINT_L0(operation << "multi-signature outputs...");
-      ar & m_bs.m_multisignatureOutputs;
+      ar & m_multisignatureOutputs;
 
       m_loaded = true;
     }
@@ -132,11 +183,45 @@ namespace cryptonote
       return m_loaded;
     }
 
+    uint64_t height() const {
+      return m_height;
+    }
+
+    const crypto::hash& lastBlockHash() const {
+      return m_lastBlockHash;
+    }
+
   private:
 
+    // The outputs are stored as their count followed by the pairs of an amount and its outputs. They are loaded into
+    // the hash map of the blockchain and saved from the vector of the snapshot.
+    template<class Archive, class Container> static void serializeAmounts(Archive& ar, Container& container,
+      std::vector<std::pair<uint64_t, typename Container::mapped_type>>* amounts) {
+      uint64_t count = amounts != nullptr ? amounts->size() : 0;
+      ar & count;
+      if (Archive::is_loading::value) {
+        container.clear();
+        container.resize(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i) {
+          uint64_t amount;
+          ar & amount;
+          ar & container[amount];
+        }
+      } else {
+        for (auto& amountOutputs : *amounts) {
+          ar & amountOutputs.first;
+          ar & amountOutputs.second;
+        }
+      }
+    }
+
     bool m_loaded;
     blockchain_storage& m_bs;
+    blockchain_storage::CacheSnapshot* m_snapshot;
     crypto::hash m_lastBlockHash;
+    uint64_t m_height;
+    CryptoNote::BlockIndex& m_blockIndex;
+    blockchain_storage::MultisignatureOutputsContainer& m_multisignatureOutputs;
   };
 }
 
@@ -146,14 +231,14 @@ BOOST_CLASS_VERSION(cryptonote::BlockCacheSerializer, CURRENT_BLOCKCACHE_STORAGE
 blockchain_storage::blockchain_storage(const Currency& currency, tx_memory_pool& tx_pool):
       m_currency(currency),
       m_tx_pool(tx_pool),
+      m_signatureVerifier(RingSignatureVerifier::defaultWorkerCount(), RING_SIGNATURE_CACHE_SIZE),
       m_current_block_cumul_sz_limit(0),
       m_is_in_checkpoint_zone(false),
       m_is_blockchain_storing(false),
-      m_upgradeDetector(currency, m_blocks, BLOCK_MAJOR_VERSION_2) {
+      m_storedCacheHeight(0),
+      m_upgradeDetector(currency, m_headers, BLOCK_MAJOR_VERSION_2) {
   m_outputs.set_deleted_key(0);
-
-  crypto::key_image nullImage = AUTO_VAL_INIT(nullImage);
-  m_spent_keys.set_deleted_key(nullImage);
+  m_keyOutputs.set_deleted_key(0);
 }
 
 bool blockchain_storage::addObserver(IBlockchainStorageObserver* observer) {
@@ -164,6 +249,16 @@ bool blockchain_storage::removeObserver(IBlockchainStorageObserver* observer) {
   return m_observerManager.remove(observer);
 }
 
+bool blockchain_storage::isInCheckpointZone() const {
+  return m_is_in_checkpoint_zone;
+}
+
+void blockchain_storage::set_checkpoints(checkpoints&& chk_pts) {
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  m_checkpoints = chk_pts;
+  updateCheckpointZone();
+}
+
 bool blockchain_storage::checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock) {
   return check_tx_inputs(tx, maxUsedBlock.height, maxUsedBlock.id) && check_tx_outputs(tx);
 }
@@ -212,17 +307,17 @@ bool blockchain_storage::haveSpentKeyImages(const cryptonote::Transaction& tx) {
 }
 
 bool blockchain_storage::have_tx(const crypto::hash &id) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  return m_transactionMap.find(id) != m_transactionMap.end();
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  return m_transactionMap.find(id) != nullptr;
 }
 
 bool blockchain_storage::have_tx_keyimg_as_spent(const crypto::key_image &key_im) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  return  m_spent_keys.find(key_im) != m_spent_keys.end();
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  return m_spent_keys.contains(key_im);
 }
 
 uint64_t blockchain_storage::get_current_blockchain_height() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blocks.size();
 }
 
@@ -235,66 +330,35 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
 
   m_config_folder = config_folder;
 
-  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
+  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), BLOCKCHAIN_STORAGE_CACHE_SIZE)) {
     return false;
   }
 
+  updateCheckpointZone();
+
   if (load_existing) {
     LOG_PRINT_L0("Loading blockchain...");
 
     if (m_blocks.empty()) {
       LOG_PRINT_L0("Can't load blockchain storage from file.");
     } else {
-      BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl));
-      tools::unserialize_obj_from_file(loader, appendPath(config_folder, m_currency.blocksCacheFileName()));
-
-      if (!loader.loaded()) {
+      uint64_t cachedHeight = loadCache();
+      if (cachedHeight == 0) {
         LOG_PRINT_L0("No actual blockchain cache found, rebuilding internal structures...");
-        std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
-        m_blockIndex.clear();
-        m_transactionMap.clear();
-        m_spent_keys.clear();
-        m_outputs.clear();
-        m_multisignatureOutputs.clear();
-        for (uint32_t b = 0; b < m_blocks.size(); ++b) {
-          if (b % 1000 == 0) {
-            std::cout << "Height " << b << " of " << m_blocks.size() << '\r';
-          }
-          const BlockEntry& block = m_blocks[b];
-          crypto::hash blockHash = get_block_hash(block.bl);
-          m_blockIndex.push(blockHash);
-          for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-            const TransactionEntry& transaction = block.transactions[t];
-            crypto::hash transactionHash = get_transaction_hash(transaction.tx);
-            TransactionIndex transactionIndex = { b, t };
-            m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-
-            // process inputs
-            for (auto& i : transaction.tx.vin) {
-              if (i.type() == typeid(TransactionInputToKey)) {
-                m_spent_keys.insert(::boost::get<TransactionInputToKey>(i).keyImage);
-              } else if (i.type() == typeid(TransactionInputMultisignature)) {
-                auto out = ::boost::get<TransactionInputMultisignature>(i);
-                m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
-              }
-            }
-
-            // process outputs
-            for (uint16_t o = 0; o < transaction.tx.vout.size(); ++o) {
-              const auto& out = transaction.tx.vout[o];
-              if(out.target.type() == typeid(TransactionOutputToKey)) {
-                m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
-              } else if (out.target.type() == typeid(TransactionOutputMultisignature)) {
-                MultisignatureOutputUsage usage = { transactionIndex, o, false };
-                m_multisignatureOutputs[out.amount].push_back(usage);
-              }
-            }
-          }
-        }
+      } else if (cachedHeight < m_blocks.size()) {
+        LOG_PRINT_L0("Blockchain cache is behind the stored chain, replaying blocks from height " << cachedHeight << "...");
+      }
 
+      if (cachedHeight < m_blocks.size()) {
+        std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+        uint64_t blockCount = m_blocks.size() - cachedHeight;
+        rebuildCache(static_cast<uint32_t>(cachedHeight));
         std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
-        LOG_PRINT_L0("Rebuilding internal structures took: " << duration.count());
+        LOG_PRINT_L0("Rebuilding internal structures took: " << duration.count() << " sec, " <<
+          static_cast<uint64_t>(blockCount / std::max(duration.count(), 0.001)) << " blocks per second");
       }
+
+      m_storedCacheHeight = cachedHeight;
     }
   } else {
     m_blocks.clear();
@@ -306,7 +370,7 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
     add_new_block(m_currency.genesisBlock(), bvc);
     CHECK_AND_ASSERT_MES(!bvc.m_verifivation_failed, false, "Failed to add genesis block to blockchain");
   } else {
-    crypto::hash firstBlockHash = get_block_hash(m_blocks[0].bl);
+    crypto::hash firstBlockHash = get_block_hash(m_blocks[0]->bl);
     CHECK_AND_ASSERT_MES(firstBlockHash == m_currency.genesisBlockHash(), false,
       "Failed to init: genesis block mismatch. Probably you set --testnet flag with data dir with non-test blockchain or another network.");
   }
@@ -317,9 +381,10 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
   }
 
   update_next_comulative_size_limit();
+  updateCheckpointZone();
 
-  uint64_t timestamp_diff = time(NULL) - m_blocks.back().bl.timestamp;
-  if (!m_blocks.back().bl.timestamp) {
+  uint64_t timestamp_diff = time(NULL) - m_headers.timestamps().back();
+  if (!m_headers.timestamps().back()) {
     timestamp_diff = time(NULL) - 1341378000;
   }
 
@@ -327,19 +392,230 @@ bool blockchain_storage::init(const std::string& config_folder, bool load_existi
   return true;
 }
 
+uint64_t blockchain_storage::loadCache() {
+  std::string cacheFileName = appendPath(m_config_folder, m_currency.blocksCacheFileName());
+  std::string txIndexFileName = appendPath(m_config_folder, m_currency.txIndexFileName());
+  std::string headersFileName = appendPath(m_config_folder, m_currency.blockHeadersFileName());
+  std::string keyImagesFileName = appendPath(m_config_folder, m_currency.keyImagesFileName());
+
+  // storeCache() writes the cache last, a temporary one exists only if all the files were written before a crash,
+  // it is newer than the live one then
+  for (const std::string& fileName : { tempFileName(cacheFileName), cacheFileName }) {
+    BlockCacheSerializer loader(*this);
+    if (!tools::unserialize_obj_from_file(loader, fileName) || !loader.loaded()) {
+      continue;
+    }
+
+    std::vector<std::string> unswapped;
+    if (fileName != cacheFileName) {
+      unswapped.push_back(cacheFileName);
+    }
+
+    LOG_PRINT_L0("- loading transaction map...");
+    if (!loadIndexFile(m_transactionMap, txIndexFileName, loader.height(), loader.lastBlockHash(), unswapped)) {
+      LOG_PRINT_L0("Transaction map file does not match the blockchain cache");
+      continue;
+    }
+
+    LOG_PRINT_L0("- loading block headers...");
+    if (!loadIndexFile(m_headers, headersFileName, loader.height(), loader.lastBlockHash(), unswapped)) {
+      LOG_PRINT_L0("Block headers file does not match the blockchain cache");
+      continue;
+    }
+
+    LOG_PRINT_L0("- loading spend keys...");
+    if (!loadIndexFile(m_spent_keys, keyImagesFileName, loader.height(), loader.lastBlockHash(), unswapped)) {
+      LOG_PRINT_L0("Spent keys file does not match the blockchain cache");
+      continue;
+    }
+
+    // finish the swap the crash interrupted, the next store overwrites the temporary files
+    if (!unswapped.empty()) {
+      LOG_PRINT_L0("Blockchain cache was not completely saved, finishing...");
+      swapInFiles(unswapped);
+    }
+
+    return loader.height();
+  }
+
+  return 0;
+}
+
+void blockchain_storage::rebuildCache(uint32_t fromHeight) {
+  struct RebuildBlock {
+    std::shared_ptr<const BlockEntry> entry;
+    crypto::hash blockHash;
+    std::vector<crypto::hash> transactionHashes;
+  };
+
+  static const uint32_t REBUILD_CHUNK_SIZE = 256;
+
+  if (fromHeight == 0) {
+    m_blockIndex.clear();
+    m_headers.clear();
+    m_transactionMap.clear();
+    m_spent_keys.clear();
+    m_outputs.clear();
+    m_keyOutputs.clear();
+    m_multisignatureOutputs.clear();
+  }
+
+  size_t workers = std::thread::hardware_concurrency();
+  if (workers == 0) {
+    workers = 2;
+  }
+
+  // Workers deserialize and hash height-ordered chunks, this thread merges them strictly in height order,
+  // so the resulting structures are the same as after a serial walk over the chain.
+  uint32_t height = static_cast<uint32_t>(m_blocks.size());
+  auto prepareChunk = [this, height](uint32_t chunkStart) {
+    uint32_t chunkEnd = std::min(height, chunkStart + REBUILD_CHUNK_SIZE);
+    std::vector<RebuildBlock> chunk(chunkEnd - chunkStart);
+    for (uint32_t b = chunkStart; b < chunkEnd; ++b) {
+      RebuildBlock& block = chunk[b - chunkStart];
+      block.entry = m_blocks.load(b);
+      block.blockHash = get_block_hash(block.entry->bl);
+      block.transactionHashes.reserve(block.entry->transactions.size());
+      for (const TransactionEntry& transaction : block.entry->transactions) {
+        block.transactionHashes.push_back(get_transaction_hash(transaction.tx));
+      }
+    }
+
+    return chunk;
+  };
+
+  std::deque<std::future<std::vector<RebuildBlock>>> pendingChunks;
+  uint32_t nextChunk = fromHeight;
+  for (uint32_t b = fromHeight; b < height;) {
+    while (nextChunk < height && pendingChunks.size() < workers * 2) {
+      pendingChunks.push_back(std::async(std::launch::async, prepareChunk, nextChunk));
+      nextChunk = std::min(height, nextChunk + REBUILD_CHUNK_SIZE);
+    }
+
+    std::vector<RebuildBlock> chunk = pendingChunks.front().get();
+    pendingChunks.pop_front();
+
+    for (const RebuildBlock& rebuildBlock : chunk) {
+      if (b % 1000 == 0) {
+        std::cout << "Height " << b << " of " << height << '\r';
+      }
+      const BlockEntry& block = *rebuildBlock.entry;
+      m_blockIndex.push(rebuildBlock.blockHash);
+      m_headers.push(block.bl.timestamp, block.cumulative_difficulty, block.block_cumulative_size, block.bl.majorVersion, block.bl.minorVersion);
+      for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+        const TransactionEntry& transaction = block.transactions[t];
+        TransactionIndex transactionIndex = { b, t };
+        TransactionMapEntry entry = { rebuildBlock.transactionHashes[t], transactionIndex };
+        m_transactionMap.insert(entry);
+
+        // process inputs
+        for (auto& i : transaction.tx.vin) {
+          if (i.type() == typeid(TransactionInputToKey)) {
+            m_spent_keys.insert(::boost::get<TransactionInputToKey>(i).keyImage);
+          } else if (i.type() == typeid(TransactionInputMultisignature)) {
+            auto out = ::boost::get<TransactionInputMultisignature>(i);
+            m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+          }
+        }
+
+        // process outputs
+        for (uint16_t o = 0; o < transaction.tx.vout.size(); ++o) {
+          const auto& out = transaction.tx.vout[o];
+          if(out.target.type() == typeid(TransactionOutputToKey)) {
+            m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
+            KeyOutputInfo info = { ::boost::get<TransactionOutputToKey>(out.target).key, transaction.tx.unlockTime, b };
+            m_keyOutputs[out.amount].push_back(info);
+          } else if (out.target.type() == typeid(TransactionOutputMultisignature)) {
+            MultisignatureOutputUsage usage = { transactionIndex, o, false };
+            m_multisignatureOutputs[out.amount].push_back(usage);
+          }
+        }
+      }
+
+      ++b;
+    }
+  }
+}
+
+blockchain_storage::CacheSnapshot::CacheSnapshot(const blockchain_storage& bs) :
+  height(bs.m_blocks.size()), lastBlockHash(bs.m_blockIndex.getTailId()), blockIndex(bs.m_blockIndex),
+  headers(bs.m_headers), transactionMap(bs.m_transactionMap), spentKeys(bs.m_spent_keys),
+  multisignatureOutputs(bs.m_multisignatureOutputs) {
+  outputs.reserve(bs.m_outputs.size());
+  for (const auto& amountOutputs : bs.m_outputs) {
+    outputs.emplace_back(amountOutputs.first, amountOutputs.second);
+  }
+
+  keyOutputs.reserve(bs.m_keyOutputs.size());
+  for (const auto& amountOutputs : bs.m_keyOutputs) {
+    keyOutputs.emplace_back(amountOutputs.first, amountOutputs.second);
+  }
+}
+
 bool blockchain_storage::storeCache() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  std::lock_guard<std::mutex> storeLock(m_storeCacheLock);
+
+  // Writing the files takes long on a large chain, only the copy of the indexes holds the lock, so neither
+  // new blocks nor the readers queued behind them wait for the disk.
+  std::unique_ptr<CacheSnapshot> snapshot;
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+  {
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    // the stored chain must not end below the cache
+    m_blocks.flush();
+    snapshot.reset(new CacheSnapshot(*this));
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  LOG_PRINT_L0("Saving blockchain, copying the indexes took: " << duration.count() << " sec");
+  std::string cacheFileName = appendPath(m_config_folder, m_currency.blocksCacheFileName());
+  std::string txIndexFileName = appendPath(m_config_folder, m_currency.txIndexFileName());
+  std::string headersFileName = appendPath(m_config_folder, m_currency.blockHeadersFileName());
+  std::string keyImagesFileName = appendPath(m_config_folder, m_currency.keyImagesFileName());
+
+  // The live files stay untouched until the whole set is written, a crash leaves either them or a complete set to
+  // finish swapping in, see loadCache(). A temporary cache left by an earlier store is removed first, so one exists
+  // only when all the files of this store were written.
+  std::remove(tempFileName(cacheFileName).c_str());
+  if (!snapshot->transactionMap.save(tempFileName(txIndexFileName), snapshot->height, snapshot->lastBlockHash) ||
+    !snapshot->headers.save(tempFileName(headersFileName), snapshot->height, snapshot->lastBlockHash) ||
+    !snapshot->spentKeys.save(tempFileName(keyImagesFileName), snapshot->height, snapshot->lastBlockHash)) {
+    LOG_ERROR("Failed to save blockchain indexes");
+    return false;
+  }
 
-  LOG_PRINT_L0("Saving blockchain...");
-  BlockCacheSerializer ser(*this, get_tail_id());
-  if (!tools::serialize_obj_to_file(ser, appendPath(m_config_folder, m_currency.blocksCacheFileName()))) {
+  BlockCacheSerializer ser(*this, *snapshot);
+  if (!tools::serialize_obj_to_file(ser, tempFileName(cacheFileName))) {
     LOG_ERROR("Failed to save blockchain cache");
     return false;
   }
 
+  if (!swapInFiles({ txIndexFileName, headersFileName, keyImagesFileName, cacheFileName })) {
+    return false;
+  }
+
+  m_storedCacheHeight = snapshot->height;
   return true;
 }
 
+// Blocks below the last checkpoint are pushed with structural checks only and their index entries are written in
+// batches. Full validation and per-block index writes resume with the first block past the checkpoint.
+void blockchain_storage::updateCheckpointZone() {
+  m_is_in_checkpoint_zone = m_checkpoints.is_in_checkpoint_zone(m_blocks.size());
+  m_blocks.setIndexBatchSize(m_is_in_checkpoint_zone ? BLOCKCHAIN_CHECKPOINT_ZONE_INDEX_BATCH : 1);
+}
+
+void blockchain_storage::on_idle() {
+  m_storeCacheInterval.do_call([this](){
+    // the cache is a checkpoint of the index, there is nothing to store if the chain has not moved since the last one
+    if (get_current_blockchain_height() == m_storedCacheHeight) {
+      return true;
+    }
+
+    return storeCache();
+  });
+}
+
 bool blockchain_storage::deinit() {
   storeCache();
   return true;
@@ -349,11 +625,19 @@ bool blockchain_storage::reset_and_set_genesis_block(const Block& b) {
   CRITICAL_REGION_LOCAL(m_blockchain_lock);
   m_blocks.clear();
   m_blockIndex.clear();
+  m_headers.clear();
+  {
+    std::lock_guard<std::mutex> lock(m_rawBlocksLock);
+    m_rawBlocks.clear();
+  }
   m_transactionMap.clear();
 
   m_spent_keys.clear();
   m_alternative_chains.clear();
   m_outputs.clear();
+  m_keyOutputs.clear();
+  m_multisignatureOutputs.clear();
+  updateCheckpointZone();
 
   block_verification_context bvc = boost::value_initialized<block_verification_context>();
   add_new_block(b, bvc);
@@ -361,19 +645,19 @@ bool blockchain_storage::reset_and_set_genesis_block(const Block& b) {
 }
 
 crypto::hash blockchain_storage::get_tail_id(uint64_t& height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   height = get_current_blockchain_height() - 1;
   return get_tail_id();
 }
 
 crypto::hash blockchain_storage::get_tail_id() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getTailId();
 }
 
 bool blockchain_storage::getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids) {
   CRITICAL_REGION_LOCAL1(m_tx_pool);
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (known_block_id != get_tail_id()) {
     return false;
   }
@@ -387,23 +671,50 @@ bool blockchain_storage::getPoolSymmetricDifference(const std::vector<crypto::ha
   return true;
 }
 
+MappedVectorCacheStatistics blockchain_storage::getBlockCacheStatistics() const {
+  return m_blocks.getCacheStatistics();
+}
+
+RingSignatureCacheStatistics blockchain_storage::getSignatureCacheStatistics() const {
+  return m_signatureVerifier.getCacheStatistics();
+}
+
+// Checks the ring signatures of all the transactions as one batch on the verifier's workers. Nothing is reported,
+// the signatures that pass are remembered by the verifier, so checking the inputs of each transaction afterwards
+// only looks up the outputs it references.
+void blockchain_storage::preverifyRingSignatures(const std::vector<const Transaction*>& transactions) {
+  std::vector<RingSignatureJob> signatureJobs;
+  {
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    for (const Transaction* tx : transactions) {
+      size_t jobCount = signatureJobs.size();
+      if (!check_tx_inputs(*tx, get_transaction_prefix_hash(*tx), signatureJobs)) {
+        // the transaction is rejected anyway, its signatures are not worth checking
+        signatureJobs.resize(jobCount);
+      }
+    }
+  }
+
+  m_signatureVerifier.verify(signatureJobs);
+}
+
 bool blockchain_storage::get_short_chain_history(std::list<crypto::hash>& ids) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getShortChainHistory(ids);
 }
 
 crypto::hash blockchain_storage::get_block_id_by_height(uint64_t height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getBlockId(height);
 }
 
 bool blockchain_storage::get_block_by_hash(const crypto::hash& blockHash, Block& b) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   uint64_t height = 0;
 
   if (m_blockIndex.getBlockHeight(blockHash, height)) {
-    b = m_blocks[height].bl;
+    b = m_blocks[height]->bl;
     return true;
   }
 
@@ -417,28 +728,23 @@ bool blockchain_storage::get_block_by_hash(const crypto::hash& blockHash, Block&
 }
 
 difficulty_type blockchain_storage::get_difficulty_for_next_block() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  std::vector<uint64_t> timestamps;
-  std::vector<difficulty_type> commulative_difficulties;
-  size_t offset = m_blocks.size() - std::min(m_blocks.size(), static_cast<uint64_t>(m_currency.difficultyBlocksCount()));
-  if (offset == 0) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  size_t offset = m_headers.size() - std::min(m_headers.size(), m_currency.difficultyBlocksCount());
+  if (offset == 0 && !m_headers.empty()) {
     ++offset;
   }
 
-  for (; offset < m_blocks.size(); offset++) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
-    commulative_difficulties.push_back(m_blocks[offset].cumulative_difficulty);
-  }
-
+  std::vector<uint64_t> timestamps(m_headers.timestamps().begin() + offset, m_headers.timestamps().end());
+  std::vector<difficulty_type> commulative_difficulties(m_headers.cumulativeDifficulties().begin() + offset, m_headers.cumulativeDifficulties().end());
   return m_currency.nextDifficulty(timestamps, commulative_difficulties);
 }
 
 uint64_t blockchain_storage::getCoinsInCirculation() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (m_blocks.empty()) {
     return 0;
   } else {
-    return m_blocks.back().already_generated_coins;
+    return m_blocks.back()->already_generated_coins;
   }
 }
 
@@ -446,27 +752,27 @@ uint8_t blockchain_storage::get_block_major_version_for_height(uint64_t height)
   return height > m_upgradeDetector.upgradeHeight() ? m_upgradeDetector.targetVersion() : BLOCK_MAJOR_VERSION_1;
 }
 
-bool blockchain_storage::rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height) {
+bool blockchain_storage::rollback_blockchain_switching(std::list<BlockEntry>& original_chain, size_t rollback_height) {
   CRITICAL_REGION_LOCAL(m_blockchain_lock);
   //remove failed subchain
   for (size_t i = m_blocks.size() - 1; i >= rollback_height; i--)
   {
-    popBlock(get_block_hash(m_blocks.back().bl));
-    //bool r = pop_block_from_blockchain();
-    //CHECK_AND_ASSERT_MES(r, false, "PANIC!!! failed to remove block while chain switching during the rollback!");
+    popBlock(get_block_hash(m_blocks.back()->bl));
   }
-  //return back original chain
-  BOOST_FOREACH(auto& bl, original_chain)
-  {
-    block_verification_context bvc = boost::value_initialized<block_verification_context>();
-    bool r = pushBlock(bl, bvc);
-    CHECK_AND_ASSERT_MES(r && bvc.m_added_to_main_chain, false, "PANIC!!! failed to add (again) block while chain switching during the rollback!");
+
+  //return back original chain, it was valid when it was disconnected
+  for (BlockEntry& block : original_chain) {
+    bool r = reconnectBlock(block);
+    CHECK_AND_ASSERT_MES(r, false, "PANIC!!! failed to add (again) block while chain switching during the rollback!");
   }
 
   LOG_PRINT_L0("Rollback success.");
   return true;
 }
 
+// Disconnected blocks are kept with their transactions. They are either reconnected without validation if the
+// alternative chain turns out to be invalid, or become an alternative chain with the height and cumulative
+// difficulty they had in the main chain.
 bool blockchain_storage::switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain) {
   CRITICAL_REGION_LOCAL(m_blockchain_lock);
   CHECK_AND_ASSERT_MES(alt_chain.size(), false, "switch_to_alternative_blockchain: empty chain passed");
@@ -475,12 +781,10 @@ bool blockchain_storage::switch_to_alternative_blockchain(std::list<blocks_ext_b
   CHECK_AND_ASSERT_MES(m_blocks.size() > split_height, false, "switch_to_alternative_blockchain: blockchain size is lower than split height");
 
   //disconnecting old chain
-  std::list<Block> disconnected_chain;
+  std::list<BlockEntry> disconnected_chain;
   for (size_t i = m_blocks.size() - 1; i >= split_height; i--) {
-    Block b = m_blocks[i].bl;
-    popBlock(get_block_hash(b));
-    //CHECK_AND_ASSERT_MES(r, false, "failed to remove block on chain switching");
-    disconnected_chain.push_front(b);
+    disconnected_chain.push_front(*m_blocks.back());
+    popBlock(get_block_hash(disconnected_chain.front().bl));
   }
 
   //connecting new alternative chain
@@ -506,15 +810,14 @@ bool blockchain_storage::switch_to_alternative_blockchain(std::list<blocks_ext_b
   }
 
   if (!discard_disconnected_chain) {
-    //pushing old chain as alternative chain
-    for (auto& old_ch_ent : disconnected_chain) {
-      block_verification_context bvc = boost::value_initialized<block_verification_context>();
-      bool r = handle_alternative_block(old_ch_ent, get_block_hash(old_ch_ent), bvc);
-      if (!r) {
-        LOG_ERROR("Failed to push ex-main chain blocks to alternative chain ");
-        rollback_blockchain_switching(disconnected_chain, split_height);
-        return false;
+    //pushing old chain as alternative chain, its transactions are back in the pool
+    for (BlockEntry& old_ch_ent : disconnected_chain) {
+      if (!m_checkpoints.is_alternative_block_allowed(get_current_blockchain_height(), old_ch_ent.height)) {
+        continue;
       }
+
+      old_ch_ent.transactions.clear();
+      m_alternative_chains.insert(blocks_ext_by_hash::value_type(get_block_hash(old_ch_ent.bl), std::move(old_ch_ent)));
     }
   }
 
@@ -531,7 +834,7 @@ difficulty_type blockchain_storage::get_next_difficulty_for_alternative_chain(co
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> commulative_difficulties;
   if (alt_chain.size() < m_currency.difficultyBlocksCount()) {
-    CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
     size_t main_chain_stop_offset = alt_chain.size() ? alt_chain.front()->second.height : bei.height;
     size_t main_chain_count = m_currency.difficultyBlocksCount() - std::min(m_currency.difficultyBlocksCount(), alt_chain.size());
     main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
@@ -539,10 +842,9 @@ difficulty_type blockchain_storage::get_next_difficulty_for_alternative_chain(co
 
     if (!main_chain_start_offset)
       ++main_chain_start_offset; //skip genesis block
-    for (; main_chain_start_offset < main_chain_stop_offset; ++main_chain_start_offset) {
-      timestamps.push_back(m_blocks[main_chain_start_offset].bl.timestamp);
-      commulative_difficulties.push_back(m_blocks[main_chain_start_offset].cumulative_difficulty);
-    }
+    timestamps.assign(m_headers.timestamps().begin() + main_chain_start_offset, m_headers.timestamps().begin() + main_chain_stop_offset);
+    commulative_difficulties.assign(m_headers.cumulativeDifficulties().begin() + main_chain_start_offset,
+      m_headers.cumulativeDifficulties().begin() + main_chain_stop_offset);
 
     CHECK_AND_ASSERT_MES((alt_chain.size() + timestamps.size()) <= m_currency.difficultyBlocksCount(), false,
       "Internal error, alt_chain.size()[" << alt_chain.size() << "] + timestamps.size()[" << timestamps.size() <<
@@ -627,18 +929,16 @@ bool blockchain_storage::validate_miner_transaction(const Block& b, uint64_t hei
 }
 
 bool blockchain_storage::get_backward_blocks_sizes(size_t from_height, std::vector<size_t>& sz, size_t count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   CHECK_AND_ASSERT_MES(from_height < m_blocks.size(), false, "Internal error: get_backward_blocks_sizes called with from_height=" << from_height << ", blockchain height = " << m_blocks.size());
   size_t start_offset = (from_height + 1) - std::min((from_height + 1), count);
-  for (size_t i = start_offset; i != from_height + 1; i++) {
-    sz.push_back(m_blocks[i].block_cumulative_size);
-  }
+  sz.insert(sz.end(), m_headers.cumulativeSizes().begin() + start_offset, m_headers.cumulativeSizes().begin() + from_height + 1);
 
   return true;
 }
 
 bool blockchain_storage::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!m_blocks.size()) {
     return true;
   }
@@ -654,7 +954,7 @@ bool blockchain_storage::create_block_template(Block& b, const AccountPublicAddr
   size_t median_size;
   uint64_t already_generated_coins;
 
-  CRITICAL_REGION_BEGIN(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_BEGIN(m_blockchain_lock);
   height = m_blocks.size();
   diffic = get_difficulty_for_next_block();
   CHECK_AND_ASSERT_MES(diffic, false, "difficulty overhead.");
@@ -672,7 +972,7 @@ bool blockchain_storage::create_block_template(Block& b, const AccountPublicAddr
   b.timestamp = time(NULL);
 
   median_size = m_current_block_cumul_sz_limit / 2;
-  already_generated_coins = m_blocks.back().already_generated_coins;
+  already_generated_coins = m_blocks.back()->already_generated_coins;
 
   CRITICAL_REGION_END();
 
@@ -781,13 +1081,13 @@ bool blockchain_storage::complete_timestamps_vector(uint64_t start_top_height, s
   if (timestamps.size() >= m_currency.timestampCheckWindow())
     return true;
 
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   size_t need_elements = m_currency.timestampCheckWindow() - timestamps.size();
   CHECK_AND_ASSERT_MES(start_top_height < m_blocks.size(), false, "internal error: passed start_height = " << start_top_height << " not less then m_blocks.size()=" << m_blocks.size());
   size_t stop_offset = start_top_height > need_elements ? start_top_height - need_elements : 0;
   do
   {
-    timestamps.push_back(m_blocks[start_top_height].bl.timestamp);
+    timestamps.push_back(m_headers.timestamps()[start_top_height]);
     if (start_top_height == 0)
       break;
     --start_top_height;
@@ -851,7 +1151,7 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       //make sure that it has right connection to main chain
       CHECK_AND_ASSERT_MES(m_blocks.size() > alt_chain.front()->second.height, false, "main blockchain wrong height");
       crypto::hash h = null_hash;
-      get_block_hash(m_blocks[alt_chain.front()->second.height - 1].bl, h);
+      get_block_hash(m_blocks[alt_chain.front()->second.height - 1]->bl, h);
       CHECK_AND_ASSERT_MES(h == alt_chain.front()->second.bl.prevId, false, "alternative chain have wrong connection to main chain");
       complete_timestamps_vector(alt_chain.front()->second.height - 1, timestamps);
     } else {
@@ -880,11 +1180,11 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
     }
 
     // Always check PoW for alternative blocks
-    m_is_in_checkpoint_zone = false;
     difficulty_type current_diff = get_next_difficulty_for_alternative_chain(alt_chain, bei);
     CHECK_AND_ASSERT_MES(current_diff, false, "!!!!!!! DIFFICULTY OVERHEAD !!!!!!!");
     crypto::hash proof_of_work = null_hash;
-    if (!m_currency.checkProofOfWork(m_cn_context, bei.bl, current_diff, proof_of_work)) {
+    crypto::pooled_cn_context context;
+    if (!m_currency.checkProofOfWork(context, bei.bl, current_diff, proof_of_work)) {
       LOG_PRINT_RED_L0("Block with id: " << id
         << ENDL << " for alternative chain, have not enough proof of work: " << proof_of_work
         << ENDL << " expected difficulty: " << current_diff);
@@ -898,7 +1198,7 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       return false;
     }
 
-    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_blocks[mainPrevHeight].cumulative_difficulty;
+    bei.cumulative_difficulty = alt_chain.size() ? it_prev->second.cumulative_difficulty : m_headers.cumulativeDifficulties()[mainPrevHeight];
     bei.cumulative_difficulty += current_diff;
 
 #ifdef _DEBUG
@@ -918,10 +1218,10 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
       if (r) bvc.m_added_to_main_chain = true;
       else bvc.m_verifivation_failed = true;
       return r;
-    } else if (m_blocks.back().cumulative_difficulty < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
+    } else if (m_headers.cumulativeDifficulties().back() < bei.cumulative_difficulty) //check if difficulty bigger then in main chain
     {
       //do reorganize!
-      LOG_PRINT_GREEN("###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_blocks.back().cumulative_difficulty
+      LOG_PRINT_GREEN("###### REORGANIZE on height: " << alt_chain.front()->second.height << " of " << m_blocks.size() - 1 << " with cum_difficulty " << m_headers.cumulativeDifficulties().back()
         << ENDL << " alternative blockchain size: " << alt_chain.size() << " with cum_difficulty " << bei.cumulative_difficulty, LOG_LEVEL_0);
       bool r = switch_to_alternative_blockchain(alt_chain, false);
       if (r) bvc.m_added_to_main_chain = true;
@@ -944,14 +1244,14 @@ bool blockchain_storage::handle_alternative_block(const Block& b, const crypto::
 }
 
 bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks, std::list<Transaction>& txs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_offset >= m_blocks.size())
     return false;
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++)
   {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks[i]->bl);
     std::list<crypto::hash> missed_ids;
-    get_transactions(m_blocks[i].bl.txHashes, txs, missed_ids);
+    get_transactions(m_blocks[i]->bl.txHashes, txs, missed_ids);
     CHECK_AND_ASSERT_MES(!missed_ids.size(), false, "have missed transactions in own block in main blockchain");
   }
 
@@ -959,20 +1259,20 @@ bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::li
 }
 
 bool blockchain_storage::get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
 
   for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(m_blocks[i]->bl);
   }
 
   return true;
 }
 
 bool blockchain_storage::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   rsp.current_blockchain_height = get_current_blockchain_height();
   std::list<Block> blocks;
   get_blocks(arg.blocks, blocks, rsp.missed_ids);
@@ -1004,7 +1304,7 @@ bool blockchain_storage::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request&
 }
 
 bool blockchain_storage::get_alternative_blocks(std::list<Block>& blocks) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   for (auto& alt_bl : m_alternative_chains) {
     blocks.push_back(alt_bl.second.bl);
   }
@@ -1013,57 +1313,49 @@ bool blockchain_storage::get_alternative_blocks(std::list<Block>& blocks) {
 }
 
 size_t blockchain_storage::get_alternative_blocks_count() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_alternative_chains.size();
 }
 
-bool blockchain_storage::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
-  CHECK_AND_ASSERT_MES(tx.vout.size() > amount_outs[i].second, false, "internal error: in global outs index, transaction out index="
-    << amount_outs[i].second << " more than transaction outputs = " << tx.vout.size() << ", for tx id = " << get_transaction_hash(tx));
-  CHECK_AND_ASSERT_MES(tx.vout[amount_outs[i].second].target.type() == typeid(TransactionOutputToKey), false, "unknown tx out type");
-
+bool blockchain_storage::add_out_to_get_random_outs(const std::vector<KeyOutputInfo>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, size_t i) {
   //check if transaction is unlocked
-  if (!is_tx_spendtime_unlocked(tx.unlockTime))
+  if (!is_tx_spendtime_unlocked(amount_outs[i].unlockTime))
     return false;
 
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& oen = *result_outs.outs.insert(result_outs.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry());
   oen.global_amount_index = i;
-  oen.out_key = boost::get<TransactionOutputToKey>(tx.vout[amount_outs[i].second].target).key;
+  oen.out_key = amount_outs[i].key;
   return true;
 }
 
-size_t blockchain_storage::find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  if (amount_outs.empty()) {
+size_t blockchain_storage::find_end_of_allowed_index(const std::vector<KeyOutputInfo>& amount_outs) {
+  uint64_t height = get_current_blockchain_height();
+  if (height < m_currency.minedMoneyUnlockWindow()) {
     return 0;
   }
 
-  size_t i = amount_outs.size();
-  do {
-    --i;
-    if (amount_outs[i].first.block + m_currency.minedMoneyUnlockWindow() <= get_current_blockchain_height()) {
-      return i + 1;
-    }
-  } while (i != 0);
-
-  return 0;
+  // outputs are appended in chain order, heights never decrease
+  uint64_t maxHeight = height - m_currency.minedMoneyUnlockWindow();
+  auto end = std::upper_bound(amount_outs.begin(), amount_outs.end(), maxHeight,
+    [](uint64_t height, const KeyOutputInfo& out) { return height < out.height; });
+  return std::distance(amount_outs.begin(), end);
 }
 
+// Decoys are read from the per amount key output arrays, no transaction is loaded. The lock is shared, requests
+// of different wallets are served in parallel.
 bool blockchain_storage::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   for (uint64_t amount : req.amounts) {
     COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs = *res.outs.insert(res.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount());
     result_outs.amount = amount;
-    auto it = m_outputs.find(amount);
-    if (it == m_outputs.end()) {
+    auto it = m_keyOutputs.find(amount);
+    if (it == m_keyOutputs.end()) {
       LOG_ERROR("COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS: not outs for amount " << amount << ", wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist");
       continue;//actually this is strange situation, wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist
     }
 
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs = it->second;
+    const std::vector<KeyOutputInfo>& amount_outs = it->second;
     //it is not good idea to use top fresh outs, because it increases possibility of transaction canceling on split
     //lets find upper bound of not fresh outs
     size_t up_index_limit = find_end_of_allowed_index(amount_outs);
@@ -1072,7 +1364,7 @@ bool blockchain_storage::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDO
     if (up_index_limit > 0) {
       ShuffleGenerator<size_t, crypto::random_engine<size_t>> generator(up_index_limit);
       for (uint64_t j = 0; j < up_index_limit && result_outs.outs.size() < req.outs_count; ++j) {
-        add_out_to_get_random_outs(amount_outs, result_outs, amount, generator());
+        add_out_to_get_random_outs(amount_outs, result_outs, generator());
       }
     }
   }
@@ -1081,7 +1373,7 @@ bool blockchain_storage::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDO
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, uint64_t& starter_offset)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   if (!qblock_ids.size() /*|| !req.m_total_height*/)
   {
@@ -1089,10 +1381,10 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
     return false;
   }
   //check genesis match
-  if (qblock_ids.back() != get_block_hash(m_blocks[0].bl))
+  if (qblock_ids.back() != get_block_hash(m_blocks[0]->bl))
   {
     LOG_ERROR("Client sent wrong NOTIFY_REQUEST_CHAIN: genesis block missmatch: " << ENDL << "id: "
-      << qblock_ids.back() << ", " << ENDL << "expected: " << get_block_hash(m_blocks[0].bl)
+      << qblock_ids.back() << ", " << ENDL << "expected: " << get_block_hash(m_blocks[0]->bl)
       << "," << ENDL << " dropping connection");
     return false;
   }
@@ -1109,18 +1401,18 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
 
 uint64_t blockchain_storage::block_difficulty(size_t i)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   CHECK_AND_ASSERT_MES(i < m_blocks.size(), false, "wrong block index i = " << i << " at blockchain_storage::block_difficulty()");
   if (i == 0)
-    return m_blocks[i].cumulative_difficulty;
+    return m_headers.cumulativeDifficulties()[i];
 
-  return m_blocks[i].cumulative_difficulty - m_blocks[i - 1].cumulative_difficulty;
+  return m_headers.cumulativeDifficulties()[i] - m_headers.cumulativeDifficulties()[i - 1];
 }
 
 void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_index)
 {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (start_index >= m_blocks.size())
   {
     LOG_PRINT_L0("Wrong starter index set: " << start_index << ", expected max index " << m_blocks.size() - 1);
@@ -1129,9 +1421,10 @@ void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_ind
 
   for (size_t i = start_index; i != m_blocks.size() && i != end_index; i++)
   {
-    ss << "height " << i << ", timestamp " << m_blocks[i].bl.timestamp << ", cumul_dif " << m_blocks[i].cumulative_difficulty << ", cumul_size " << m_blocks[i].block_cumulative_size
-      << "\nid\t\t" << get_block_hash(m_blocks[i].bl)
-      << "\ndifficulty\t\t" << block_difficulty(i) << ", nonce " << m_blocks[i].bl.nonce << ", tx_count " << m_blocks[i].bl.txHashes.size() << ENDL;
+    std::shared_ptr<const BlockEntry> block = m_blocks[i];
+    ss << "height " << i << ", timestamp " << block->bl.timestamp << ", cumul_dif " << block->cumulative_difficulty << ", cumul_size " << block->block_cumulative_size
+      << "\nid\t\t" << get_block_hash(block->bl)
+      << "\ndifficulty\t\t" << block_difficulty(i) << ", nonce " << block->bl.nonce << ", tx_count " << block->bl.txHashes.size() << ENDL;
   }
   LOG_PRINT_L1("Current blockchain:" << ENDL << ss.str());
   LOG_PRINT_L0("Blockchain printed with log level 1");
@@ -1139,7 +1432,7 @@ void blockchain_storage::print_blockchain(uint64_t start_index, uint64_t end_ind
 
 void blockchain_storage::print_blockchain_index() {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   std::list<crypto::hash> blockIds;
   m_blockIndex.getBlockIds(0, std::numeric_limits<size_t>::max(), blockIds);
@@ -1155,13 +1448,13 @@ void blockchain_storage::print_blockchain_index() {
 
 void blockchain_storage::print_blockchain_outs(const std::string& file) {
   std::stringstream ss;
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   for (const outputs_container::value_type& v : m_outputs) {
     const std::vector<std::pair<TransactionIndex, uint16_t>>& vals = v.second;
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << get_transaction_hash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        ss << "\t" << get_transaction_hash(transactionByIndex(vals[i].first)->tx) << ": " << vals[i].second << ENDL;
       }
     }
   }
@@ -1174,7 +1467,7 @@ void blockchain_storage::print_blockchain_outs(const std::string& file) {
 }
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY::request& resp) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!find_blockchain_supplement(qblock_ids, resp.start_height))
     return false;
 
@@ -1185,7 +1478,7 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
 }
 
 bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction> > >& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (!find_blockchain_supplement(qblock_ids, start_height)) {
     return false;
   }
@@ -1194,18 +1487,99 @@ bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash
   size_t count = 0;
   for (size_t i = start_height; i != m_blocks.size() && count < max_count; i++, count++) {
     blocks.resize(blocks.size() + 1);
-    blocks.back().first = m_blocks[i].bl;
+    blocks.back().first = m_blocks[i]->bl;
     std::list<crypto::hash> mis;
-    get_transactions(m_blocks[i].bl.txHashes, blocks.back().second, mis);
+    get_transactions(m_blocks[i]->bl.txHashes, blocks.back().second, mis);
     CHECK_AND_ASSERT_MES(!mis.size(), false, "internal error, transaction from block not found");
   }
 
   return true;
 }
 
+bool blockchain_storage::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (!find_blockchain_supplement(qblock_ids, start_height)) {
+    return false;
+  }
+
+  total_height = get_current_blockchain_height();
+  size_t count = 0;
+  for (uint64_t i = start_height; i != m_blocks.size() && count < max_count; i++, count++) {
+    blocks.push_back(block_complete_entry());
+    if (!getRawBlock(i, blocks.back())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool blockchain_storage::getRawBlock(uint64_t height, block_complete_entry& block, std::vector<uint64_t>* globalOutputIndexes) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  uint64_t blockCount = m_blocks.size();
+  if (height >= blockCount) {
+    return false;
+  }
+
+  bool cached = height + RAW_BLOCKS_CACHE_DEPTH >= blockCount;
+  if (cached) {
+    std::lock_guard<std::mutex> lock(m_rawBlocksLock);
+    auto it = m_rawBlocks.find(height);
+    if (it != m_rawBlocks.end()) {
+      block = it->second.block;
+      if (globalOutputIndexes != NULL) {
+        *globalOutputIndexes = it->second.globalOutputIndexes;
+      }
+
+      return true;
+    }
+  }
+
+  RawBlock raw;
+  Blocks::Blob blob = m_blocks.getBlob(height);
+  if (!splitBlockEntryBlob(blob.data(), blob.size(), raw.block.block, raw.block.txs, raw.globalOutputIndexes)) {
+    LOG_ERROR("Stored block entry at height " << height << " has unexpected format, serializing the block again");
+    std::shared_ptr<const BlockEntry> entry = m_blocks.load(height);
+    raw.block.block = block_to_blob(entry->bl);
+    raw.block.txs.clear();
+    raw.globalOutputIndexes.clear();
+    for (size_t i = 0; i < entry->transactions.size(); ++i) {
+      if (i != 0) {
+        raw.block.txs.push_back(tx_to_blob(entry->transactions[i].tx));
+      }
+
+      const std::vector<uint32_t>& indexes = entry->transactions[i].m_global_output_indexes;
+      raw.globalOutputIndexes.insert(raw.globalOutputIndexes.end(), indexes.begin(), indexes.end());
+    }
+  }
+
+  block = raw.block;
+  if (globalOutputIndexes != NULL) {
+    *globalOutputIndexes = raw.globalOutputIndexes;
+  }
+
+  if (cached) {
+    std::lock_guard<std::mutex> lock(m_rawBlocksLock);
+    m_rawBlocks[height] = std::move(raw);
+    m_rawBlocks.erase(m_rawBlocks.begin(), m_rawBlocks.lower_bound(blockCount - std::min<uint64_t>(blockCount, RAW_BLOCKS_CACHE_DEPTH)));
+  }
+
+  return true;
+}
+
+bool blockchain_storage::getBlockTimestamp(uint64_t height, uint64_t& timestamp) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (height >= m_headers.size()) {
+    return false;
+  }
+
+  timestamp = m_headers.timestamps()[static_cast<size_t>(height)];
+  return true;
+}
+
 bool blockchain_storage::have_block(const crypto::hash& id)
 {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   if (m_blockIndex.hasBlock(id))
     return true;
 
@@ -1216,30 +1590,30 @@ bool blockchain_storage::have_block(const crypto::hash& id)
 }
 
 size_t blockchain_storage::get_total_transactions() {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_transactionMap.size();
 }
 
 bool blockchain_storage::get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  auto it = m_transactionMap.find(tx_id);
-  if (it == m_transactionMap.end()) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  const TransactionMapEntry* entry = m_transactionMap.find(tx_id);
+  if (entry == nullptr) {
     LOG_PRINT_RED_L0("warning: get_tx_outputs_gindexs failed to find transaction with id = " << tx_id);
     return false;
   }
 
-  const TransactionEntry& tx = transactionByIndex(it->second);
-  CHECK_AND_ASSERT_MES(tx.m_global_output_indexes.size(), false, "internal error: global indexes for transaction " << tx_id << " is empty");
-  indexs.resize(tx.m_global_output_indexes.size());
-  for (size_t i = 0; i < tx.m_global_output_indexes.size(); ++i) {
-    indexs[i] = tx.m_global_output_indexes[i];
+  std::shared_ptr<const TransactionEntry> tx = transactionByIndex(entry->index);
+  CHECK_AND_ASSERT_MES(tx->m_global_output_indexes.size(), false, "internal error: global indexes for transaction " << tx_id << " is empty");
+  indexs.resize(tx->m_global_output_indexes.size());
+  for (size_t i = 0; i < tx->m_global_output_indexes.size(); ++i) {
+    indexs[i] = tx->m_global_output_indexes[i];
   }
 
   return true;
 }
 
 bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t& max_used_block_height, crypto::hash& max_used_block_id, BlockInfo* tail) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   if (tail)
     tail->id = get_tail_id(tail->height);
@@ -1247,7 +1621,7 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t& max_us
   bool res = check_tx_inputs(tx, &max_used_block_height);
   if (!res) return false;
   CHECK_AND_ASSERT_MES(max_used_block_height < m_blocks.size(), false, "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size());
-  get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+  get_block_hash(m_blocks[max_used_block_height]->bl, max_used_block_id);
   return true;
 }
 
@@ -1269,6 +1643,21 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, uint64_t* pmax_u
 }
 
 bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height) {
+  std::vector<RingSignatureJob> signatureJobs;
+  if (!check_tx_inputs(tx, tx_prefix_hash, signatureJobs, pmax_used_block_height)) {
+    return false;
+  }
+
+  if (m_signatureVerifier.verify(signatureJobs) != signatureJobs.size()) {
+    LOG_PRINT_L0("Failed to check ring signature for tx " << get_transaction_hash(tx));
+    return false;
+  }
+
+  return true;
+}
+
+// Runs every input check except the ring signatures, which are appended to signatureJobs for the caller to verify.
+bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, std::vector<RingSignatureJob>& signatureJobs, uint64_t* pmax_used_block_height) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
@@ -1286,8 +1675,8 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::ha
         return false;
       }
 
-      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height)) {
-        LOG_PRINT_L0("Failed to check ring signature for tx " << transactionHash);
+      if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], signatureJobs, pmax_used_block_height)) {
+        LOG_PRINT_L0("Failed to check input outputs for tx " << transactionHash);
         return false;
       }
 
@@ -1307,6 +1696,42 @@ bool blockchain_storage::check_tx_inputs(const Transaction& tx, const crypto::ha
   return true;
 }
 
+// Structural input checks for a transaction of a block below the last checkpoint. The referenced outputs are neither
+// looked up nor are the signatures checked, only what pushTransaction relies on is verified.
+bool blockchain_storage::checkCheckpointZoneInputs(const Transaction& tx, const crypto::hash& transactionHash) {
+  if (tx.signatures.size() != tx.vin.size()) {
+    LOG_PRINT_L0("Transaction " << transactionHash << " has " << tx.signatures.size() << " signature sets for " << tx.vin.size() << " inputs");
+    return false;
+  }
+
+  for (size_t i = 0; i < tx.vin.size(); ++i) {
+    if (tx.vin[i].type() == typeid(TransactionInputToKey)) {
+      const TransactionInputToKey& in = ::boost::get<TransactionInputToKey>(tx.vin[i]);
+      if (in.keyOffsets.empty() || tx.signatures[i].size() != in.keyOffsets.size()) {
+        LOG_PRINT_L0("Transaction " << transactionHash << " has input with wrong output or signature count");
+        return false;
+      }
+
+      if (have_tx_keyimg_as_spent(in.keyImage)) {
+        LOG_PRINT_L1("Key image already spent in blockchain: " << epee::string_tools::pod_to_hex(in.keyImage));
+        return false;
+      }
+    } else if (tx.vin[i].type() == typeid(TransactionInputMultisignature)) {
+      const TransactionInputMultisignature& in = ::boost::get<TransactionInputMultisignature>(tx.vin[i]);
+      auto amountOutputs = m_multisignatureOutputs.find(in.amount);
+      if (amountOutputs == m_multisignatureOutputs.end() || in.outputIndex >= amountOutputs->second.size() || amountOutputs->second[in.outputIndex].isUsed) {
+        LOG_PRINT_L0("Transaction " << transactionHash << " contains invalid multisignature input");
+        return false;
+      }
+    } else {
+      LOG_PRINT_L0("Transaction << " << transactionHash << " contains input of unsupported type.");
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool blockchain_storage::is_tx_spendtime_unlocked(uint64_t unlock_time) {
   if (unlock_time < m_currency.maxBlockHeight()) {
     //interpret as block index
@@ -1326,14 +1751,14 @@ bool blockchain_storage::is_tx_spendtime_unlocked(uint64_t unlock_time) {
   return false;
 }
 
-bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, std::vector<RingSignatureJob>& signatureJobs, uint64_t* pmax_related_block_height) {
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   struct outputs_visitor
   {
-    std::vector<const crypto::public_key *>& m_results_collector;
+    std::vector<crypto::public_key>& m_results_collector;
     blockchain_storage& m_bch;
-    outputs_visitor(std::vector<const crypto::public_key *>& results_collector, blockchain_storage& bch) :m_results_collector(results_collector), m_bch(bch)
+    outputs_visitor(std::vector<crypto::public_key>& results_collector, blockchain_storage& bch) :m_results_collector(results_collector), m_bch(bch)
     {}
     bool handle_output(const Transaction& tx, const TransactionOutput& out) {
       //check tx unlock time
@@ -1348,13 +1773,13 @@ bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const
         return false;
       }
 
-      m_results_collector.push_back(&boost::get<TransactionOutputToKey>(out.target).key);
+      m_results_collector.push_back(boost::get<TransactionOutputToKey>(out.target).key);
       return true;
     }
   };
 
-  //check ring signature
-  std::vector<const crypto::public_key *> output_keys;
+  //collect output keys for the ring signature
+  std::vector<crypto::public_key> output_keys;
   outputs_visitor vi(output_keys, *this);
   if (!scan_outputkeys_for_indexes(txin, vi, pmax_related_block_height)) {
     LOG_PRINT_L0("Failed to get output keys for tx with amount = " << m_currency.formatAmount(txin.amount) <<
@@ -1368,11 +1793,13 @@ bool blockchain_storage::check_tx_input(const TransactionInputToKey& txin, const
   }
 
   CHECK_AND_ASSERT_MES(sig.size() == output_keys.size(), false, "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << output_keys.size());
-  if (m_is_in_checkpoint_zone) {
-    return true;
-  }
-
-  return crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  signatureJobs.resize(signatureJobs.size() + 1);
+  RingSignatureJob& job = signatureJobs.back();
+  job.prefixHash = tx_prefix_hash;
+  job.keyImage = txin.keyImage;
+  job.outputKeys.swap(output_keys);
+  job.signatures = sig.data();
+  return true;
 }
 
 uint64_t blockchain_storage::get_adjusted_time() {
@@ -1410,11 +1837,8 @@ bool blockchain_storage::check_block_timestamp_main(const Block& b) {
     return false;
   }
 
-  std::vector<uint64_t> timestamps;
-  size_t offset = m_blocks.size() <= m_currency.timestampCheckWindow() ? 0 : m_blocks.size() - m_currency.timestampCheckWindow();
-  for (; offset != m_blocks.size(); ++offset) {
-    timestamps.push_back(m_blocks[offset].bl.timestamp);
-  }
+  size_t offset = m_headers.size() <= m_currency.timestampCheckWindow() ? 0 : m_headers.size() - m_currency.timestampCheckWindow();
+  std::vector<uint64_t> timestamps(m_headers.timestamps().begin() + offset, m_headers.timestamps().end());
 
   return check_block_timestamp(std::move(timestamps), b);
 }
@@ -1472,7 +1896,7 @@ bool blockchain_storage::getBlockCumulativeSize(const Block& block, size_t& cumu
   return missedTxs.empty();
 }
 
-// Precondition: m_blockchain_lock is locked.
+// Precondition: m_blockchain_lock is locked exclusively.
 bool blockchain_storage::update_next_comulative_size_limit() {
   std::vector<size_t> sz;
   get_last_n_blocks_sizes(sz, m_currency.rewardBlocksWindow());
@@ -1511,7 +1935,7 @@ bool blockchain_storage::add_new_block(const Block& bl_, block_verification_cont
     bvc.m_added_to_main_chain = false;
     add_result = handle_alternative_block(bl, id, bvc);
   } else {
-    add_result = pushBlock(bl, bvc);
+    add_result = pushBlock(bl, id, bvc);
   }
   CRITICAL_REGION_END();
   CRITICAL_REGION_END();
@@ -1523,16 +1947,19 @@ bool blockchain_storage::add_new_block(const Block& bl_, block_verification_cont
   return add_result;
 }
 
-const blockchain_storage::TransactionEntry& blockchain_storage::transactionByIndex(TransactionIndex index) {
-  return m_blocks[index.block].transactions[index.transaction];
+std::shared_ptr<const blockchain_storage::TransactionEntry> blockchain_storage::transactionByIndex(TransactionIndex index) {
+  std::shared_ptr<const BlockEntry> block = m_blocks[index.block];
+  return std::shared_ptr<const TransactionEntry>(block, &block->transactions[index.transaction]);
 }
 
 bool blockchain_storage::pushBlock(const Block& blockData, block_verification_context& bvc) {
+  return pushBlock(blockData, get_block_hash(blockData), bvc);
+}
+
+bool blockchain_storage::pushBlock(const Block& blockData, const crypto::hash& blockHash, block_verification_context& bvc) {
   CRITICAL_REGION_LOCAL(m_blockchain_lock);
   TIME_MEASURE_START(block_processing_time);
 
-  crypto::hash blockHash = get_block_hash(blockData);
-
   if (m_blockIndex.hasBlock(blockHash)) {
     LOG_ERROR("Block " << blockHash << " already exists in blockchain.");
     bvc.m_verifivation_failed = true;
@@ -1563,14 +1990,24 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
 
   TIME_MEASURE_START(longhash_calculating_time);
   crypto::hash proof_of_work = null_hash;
-  if (m_checkpoints.is_in_checkpoint_zone(get_current_blockchain_height())) {
+  if (m_is_in_checkpoint_zone) {
     if (!m_checkpoints.check_block(get_current_blockchain_height(), blockHash)) {
       LOG_ERROR("CHECKPOINT VALIDATION FAILED");
+      // The blocks above the previous checkpoint were accepted unverified and lead to the mismatch, drop them.
+      uint64_t lastValidHeight = m_checkpoints.get_checkpoint_below(get_current_blockchain_height());
+      if (m_blocks.size() > lastValidHeight + 1) {
+        LOG_PRINT_L0("Rolling back " << m_blocks.size() - lastValidHeight - 1 << " unverified blocks to the checkpoint at height " << lastValidHeight);
+        while (m_blocks.size() > lastValidHeight + 1) {
+          popBlock(get_block_hash(m_blocks.back()->bl));
+        }
+      }
+
       bvc.m_verifivation_failed = true;
       return false;
     }
   } else {
-    if (!m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proof_of_work)) {
+    crypto::pooled_cn_context context;
+    if (!m_currency.checkProofOfWork(context, blockData, currentDifficulty, proof_of_work)) {
       LOG_PRINT_L0("Block " << blockHash << ", has too weak proof of work: " << proof_of_work << ", expected difficulty: " << currentDifficulty);
       bvc.m_verifivation_failed = true;
       return false;
@@ -1589,6 +2026,8 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
 
   BlockEntry block;
   block.bl = blockData;
+  // signature jobs point into the transactions, they must not move until the jobs are verified
+  block.transactions.reserve(blockData.txHashes.size() + 1);
   block.transactions.resize(1);
   block.transactions[0].tx =  blockData.minerTx;
   TransactionIndex transactionIndex = { static_cast<uint32_t>(m_blocks.size()), static_cast<uint16_t>(0) };
@@ -1598,6 +2037,8 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
   size_t cumulative_block_size = coinbase_blob_size;
   uint64_t fee_summary = 0;
   uint64_t interestSummary = 0;
+  std::vector<RingSignatureJob> signatureJobs;
+  std::vector<size_t> signatureJobTransactions;
   for (const crypto::hash& tx_id : blockData.txHashes) {
     block.transactions.resize(block.transactions.size() + 1);
     size_t blob_size = 0;
@@ -1618,7 +2059,11 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
       LOG_PRINT_L0("Block " << blockHash << " can't contain transaction " << tx_id << " because it has invalid version " << transaction.version);
     }
 
-    if (!check_tx_inputs(transaction)) {
+    // Below the last checkpoint inputs get structural checks only, neither PoW nor signatures are verified. Such blocks are
+    // vouched for by the next checkpoint's hash, a mismatch there rolls them back to the previous checkpoint.
+    bool inputsValid = m_is_in_checkpoint_zone ? checkCheckpointZoneInputs(transaction, tx_id) :
+      check_tx_inputs(transaction, get_transaction_prefix_hash(transaction), signatureJobs);
+    if (!inputsValid) {
       isTransactionValid = false;
       LOG_PRINT_L0("Transaction " << tx_id << " has at least one invalid input");
     }
@@ -1641,6 +2086,7 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
       return false;
     }
 
+    signatureJobTransactions.resize(signatureJobs.size(), block.transactions.size() - 1);
     ++transactionIndex.transaction;
     pushTransaction(block, tx_id, transactionIndex);
 
@@ -1649,6 +2095,19 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
     interestSummary += m_currency.calculateTotalTransactionInterest(transaction);
   }
 
+  // Ring signatures of all transactions are checked together once everything else has passed. A block is
+  // rejected if any of them fails, the same as when every transaction was checked in turn.
+  size_t failedJob = m_signatureVerifier.verify(signatureJobs);
+  if (failedJob != signatureJobs.size()) {
+    const crypto::hash& failedTransactionHash = blockData.txHashes[signatureJobTransactions[failedJob] - 1];
+    LOG_PRINT_L0("Failed to check ring signature for tx " << failedTransactionHash);
+    LOG_PRINT_L0("Transaction " << failedTransactionHash << " has at least one invalid input");
+    LOG_PRINT_L0("Block " << blockHash << " has at least one invalid transaction: " << failedTransactionHash);
+    bvc.m_verifivation_failed = true;
+    popTransactions(block, minerTransactionHash);
+    return false;
+  }
+
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, m_blocks.size())) {
     bvc.m_verifivation_failed = true;
     return false;
@@ -1656,7 +2115,7 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
 
   int64_t emissionChange = 0;
   uint64_t reward = 0;
-  uint64_t already_generated_coins = m_blocks.empty() ? 0 : m_blocks.back().already_generated_coins;
+  uint64_t already_generated_coins = m_blocks.empty() ? 0 : m_blocks.back()->already_generated_coins;
   if (!validate_miner_transaction(blockData, m_blocks.size(), cumulative_block_size, already_generated_coins, fee_summary, reward, emissionChange)) {
     LOG_PRINT_L0("Block " << blockHash << " has invalid miner transaction");
     bvc.m_verifivation_failed = true;
@@ -1669,10 +2128,11 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
   block.cumulative_difficulty = currentDifficulty;
   block.already_generated_coins = already_generated_coins + emissionChange + interestSummary;
   if (m_blocks.size() > 0) {
-    block.cumulative_difficulty += m_blocks.back().cumulative_difficulty;
+    block.cumulative_difficulty += m_headers.cumulativeDifficulties().back();
   }
 
-  pushBlock(block);
+  pushBlock(block, blockHash);
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), blockHash);
   TIME_MEASURE_FINISH(block_processing_time);
   LOG_PRINT_L1("+++++ BLOCK SUCCESSFULLY ADDED" << ENDL << "id:\t" << blockHash
     << ENDL << "PoW:\t" << proof_of_work
@@ -1689,14 +2149,58 @@ bool blockchain_storage::pushBlock(const Block& blockData, block_verification_co
   return true;
 }
 
-bool blockchain_storage::pushBlock(BlockEntry& block) {
-  crypto::hash blockHash = get_block_hash(block.bl);
-
+bool blockchain_storage::pushBlock(BlockEntry& block, const crypto::hash& blockHash) {
   m_blocks.push_back(block);
   m_blockIndex.push(blockHash);
+  m_headers.push(block.bl.timestamp, block.cumulative_difficulty, block.block_cumulative_size, block.bl.majorVersion, block.bl.minorVersion);
 
   assert(m_blockIndex.size() == m_blocks.size());
+  assert(m_headers.size() == m_blocks.size());
 
+  updateCheckpointZone();
+  return true;
+}
+
+// Pushes a block that has been in the main chain before back on top of it. Its transactions are taken back from
+// the pool and the indexes are updated as by pushBlock, nothing is validated again.
+bool blockchain_storage::reconnectBlock(BlockEntry& block) {
+  crypto::hash blockHash = get_block_hash(block.bl);
+  CHECK_AND_ASSERT_MES(block.height == m_blocks.size() && block.bl.prevId == get_tail_id(), false,
+    "Block " << blockHash << " doesn't continue the chain at height " << m_blocks.size());
+
+  for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+    crypto::hash transactionHash = t == 0 ? get_transaction_hash(block.bl.minerTx) : block.bl.txHashes[t - 1];
+    if (t != 0) {
+      Transaction transaction;
+      size_t blobSize;
+      uint64_t fee;
+      if (!m_tx_pool.take_tx(transactionHash, transaction, blobSize, fee)) {
+        // The block entry keeps its own copy of the transaction, so it is reconnected anyway.
+        LOG_PRINT_L1("Transaction " << transactionHash << " of reconnected block " << blockHash << " is not in the pool.");
+      }
+    }
+
+    TransactionIndex transactionIndex = { static_cast<uint32_t>(m_blocks.size()), t };
+    if (!pushTransaction(block, transactionHash, transactionIndex)) {
+      if (t != 0) {
+        // Transaction t has been taken from the pool but not pushed, popTransactions only returns 1..t-1.
+        tx_verification_context tvc = ::AUTO_VAL_INIT(tvc);
+        if (!m_tx_pool.add_tx(block.transactions[t].tx, tvc, true)) {
+          LOG_ERROR("Cannot move transaction " << transactionHash << " back to transaction pool.");
+        }
+
+        block.transactions.resize(t);
+        popTransactions(block, get_transaction_hash(block.bl.minerTx));
+      }
+
+      return false;
+    }
+  }
+
+  pushBlock(block, blockHash);
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), blockHash);
+  m_upgradeDetector.blockPushed();
+  update_next_comulative_size_limit();
   return true;
 }
 
@@ -1706,18 +2210,28 @@ void blockchain_storage::popBlock(const crypto::hash& blockHash) {
     return;
   }
 
-  popTransactions(m_blocks.back(), get_transaction_hash(m_blocks.back().bl.minerTx));
+  std::shared_ptr<const BlockEntry> block = m_blocks.back();
+  popTransactions(*block, get_transaction_hash(block->bl.minerTx));
   m_blocks.pop_back();
   m_blockIndex.pop();
+  m_headers.pop();
+  {
+    std::lock_guard<std::mutex> lock(m_rawBlocksLock);
+    m_rawBlocks.erase(m_rawBlocks.lower_bound(m_blocks.size()), m_rawBlocks.end());
+  }
 
   assert(m_blockIndex.size() == m_blocks.size());
+  assert(m_headers.size() == m_blocks.size());
+
+  updateCheckpointZone();
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), m_blockIndex.getTailId());
 
   m_upgradeDetector.blockPopped();
 }
 
 bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash& transactionHash, TransactionIndex transactionIndex) {
-  auto result = m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-  if (!result.second) {
+  TransactionMapEntry entry = { transactionHash, transactionIndex };
+  if (!m_transactionMap.insert(entry)) {
     LOG_ERROR("Duplicate transaction was pushed to blockchain.");
     return false;
   }
@@ -1732,8 +2246,7 @@ bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash&
 
   for (size_t i = 0; i < transaction.tx.vin.size(); ++i) {
     if (transaction.tx.vin[i].type() == typeid(TransactionInputToKey)) {
-      auto result = m_spent_keys.insert(::boost::get<TransactionInputToKey>(transaction.tx.vin[i]).keyImage);
-      if (!result.second) {
+      if (!m_spent_keys.insert(::boost::get<TransactionInputToKey>(transaction.tx.vin[i]).keyImage)) {
         LOG_ERROR("Double spending transaction was pushed to blockchain.");
         for (size_t j = 0; j < i; ++j) {
           m_spent_keys.erase(::boost::get<TransactionInputToKey>(transaction.tx.vin[i - 1 - j]).keyImage);
@@ -1759,6 +2272,9 @@ bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash&
       auto& amountOutputs = m_outputs[transaction.tx.vout[output].amount];
       transaction.m_global_output_indexes[output] = amountOutputs.size();
       amountOutputs.push_back(std::make_pair<>(transactionIndex, output));
+      KeyOutputInfo info = { ::boost::get<TransactionOutputToKey>(transaction.tx.vout[output].target).key, transaction.tx.unlockTime,
+        transactionIndex.block };
+      m_keyOutputs[transaction.tx.vout[output].amount].push_back(info);
     } else if (transaction.tx.vout[output].target.type() == typeid(TransactionOutputMultisignature)) {
       auto& amountOutputs = m_multisignatureOutputs[transaction.tx.vout[output].amount];
       transaction.m_global_output_indexes[output] = amountOutputs.size();
@@ -1771,7 +2287,13 @@ bool blockchain_storage::pushTransaction(BlockEntry& block, const crypto::hash&
 }
 
 void blockchain_storage::popTransaction(const Transaction& transaction, const crypto::hash& transactionHash) {
-  TransactionIndex transactionIndex = m_transactionMap.at(transactionHash);
+  const TransactionMapEntry* entry = m_transactionMap.find(transactionHash);
+  if (entry == nullptr) {
+    LOG_ERROR("Blockchain consistency broken - cannot find transaction by hash.");
+    return;
+  }
+
+  TransactionIndex transactionIndex = entry->index;
   for (size_t outputIndex = 0; outputIndex < transaction.vout.size(); ++outputIndex) {
     const TransactionOutput& output = transaction.vout[transaction.vout.size() - 1 - outputIndex];
     if (output.target.type() == typeid(TransactionOutputToKey)) {
@@ -1800,6 +2322,13 @@ void blockchain_storage::popTransaction(const Transaction& transaction, const cr
       if (amountOutputs->second.empty()) {
         m_outputs.erase(amountOutputs);
       }
+
+      std::vector<KeyOutputInfo>& keyOutputs = m_keyOutputs[output.amount];
+      assert(!keyOutputs.empty());
+      keyOutputs.pop_back();
+      if (keyOutputs.empty()) {
+        m_keyOutputs.erase(output.amount);
+      }
     } else if (output.target.type() == typeid(TransactionOutputMultisignature)) {
       auto amountOutputs = m_multisignatureOutputs.find(output.amount);
       if (amountOutputs == m_multisignatureOutputs.end()) {
@@ -1836,8 +2365,7 @@ void blockchain_storage::popTransaction(const Transaction& transaction, const cr
 
   for (auto& input : transaction.vin) {
     if (input.type() == typeid(TransactionInputToKey)) {
-      size_t count = m_spent_keys.erase(::boost::get<TransactionInputToKey>(input).keyImage);
-      if (count != 1) {
+      if (!m_spent_keys.erase(::boost::get<TransactionInputToKey>(input).keyImage)) {
         LOG_ERROR("Blockchain consistency broken - cannot find spent key.");
       }
     } else if (input.type() == typeid(TransactionInputMultisignature)) {
@@ -1851,10 +2379,7 @@ void blockchain_storage::popTransaction(const Transaction& transaction, const cr
     }
   }
 
-  size_t count = m_transactionMap.erase(transactionHash);
-  if (count != 1) {
-    LOG_ERROR("Blockchain consistency broken - cannot find transaction by hash.");
-  }
+  m_transactionMap.erase(transactionHash);
 }
 
 void blockchain_storage::popTransactions(const BlockEntry& block, const crypto::hash& minerTransactionHash) {
@@ -1888,7 +2413,8 @@ bool blockchain_storage::validateInput(const TransactionInputMultisignature& inp
     return false;
   }
 
-  const Transaction& outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
+  std::shared_ptr<const TransactionEntry> outputTransactionEntry = transactionByIndex(outputIndex.transactionIndex);
+  const Transaction& outputTransaction = outputTransactionEntry->tx;
   if (!is_tx_spendtime_unlocked(outputTransaction.unlockTime)) {
     LOG_PRINT_L1("Transaction << " << transactionHash << " contains multisignature input which points to a locked transaction.");
     return false;
@@ -1931,24 +2457,23 @@ bool blockchain_storage::validateInput(const TransactionInputMultisignature& inp
 }
 
 bool blockchain_storage::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint64_t& height) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   
   if (startOffset >= m_blocks.size()) {
     return false;
   }
 
-  auto bound = std::lower_bound(m_blocks.begin() + startOffset, m_blocks.end(), timestamp - m_currency.blockFutureTimeLimit(),
-    [](const BlockEntry& b, uint64_t timestamp) { return b.bl.timestamp < timestamp; });
-
-  if (bound == m_blocks.end()) {
+  const std::vector<uint64_t>& timestamps = m_headers.timestamps();
+  auto bound = std::lower_bound(timestamps.begin() + startOffset, timestamps.end(), timestamp - m_currency.blockFutureTimeLimit());
+  if (bound == timestamps.end()) {
     return false;
   }
 
-  height = std::distance(m_blocks.begin(), bound);
+  height = std::distance(timestamps.begin(), bound);
   return true;
 }
 
 bool blockchain_storage::getBlockIds(uint64_t startHeight, size_t maxCount, std::list<crypto::hash>& items) {
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
   return m_blockIndex.getBlockIds(startHeight, maxCount, items);
 }
@@ -6,21 +6,28 @@
 #pragma once
 
 #include <atomic>
+#include <map>
+#include <mutex>
 
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
 
 #include "common/ObserverManager.h"
 #include "common/util.h"
+#include "cryptonote_core/BlockHeaderColumns.h"
 #include "cryptonote_core/BlockIndex.h"
 #include "cryptonote_core/checkpoints.h"
 #include "cryptonote_core/Currency.h"
+#include "cryptonote_core/FlatHashIndex.h"
 #include "cryptonote_core/IBlockchainStorageObserver.h"
 #include "cryptonote_core/ITransactionValidator.h"
-#include "cryptonote_core/SwappedVector.h"
+#include "cryptonote_core/KeyImageSet.h"
+#include "cryptonote_core/MappedVector.h"
+#include "cryptonote_core/RingSignatureVerifier.h"
 #include "cryptonote_core/UpgradeDetector.h"
 #include "cryptonote_core/cryptonote_format_utils.h"
 #include "cryptonote_core/tx_pool.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
 
 
 namespace cryptonote {
@@ -43,15 +50,17 @@ namespace cryptonote {
     virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock);
     virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed);
     virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx);
+    virtual bool isInCheckpointZone() const;
 
     bool init() { return init(tools::get_default_data_dir(), true); }
     bool init(const std::string& config_folder, bool load_existing);
     bool deinit();
+    void on_idle();
 
     bool getLowerBound(uint64_t timestamp, uint64_t startOffset, uint64_t& height);
     bool getBlockIds(uint64_t startHeight, size_t maxCount, std::list<crypto::hash>& items);
 
-    void set_checkpoints(checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
+    void set_checkpoints(checkpoints&& chk_pts);
     bool get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool get_blocks(uint64_t start_offset, size_t count, std::list<Block>& blocks);
     bool get_alternative_blocks(std::list<Block>& blocks);
@@ -77,6 +86,12 @@ namespace cryptonote {
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, uint64_t& starter_offset); // !!!!
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY_request& resp);
     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction>>>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
+    bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
+    // Main chain block as it is served to wallets, the blobs are copied out of the stored block entry without
+    // deserializing it. Entries of the last RAW_BLOCKS_CACHE_DEPTH blocks are kept for wallets polling at the tip.
+    // globalOutputIndexes receives the global indexes of the outputs of the miner transaction and then of block.txs.
+    bool getRawBlock(uint64_t height, block_complete_entry& block, std::vector<uint64_t>* globalOutputIndexes = NULL);
+    bool getBlockTimestamp(uint64_t height, uint64_t& timestamp);
     bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp);
     bool get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& res);
     bool get_backward_blocks_sizes(size_t from_height, std::vector<size_t>& sz, size_t count);
@@ -86,11 +101,14 @@ namespace cryptonote {
     bool is_storing_blockchain(){return m_is_blockchain_storing;}
     uint64_t block_difficulty(size_t i);
     bool getPoolSymmetricDifference(const std::vector<crypto::hash>& known_pool_tx_ids, const crypto::hash& known_block_id, std::vector<Transaction>& new_txs, std::vector<crypto::hash>& deleted_tx_ids);
+    MappedVectorCacheStatistics getBlockCacheStatistics() const;
+    RingSignatureCacheStatistics getSignatureCacheStatistics() const;
+    void preverifyRingSignatures(const std::vector<const Transaction*>& transactions);
 
 
     template<class t_ids_container, class t_blocks_container, class t_missed_container>
     bool get_blocks(const t_ids_container& block_ids, t_blocks_container& blocks, t_missed_container& missed_bs) {
-      CRITICAL_REGION_LOCAL(m_blockchain_lock);
+      SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
       for (const auto& bl_id : block_ids) {
         uint64_t height = 0;
@@ -99,7 +117,7 @@ namespace cryptonote {
         } else {
           CHECK_AND_ASSERT_MES(height < m_blocks.size(), false, "Internal error: bl_id=" << epee::string_tools::pod_to_hex(bl_id)
             << " have index record with offset=" << height << ", bigger then m_blocks.size()=" << m_blocks.size());
-            blocks.push_back(m_blocks[height].bl);
+            blocks.push_back(m_blocks[height]->bl);
         }
       }
 
@@ -108,14 +126,14 @@ namespace cryptonote {
 
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void get_transactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs, bool checkTxPool = false) {
-      CRITICAL_REGION_LOCAL(m_blockchain_lock);
+      SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
       for (const auto& tx_id : txs_ids) {
-        auto it = m_transactionMap.find(tx_id);
-        if (it == m_transactionMap.end()) {
+        const TransactionMapEntry* entry = m_transactionMap.find(tx_id);
+        if (entry == nullptr) {
           missed_txs.push_back(tx_id);
         } else {
-          txs.push_back(transactionByIndex(it->second).tx);
+          txs.push_back(transactionByIndex(entry->index)->tx);
         }
       }
 
@@ -175,41 +193,99 @@ namespace cryptonote {
       template<class Archive> void serialize(Archive& archive, unsigned int version);
     };
 
-    typedef google::sparse_hash_set<crypto::key_image> key_images_container;
+    // What decoy selection needs of a key output, kept per amount in the order of m_outputs.
+    struct KeyOutputInfo {
+      crypto::public_key key;
+      uint64_t unlockTime;
+      uint32_t height;
+
+      template<class Archive> void serialize(Archive& archive, unsigned int version);
+    };
+
+    typedef KeyImageSet key_images_container;
     typedef std::unordered_map<crypto::hash, BlockEntry> blocks_ext_by_hash;
     typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //crypto::hash - tx hash, size_t - index of out in transaction
+    typedef google::sparse_hash_map<uint64_t, std::vector<KeyOutputInfo>> key_outputs_container;
     typedef std::map<uint64_t, std::vector<MultisignatureOutputUsage>> MultisignatureOutputsContainer;
 
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
-    epee::critical_section m_blockchain_lock; // TODO: add here reader/writer lock
-    crypto::cn_context m_cn_context;
+    // Shared for lookups and validation, exclusive for anything that changes the chain or its indexes.
+    epee::recursive_shared_critical_section m_blockchain_lock;
     tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
+    RingSignatureVerifier m_signatureVerifier;
 
     key_images_container m_spent_keys;
     size_t m_current_block_cumul_sz_limit;
     blocks_ext_by_hash m_alternative_chains; // crypto::hash -> block_extended_info
     outputs_container m_outputs;
+    key_outputs_container m_keyOutputs;
 
     std::string m_config_folder;
     checkpoints m_checkpoints;
     std::atomic<bool> m_is_in_checkpoint_zone;
     std::atomic<bool> m_is_blockchain_storing;
+    std::atomic<uint64_t> m_storedCacheHeight;
+    // one cache store at a time, they write the same files
+    std::mutex m_storeCacheLock;
+    epee::math_helper::once_a_time_seconds<BLOCKCHAIN_CACHE_STORE_INTERVAL, false> m_storeCacheInterval;
 
-    typedef SwappedVector<BlockEntry> Blocks;
+    typedef MappedVector<BlockEntry> Blocks;
     typedef std::unordered_map<crypto::hash, uint32_t> BlockMap;
-    typedef std::unordered_map<crypto::hash, TransactionIndex> TransactionMap;
-    typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
+    struct TransactionMapEntry {
+      crypto::hash id;
+      TransactionIndex index;
+    };
+
+    struct TransactionMapKey {
+      const crypto::hash& operator()(const TransactionMapEntry& entry) const {
+        return entry.id;
+      }
+    };
+
+    // 40-byte entries, 48 to 96 bytes per transaction, stored in its own file, see FlatHashIndex::save
+    typedef FlatHashIndex<TransactionMapEntry, TransactionMapKey> TransactionMap;
+    typedef BasicUpgradeDetector<BlockHeaderColumns> UpgradeDetector;
+
+    struct RawBlock {
+      block_complete_entry block;
+      std::vector<uint64_t> globalOutputIndexes;
+    };
+
+    // Copy of the indexes stored in the cache, taken under the blockchain lock and written after it is released.
+    // It holds a second copy of the indexes while the files are written and blocks new blocks while it is taken,
+    // a few hundred milliseconds for a chain of a million transactions. The outputs are copied into vectors, copying
+    // the hash maps takes several times longer.
+    struct CacheSnapshot {
+      explicit CacheSnapshot(const blockchain_storage& bs);
+
+      uint64_t height;
+      crypto::hash lastBlockHash;
+      CryptoNote::BlockIndex blockIndex;
+      BlockHeaderColumns headers;
+      TransactionMap transactionMap;
+      key_images_container spentKeys;
+      std::vector<std::pair<uint64_t, outputs_container::mapped_type>> outputs;
+      std::vector<std::pair<uint64_t, key_outputs_container::mapped_type>> keyOutputs;
+      MultisignatureOutputsContainer multisignatureOutputs;
+    };
 
     friend class BlockCacheSerializer;
 
     Blocks m_blocks;
     CryptoNote::BlockIndex m_blockIndex;
+    BlockHeaderColumns m_headers;
     TransactionMap m_transactionMap;
     MultisignatureOutputsContainer m_multisignatureOutputs;
     UpgradeDetector m_upgradeDetector;
+    // Taken under the shared blockchain lock by readers, entries above the tip are erased under the exclusive one.
+    std::mutex m_rawBlocksLock;
+    std::map<uint64_t, RawBlock> m_rawBlocks;
 
     bool storeCache();
+    uint64_t loadCache();
+    void rebuildCache(uint32_t fromHeight);
+    void updateCheckpointZone();
     template<class visitor_t> bool scan_outputkeys_for_indexes(const TransactionInputToKey& tx_in_to_key, visitor_t& vis, uint64_t* pmax_related_block_height = NULL);
     bool switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain);
     bool handle_alternative_block(const Block& b, const crypto::hash& id, block_verification_context& bvc);
@@ -217,11 +293,11 @@ namespace cryptonote {
     bool prevalidate_miner_transaction(const Block& b, uint64_t height);
     bool validate_miner_transaction(const Block& b, uint64_t height, size_t cumulativeBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint64_t& reward, int64_t& emissionChange);
     bool validate_transaction(const Block& b, uint64_t height, const Transaction& tx);
-    bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
+    bool rollback_blockchain_switching(std::list<BlockEntry>& original_chain, size_t rollback_height);
     bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
-    bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
+    bool add_out_to_get_random_outs(const std::vector<KeyOutputInfo>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, size_t i);
     bool is_tx_spendtime_unlocked(uint64_t unlock_time);
-    size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
+    size_t find_end_of_allowed_index(const std::vector<KeyOutputInfo>& amount_outs);
     bool check_block_timestamp_main(const Block& b);
     bool check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b);
     uint64_t get_adjusted_time();
@@ -230,14 +306,18 @@ namespace cryptonote {
     bool checkCumulativeBlockSize(const crypto::hash& blockId, size_t cumulativeBlockSize, uint64_t height);
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
-    bool check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, uint64_t* pmax_related_block_height = NULL);
+    bool check_tx_input(const TransactionInputToKey& txin, const crypto::hash& tx_prefix_hash, const std::vector<crypto::signature>& sig, std::vector<RingSignatureJob>& signatureJobs, uint64_t* pmax_related_block_height = NULL);
+    bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, std::vector<RingSignatureJob>& signatureJobs, uint64_t* pmax_used_block_height = NULL);
     bool check_tx_inputs(const Transaction& tx, const crypto::hash& tx_prefix_hash, uint64_t* pmax_used_block_height = NULL);
     bool check_tx_inputs(const Transaction& tx, uint64_t* pmax_used_block_height = NULL);
     bool check_tx_outputs(const Transaction& tx) const;
+    bool checkCheckpointZoneInputs(const Transaction& tx, const crypto::hash& transactionHash);
     bool have_tx_keyimg_as_spent(const crypto::key_image &key_im);
-    const TransactionEntry& transactionByIndex(TransactionIndex index);
+    std::shared_ptr<const TransactionEntry> transactionByIndex(TransactionIndex index);
     bool pushBlock(const Block& blockData, block_verification_context& bvc);
-    bool pushBlock(BlockEntry& block);
+    bool pushBlock(const Block& blockData, const crypto::hash& blockHash, block_verification_context& bvc);
+    bool pushBlock(BlockEntry& block, const crypto::hash& blockHash);
+    bool reconnectBlock(BlockEntry& block);
     void popBlock(const crypto::hash& blockHash);
     bool pushTransaction(BlockEntry& block, const crypto::hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const crypto::hash& transactionHash);
@@ -260,11 +340,11 @@ namespace cryptonote {
   private:
 
     blockchain_storage& m_bc;
-    epee::critical_region_t<epee::critical_section> m_lock;
+    epee::shared_critical_region_t<epee::recursive_shared_critical_section> m_lock;
   };
 
   template<class visitor_t> bool blockchain_storage::scan_outputkeys_for_indexes(const TransactionInputToKey& tx_in_to_key, visitor_t& vis, uint64_t* pmax_related_block_height) {
-    CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    SHARED_CRITICAL_REGION_LOCAL(m_blockchain_lock);
     auto it = m_outputs.find(tx_in_to_key.amount);
     if (it == m_outputs.end() || !tx_in_to_key.keyOffsets.size())
       return false;
@@ -281,10 +361,10 @@ namespace cryptonote {
       //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
       //CHECK_AND_ASSERT_MES(tx_it != m_transactionMap.end(), false, "Wrong transaction id in output indexes: " << epee::string_tools::pod_to_hex(amount_outs_vec[i].first));
 
-      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].first);
-      CHECK_AND_ASSERT_MES(amount_outs_vec[i].second < tx.tx.vout.size(), false,
-        "Wrong index in transaction outputs: " << amount_outs_vec[i].second << ", expected less then " << tx.tx.vout.size());
-      if (!vis.handle_output(tx.tx, tx.tx.vout[amount_outs_vec[i].second])) {
+      std::shared_ptr<const TransactionEntry> tx = transactionByIndex(amount_outs_vec[i].first);
+      CHECK_AND_ASSERT_MES(amount_outs_vec[i].second < tx->tx.vout.size(), false,
+        "Wrong index in transaction outputs: " << amount_outs_vec[i].second << ", expected less then " << tx->tx.vout.size());
+      if (!vis.handle_output(tx->tx, tx->tx.vout[amount_outs_vec[i].second])) {
         LOG_PRINT_L0("Failed to handle_output for output no = " << count << ", with absolute offset " << i);
         return false;
       }
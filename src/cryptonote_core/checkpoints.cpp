@@ -68,4 +68,14 @@ namespace cryptonote
     uint64_t checkpoint_height = it->first;
     return checkpoint_height < block_height;
   }
+  //---------------------------------------------------------------------------
+  uint64_t checkpoints::get_checkpoint_below(uint64_t height) const
+  {
+    auto it = m_points.lower_bound(height);
+    if (it == m_points.begin())
+      return 0;
+
+    --it;
+    return it->first;
+  }
 }
@@ -19,6 +19,8 @@ namespace cryptonote
     bool check_block(uint64_t height, const crypto::hash& h) const;
     bool check_block(uint64_t height, const crypto::hash& h, bool& is_a_checkpoint) const;
     bool is_alternative_block_allowed(uint64_t blockchain_height, uint64_t block_height) const;
+    // height of the last checkpoint below height, 0 (the genesis block) if there is none
+    uint64_t get_checkpoint_below(uint64_t height) const;
 
   private:
     std::map<uint64_t, crypto::hash> m_points;
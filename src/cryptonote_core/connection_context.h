@@ -6,7 +6,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "net/net_utils_base.h"
@@ -28,13 +31,23 @@ namespace cryptonote
       state_normal
     };
 
+    struct sync_request
+    {
+      std::unordered_map<crypto::hash, uint64_t> blocks; //heights by id
+      std::chrono::steady_clock::time_point sent;
+    };
+
     state m_state;
-    std::list<crypto::hash> m_needed_objects;
-    std::unordered_set<crypto::hash> m_requested_objects;
+    std::map<uint64_t, crypto::hash> m_needed_objects; //by height
+    std::list<sync_request> m_requested_objects; //every request in flight
+    std::chrono::steady_clock::time_point m_last_response_time; //of the last response to a block request
     uint64_t m_remote_blockchain_height;
     uint64_t m_last_response_height;
     epee::copyable_atomic m_callback_request_count; //in debug purpose: problem with double callback rise
-    //size_t m_score;  TODO: add score calculations
+    bool m_waiting_for_sync_queue;
+    bool m_supports_compact_blocks; //from the sync data of the peer
+    bool m_supports_tx_inventory; //from the sync data of the peer
+    uint64_t m_duplicate_txs; //transactions sent by the peer that were in the pool or the chain already
   };
 
   inline std::string get_protocol_state_string(cryptonote_connection_context::state s)
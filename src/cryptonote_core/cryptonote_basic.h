@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 
@@ -159,9 +160,90 @@ namespace cryptonote {
     TransactionPrefix() {}
   };
 
+  // Hash and blob size of an object, computed on first use and kept with the object.
+  // Only objects read from a blob fill the cache, they are treated as immutable: code that changes such an object has
+  // to call invalidateHashes() on it. Objects built in code are hashed on every use, as they are usually changed
+  // after their hash has been taken. The cache is not serialized and is copied with the object. Concurrent readers
+  // may compute the same value, the first one to finish publishes it.
+  class CachedHash {
+  public:
+    CachedHash() : m_state(DISABLED), m_size(0) {
+    }
+
+    CachedHash(const CachedHash& other) : m_state(DISABLED), m_size(0) {
+      copy(other);
+    }
+
+    CachedHash& operator=(const CachedHash& other) {
+      if (this != &other) {
+        copy(other);
+      }
+
+      return *this;
+    }
+
+    bool enabled() const {
+      return m_state.load(std::memory_order_acquire) != DISABLED;
+    }
+
+    bool get(crypto::hash& hash, size_t& size) const {
+      if (m_state.load(std::memory_order_acquire) != FILLED) {
+        return false;
+      }
+
+      hash = m_hash;
+      size = m_size;
+      return true;
+    }
+
+    void set(const crypto::hash& hash, size_t size) const {
+      uint8_t expected = EMPTY;
+      if (m_state.compare_exchange_strong(expected, FILLING, std::memory_order_acq_rel)) {
+        m_hash = hash;
+        m_size = size;
+        m_state.store(FILLED, std::memory_order_release);
+      }
+    }
+
+    // Drops the cached value, the cache stays enabled.
+    void invalidate() {
+      if (m_state.load(std::memory_order_relaxed) != DISABLED) {
+        m_state.store(EMPTY, std::memory_order_relaxed);
+      }
+    }
+
+    // Drops the cached value and enables or disables the cache.
+    void reset(bool enable) {
+      m_state.store(enable ? EMPTY : DISABLED, std::memory_order_relaxed);
+    }
+
+  private:
+    enum : uint8_t { DISABLED, EMPTY, FILLING, FILLED };
+
+    mutable std::atomic<uint8_t> m_state;
+    mutable crypto::hash m_hash;
+    mutable size_t m_size;
+
+    void copy(const CachedHash& other) {
+      uint8_t state = other.m_state.load(std::memory_order_acquire);
+      if (state == FILLED) {
+        m_hash = other.m_hash;
+        m_size = other.m_size;
+      } else if (state == FILLING) {
+        state = EMPTY;
+      }
+
+      m_state.store(state, std::memory_order_release);
+    }
+  };
+
   struct Transaction: public TransactionPrefix {
     std::vector<std::vector<crypto::signature> > signatures; //count signatures  always the same as inputs count
 
+    // see CachedHash
+    CachedHash hashCache;
+    CachedHash prefixHashCache;
+
     Transaction() {
       clear();
     }
@@ -173,9 +255,26 @@ namespace cryptonote {
       vout.clear();
       extra.clear();
       signatures.clear();
+      hashCache.reset(false);
+      prefixHashCache.reset(false);
+    }
+
+    // Caches the hashes from now on, the transaction must not change until invalidateHashes() is called.
+    void enableHashCache() {
+      hashCache.reset(true);
+      prefixHashCache.reset(true);
+    }
+
+    void invalidateHashes() {
+      hashCache.invalidate();
+      prefixHashCache.invalidate();
     }
 
     BEGIN_SERIALIZE_OBJECT()
+      if (!W) {
+        enableHashCache();
+      }
+
       FIELDS(*static_cast<TransactionPrefix *>(this))
 
       ar.tag("signatures");
@@ -246,7 +345,24 @@ namespace cryptonote {
     Transaction minerTx;
     std::vector<crypto::hash> txHashes;
 
+    // see CachedHash, the miner transaction has caches of its own
+    CachedHash hashCache;
+
+    void enableHashCache() {
+      hashCache.reset(true);
+      minerTx.enableHashCache();
+    }
+
+    void invalidateHashes() {
+      hashCache.invalidate();
+      minerTx.invalidateHashes();
+    }
+
     BEGIN_SERIALIZE_OBJECT()
+      if (!W) {
+        hashCache.reset(true);
+      }
+
       FIELDS(*static_cast<BlockHeader *>(this));
       FIELD(minerTx);
       FIELD(txHashes);
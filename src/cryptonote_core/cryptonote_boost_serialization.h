@@ -115,6 +115,10 @@ namespace boost
   template <class Archive>
   inline void serialize(Archive &a, cryptonote::Transaction &x, const boost::serialization::version_type ver)
   {
+    if (Archive::is_loading::value) {
+      x.enableHashCache();
+    }
+
     a & x.version;
     a & x.unlockTime;
     a & x.vin;
@@ -127,6 +131,10 @@ namespace boost
   template <class Archive>
   inline void serialize(Archive &a, cryptonote::Block &b, const boost::serialization::version_type ver)
   {
+    if (Archive::is_loading::value) {
+      b.hashCache.reset(true);
+    }
+
     a & b.majorVersion;
     a & b.minorVersion;
     a & b.timestamp;
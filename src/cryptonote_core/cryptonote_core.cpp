@@ -144,9 +144,57 @@ namespace cryptonote
   bool core::handle_incoming_tx(const blobdata& tx_blob, tx_verification_context& tvc, bool keeped_by_block)
   {
     tvc = boost::value_initialized<tx_verification_context>();
-    //want to process all transactions sequentially
-    CRITICAL_REGION_LOCAL(m_incoming_tx_lock);
 
+    crypto::hash tx_hash = null_hash;
+    crypto::hash tx_prefixt_hash = null_hash;
+    Transaction tx;
+
+    if (!check_incoming_tx(tx_blob, tx, tx_hash, tx_prefixt_hash, tvc, keeped_by_block)) {
+      return false;
+    }
+
+    return add_incoming_tx(tx, tx_hash, tx_prefixt_hash, tx_blob.size(), tvc, keeped_by_block);
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::handle_incoming_txs(const std::list<blobdata>& tx_blobs, std::vector<tx_verification_context>& tvcs, bool keeped_by_block)
+  {
+    tvcs.assign(tx_blobs.size(), boost::value_initialized<tx_verification_context>());
+
+    std::vector<Transaction> txs(tx_blobs.size());
+    std::vector<crypto::hash> tx_hashes(tx_blobs.size(), null_hash);
+    std::vector<crypto::hash> tx_prefix_hashes(tx_blobs.size(), null_hash);
+
+    // transactions after the first invalid one are not processed, as if they were handled one by one
+    size_t count = 0;
+    for (const blobdata& tx_blob : tx_blobs) {
+      if (!check_incoming_tx(tx_blob, txs[count], tx_hashes[count], tx_prefix_hashes[count], tvcs[count], keeped_by_block)) {
+        break;
+      }
+
+      ++count;
+    }
+
+    if (count > 1 && !(keeped_by_block && m_blockchain_storage.isInCheckpointZone())) {
+      std::vector<const Transaction*> checked_txs;
+      for (size_t i = 0; i < count; ++i) {
+        checked_txs.push_back(&txs[i]);
+      }
+
+      m_blockchain_storage.preverifyRingSignatures(checked_txs);
+    }
+
+    auto tx_blob_it = tx_blobs.begin();
+    for (size_t i = 0; i < count; ++i, ++tx_blob_it) {
+      if (!add_incoming_tx(txs[i], tx_hashes[i], tx_prefix_hashes[i], tx_blob_it->size(), tvcs[i], keeped_by_block) && tvcs[i].m_verifivation_failed) {
+        return false;
+      }
+    }
+
+    return count == tx_blobs.size();
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::check_incoming_tx(const blobdata& tx_blob, Transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash, tx_verification_context& tvc, bool keeped_by_block)
+  {
     if(tx_blob.size() > m_currency.maxTxSize())
     {
       LOG_PRINT_L0("WRONG TRANSACTION BLOB, too big size " << tx_blob.size() << ", rejected");
@@ -154,11 +202,7 @@ namespace cryptonote
       return false;
     }
 
-    crypto::hash tx_hash = null_hash;
-    crypto::hash tx_prefixt_hash = null_hash;
-    Transaction tx;
-
-    if(!parse_tx_from_blob(tx, tx_hash, tx_prefixt_hash, tx_blob))
+    if(!parse_tx_from_blob(tx, tx_hash, tx_prefix_hash, tx_blob))
     {
       LOG_PRINT_L0("WRONG TRANSACTION BLOB, Failed to parse, rejected");
       tvc.m_verifivation_failed = true;
@@ -180,7 +224,12 @@ namespace cryptonote
       return false;
     }
 
-    bool r = add_new_tx(tx, tx_hash, tx_prefixt_hash, tx_blob.size(), tvc, keeped_by_block);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::add_incoming_tx(const Transaction& tx, const crypto::hash& tx_hash, const crypto::hash& tx_prefix_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block)
+  {
+    bool r = add_new_tx(tx, tx_hash, tx_prefix_hash, blob_size, tvc, keeped_by_block);
     if(tvc.m_verifivation_failed) {
       if (!tvc.m_tx_fee_too_small) {
         LOG_PRINT_RED_L0("Transaction verification failed: " << tx_hash);
@@ -305,14 +354,13 @@ namespace cryptonote
   bool core::add_new_tx(const Transaction& tx, const crypto::hash& tx_hash, const crypto::hash& tx_prefix_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block) {
     if (m_blockchain_storage.have_tx(tx_hash)) {
       LOG_PRINT_L2("tx " << tx_hash << " is already in blockchain");
+      tvc.m_already_exists = true;
       return true;
     }
 
-    // It's not very good to lock on m_mempool here, because it's very hard to understand the order of locking
-    // tx_memory_pool::m_transactions_lock, blockchain_storage::m_blockchain_lock, and core::m_incoming_tx_lock
-    CRITICAL_REGION_LOCAL(m_mempool);
     if (m_mempool.have_tx(tx_hash)) {
       LOG_PRINT_L2("tx " << tx_hash << " is already in transaction pool");
+      tvc.m_already_exists = true;
       return true;
     }
 
@@ -333,6 +381,11 @@ namespace cryptonote
   {
     return m_blockchain_storage.find_blockchain_supplement(qblock_ids, blocks, total_height, start_height, max_count);
   }
+
+  bool core::find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count)
+  {
+    return m_blockchain_storage.find_blockchain_supplement(qblock_ids, blocks, total_height, start_height, max_count);
+  }
   //-----------------------------------------------------------------------------------------------
   void core::print_blockchain(uint64_t start_index, uint64_t end_index)
   {
@@ -449,6 +502,29 @@ namespace cryptonote
     return m_blockchain_storage.get_tail_id();
   }
   //-----------------------------------------------------------------------------------------------
+  void core::get_pool_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs)
+  {
+    m_mempool.getTransactions(txs_ids, txs, missed_txs);
+  }
+  //-----------------------------------------------------------------------------------------------
+  void core::get_unknown_transactions(const std::vector<crypto::hash>& txs_ids, std::list<crypto::hash>& unknown_txs)
+  {
+    for (const crypto::hash& id : txs_ids) {
+      if (!m_mempool.have_tx(id) && !m_blockchain_storage.have_tx(id)) {
+        unknown_txs.push_back(id);
+      }
+    }
+  }
+  //-----------------------------------------------------------------------------------------------
+  void core::get_missing_pool_transactions(const std::vector<crypto::hash>& txs_ids, std::list<crypto::hash>& missed_txs)
+  {
+    for (const crypto::hash& id : txs_ids) {
+      if (!m_mempool.have_tx(id)) {
+        missed_txs.push_back(id);
+      }
+    }
+  }
+  //-----------------------------------------------------------------------------------------------
   size_t core::get_pool_transactions_count()
   {
     return m_mempool.get_transactions_count();
@@ -530,6 +606,7 @@ namespace cryptonote
 
     m_miner->on_idle();
     m_mempool.on_idle();
+    m_blockchain_storage.on_idle();
     return true;
   }
   //-----------------------------------------------------------------------------------------------
@@ -553,7 +630,7 @@ namespace cryptonote
     m_observerManager.notify(&ICoreObserver::poolUpdated);
   }
 
-  bool core::queryBlocks(const std::list<crypto::hash>& knownBlockIds, uint64_t timestamp,
+  bool core::queryBlocks(const std::list<crypto::hash>& knownBlockIds, uint64_t timestamp, bool withGlobalOutputIndexes,
       uint64_t& resStartHeight, uint64_t& resCurrentHeight, uint64_t& resFullOffset, std::list<BlockFullInfo>& entries) {
 
     LockedBlockchainStorage lbs(m_blockchain_storage);
@@ -586,31 +663,25 @@ namespace cryptonote
 
     auto blocksLeft = std::min(BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT - entries.size(), size_t(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT));
 
-    if (blocksLeft) {
-      std::list<Block> blocks;
-      lbs->get_blocks(startFullOffset, blocksLeft, blocks);
+    uint64_t endHeight = std::min(startFullOffset + blocksLeft, currentHeight);
+    for (uint64_t height = startFullOffset; height < endHeight; ++height) {
+      BlockFullInfo item;
+      item.block_id = lbs->get_block_id_by_height(height);
 
-      for (auto& b : blocks) {
-        BlockFullInfo item;
-
-        item.block_id = get_block_hash(b);
-
-        if (b.timestamp >= timestamp) {
-          // query transactions
-          std::list<Transaction> txs;
-          std::list<crypto::hash> missedTxs;
-          lbs->get_transactions(b.txHashes, txs, missedTxs);
+      uint64_t blockTimestamp;
+      if (!lbs->getBlockTimestamp(height, blockTimestamp)) {
+        return false;
+      }
 
-          // fill data
-          block_complete_entry& completeEntry = item;
-          completeEntry.block = block_to_blob(b);
-          for (auto& tx : txs) {
-            completeEntry.txs.push_back(tx_to_blob(tx));
-          }
+      if (blockTimestamp >= timestamp) {
+        // stored blobs, no need to deserialize the block and its transactions
+        block_complete_entry& completeEntry = item;
+        if (!lbs->getRawBlock(height, completeEntry, withGlobalOutputIndexes ? &item.global_output_indexes : NULL)) {
+          return false;
         }
-
-        entries.push_back(std::move(item));
       }
+
+      entries.push_back(std::move(item));
     }
 
     resCurrentHeight = currentHeight;
@@ -37,6 +37,9 @@ namespace cryptonote {
      bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp, cryptonote_connection_context& context);
      bool on_idle();
      virtual bool handle_incoming_tx(const blobdata& tx_blob, tx_verification_context& tvc, bool keeped_by_block);
+     // Handles a batch of transactions, the ring signatures of all of them are checked in parallel before they are
+     // added to the pool one by one. Stops at the first invalid transaction, its tvc tells why.
+     bool handle_incoming_txs(const std::list<blobdata>& tx_blobs, std::vector<tx_verification_context>& tvcs, bool keeped_by_block);
      bool handle_incoming_block_blob(const blobdata& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block);
      const Currency& currency() const { return m_currency; }
      virtual i_cryptonote_protocol* get_protocol(){return m_pprotocol;}
@@ -62,7 +65,7 @@ namespace cryptonote {
      {
        return m_blockchain_storage.get_blocks(block_ids, blocks, missed_bs);
      }
-     virtual bool queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
+     virtual bool queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp, bool withGlobalOutputIndexes,
          uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<BlockFullInfo>& entries);
      crypto::hash get_block_id_by_height(uint64_t height);
      void get_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs);
@@ -78,6 +81,10 @@ namespace cryptonote {
      void set_checkpoints(checkpoints&& chk_pts);
 
      void get_pool_transactions(std::list<Transaction>& txs);
+     void get_pool_transactions(const std::vector<crypto::hash>& txs_ids, std::list<Transaction>& txs, std::list<crypto::hash>& missed_txs);
+     //neither in the pool nor in the main chain
+     void get_unknown_transactions(const std::vector<crypto::hash>& txs_ids, std::list<crypto::hash>& unknown_txs);
+     void get_missing_pool_transactions(const std::vector<crypto::hash>& txs_ids, std::list<crypto::hash>& missed_txs);
      size_t get_pool_transactions_count();
      size_t get_blockchain_total_transactions();
      //bool get_outs(uint64_t amount, std::list<crypto::public_key>& pkeys);
@@ -85,6 +92,7 @@ namespace cryptonote {
      bool get_short_chain_history(std::list<crypto::hash>& ids);
      virtual bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, NOTIFY_RESPONSE_CHAIN_ENTRY_request& resp);
      virtual bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<std::pair<Block, std::list<Transaction> > >& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
+     bool find_blockchain_supplement(const std::list<crypto::hash>& qblock_ids, std::list<block_complete_entry>& blocks, uint64_t& total_height, uint64_t& start_height, size_t max_count);
      bool get_stat_info(core_stat_info& st_inf);
      //bool get_backward_blocks_sizes(uint64_t from_height, std::vector<size_t>& sizes, size_t count);
      virtual bool get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs);
@@ -107,6 +115,9 @@ namespace cryptonote {
      bool add_new_tx(const Transaction& tx, tx_verification_context& tvc, bool keeped_by_block);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash, const blobdata& blob);
+     //checks of the transaction itself, its inputs are checked when it is added to the pool
+     bool check_incoming_tx(const blobdata& tx_blob, Transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash, tx_verification_context& tvc, bool keeped_by_block);
+     bool add_incoming_tx(const Transaction& tx, const crypto::hash& tx_hash, const crypto::hash& tx_prefix_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block);
      bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
 
      bool check_tx_syntax(const Transaction& tx);
@@ -131,7 +142,6 @@ namespace cryptonote {
      tx_memory_pool m_mempool;
      blockchain_storage m_blockchain_storage;
      i_cryptonote_protocol* m_pprotocol;
-     epee::critical_section m_incoming_tx_lock;
      std::unique_ptr<miner> m_miner;
      std::string m_config_folder;
      cryptonote_protocol_stub m_protocol_stub;
@@ -3,6 +3,7 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <atomic>
 #include <set>
 
 // epee
@@ -19,8 +20,30 @@
 
 using namespace epee;
 
+namespace
+{
+  std::atomic<uint64_t> transactionHashes(0);
+  std::atomic<uint64_t> transactionHashCacheHits(0);
+  std::atomic<uint64_t> prefixHashes(0);
+  std::atomic<uint64_t> prefixHashCacheHits(0);
+  std::atomic<uint64_t> blockHashes(0);
+  std::atomic<uint64_t> blockHashCacheHits(0);
+}
+
 namespace cryptonote
 {
+  //---------------------------------------------------------------
+  ObjectHashStatistics get_object_hash_statistics()
+  {
+    ObjectHashStatistics statistics;
+    statistics.transactionHashes = transactionHashes.load(std::memory_order_relaxed);
+    statistics.transactionHashCacheHits = transactionHashCacheHits.load(std::memory_order_relaxed);
+    statistics.prefixHashes = prefixHashes.load(std::memory_order_relaxed);
+    statistics.prefixHashCacheHits = prefixHashCacheHits.load(std::memory_order_relaxed);
+    statistics.blockHashes = blockHashes.load(std::memory_order_relaxed);
+    statistics.blockHashCacheHits = blockHashCacheHits.load(std::memory_order_relaxed);
+    return statistics;
+  }
   //---------------------------------------------------------------
   void get_transaction_prefix_hash(const TransactionPrefix& tx, crypto::hash& h)
   {
@@ -37,6 +60,26 @@ namespace cryptonote
     return h;
   }
   //---------------------------------------------------------------
+  void get_transaction_prefix_hash(const Transaction& tx, crypto::hash& h)
+  {
+    size_t unused;
+    if (tx.prefixHashCache.get(h, unused)) {
+      prefixHashCacheHits.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    get_transaction_prefix_hash(static_cast<const TransactionPrefix&>(tx), h);
+    prefixHashes.fetch_add(1, std::memory_order_relaxed);
+    tx.prefixHashCache.set(h, 0);
+  }
+  //---------------------------------------------------------------
+  crypto::hash get_transaction_prefix_hash(const Transaction& tx)
+  {
+    crypto::hash h = null_hash;
+    get_transaction_prefix_hash(tx, h);
+    return h;
+  }
+  //---------------------------------------------------------------
   bool parse_and_validate_tx_from_blob(const blobdata& tx_blob, Transaction& tx)
   {
     std::stringstream ss;
@@ -57,6 +100,8 @@ namespace cryptonote
     //TODO: validate tx
 
     crypto::cn_fast_hash(tx_blob.data(), tx_blob.size(), tx_hash);
+    transactionHashes.fetch_add(1, std::memory_order_relaxed);
+    tx.hashCache.set(tx_hash, tx_blob.size());
     get_transaction_prefix_hash(tx, tx_prefix_hash);
     return true;
   }
@@ -144,6 +189,7 @@ namespace cryptonote
     tx.extra.resize(tx.extra.size() + 1 + sizeof(crypto::public_key));
     tx.extra[tx.extra.size() - 1 - sizeof(crypto::public_key)] = TX_EXTRA_TAG_PUBKEY;
     *reinterpret_cast<crypto::public_key*>(&tx.extra[tx.extra.size() - sizeof(crypto::public_key)]) = tx_pub_key;
+    tx.invalidateHashes();
     return true;
   }
   //---------------------------------------------------------------
@@ -588,19 +634,53 @@ namespace cryptonote
   {
     crypto::hash h = null_hash;
     size_t blob_size = 0;
-    get_object_hash(t, h, blob_size);
+    get_transaction_hash(t, h, blob_size);
     return h;
   }
   //---------------------------------------------------------------
   bool get_transaction_hash(const Transaction& t, crypto::hash& res)
   {
     size_t blob_size = 0;
-    return get_object_hash(t, res, blob_size);
+    return get_transaction_hash(t, res, blob_size);
   }
   //---------------------------------------------------------------
   bool get_transaction_hash(const Transaction& t, crypto::hash& res, size_t& blob_size)
   {
-    return get_object_hash(t, res, blob_size);
+    if (t.hashCache.get(res, blob_size)) {
+      transactionHashCacheHits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    if (!get_object_hash(t, res, blob_size)) {
+      return false;
+    }
+
+    transactionHashes.fetch_add(1, std::memory_order_relaxed);
+    t.hashCache.set(res, blob_size);
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool get_object_blobsize(const Transaction& t, size_t& size)
+  {
+    crypto::hash unused;
+    if (t.hashCache.get(unused, size)) {
+      transactionHashCacheHits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    if (!t.hashCache.enabled()) {
+      return get_object_blobsize<Transaction>(t, size);
+    }
+
+    // the hash is cached along with the size, it is needed sooner or later
+    return get_transaction_hash(t, unused, size);
+  }
+  //---------------------------------------------------------------
+  size_t get_object_blobsize(const Transaction& t)
+  {
+    size_t size;
+    get_object_blobsize(t, size);
+    return size;
   }
   //---------------------------------------------------------------
   bool get_block_hashing_blob(const Block& b, blobdata& blob) {
@@ -615,12 +695,20 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   bool get_block_hash(const Block& b, crypto::hash& res) {
+    size_t unused;
+    if (b.hashCache.get(res, unused)) {
+      blockHashCacheHits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
     blobdata blob;
-    if (!get_block_hashing_blob(b, blob)) {
+    if (!get_block_hashing_blob(b, blob) || !get_object_hash(blob, res)) {
       return false;
     }
 
-    return get_object_hash(blob, res);
+    blockHashes.fetch_add(1, std::memory_order_relaxed);
+    b.hashCache.set(res, 0);
+    return true;
   }
   //---------------------------------------------------------------
   crypto::hash get_block_hash(const Block& b) {
@@ -648,6 +736,37 @@ namespace cryptonote
     return true;
   }
   //---------------------------------------------------------------
+  bool get_block_longhashes(crypto::cn_context *const *contexts, Block& b, const uint32_t* nonces, size_t count, crypto::hash* res) {
+    CHECK_AND_ASSERT_MES(count == 1 || count == 2 || count == 4, false, "unsupported number of interleaved hashes: " << count);
+    uint32_t nonce = b.nonce;
+    blobdata blobs[4];
+    const void* data[4];
+    bool sameSize = true;
+    for (size_t i = 0; i < count; ++i) {
+      b.nonce = nonces[i];
+      if (!get_block_hashing_blob(b, blobs[i])) {
+        b.nonce = nonce;
+        return false;
+      }
+
+      data[i] = blobs[i].data();
+      sameSize = sameSize && blobs[i].size() == blobs[0].size();
+    }
+
+    b.nonce = nonce;
+    if (count == 1 || !sameSize) {
+      for (size_t i = 0; i < count; ++i) {
+        crypto::cn_slow_hash(*contexts[i], blobs[i].data(), blobs[i].size(), res[i]);
+      }
+    } else if (count == 2) {
+      crypto::cn_slow_hash_2(contexts, data, blobs[0].size(), res);
+    } else {
+      crypto::cn_slow_hash_4(contexts, data, blobs[0].size(), res);
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------
   std::vector<uint64_t> relative_output_offsets_to_absolute(const std::vector<uint64_t>& off)
   {
     std::vector<uint64_t> res = off;
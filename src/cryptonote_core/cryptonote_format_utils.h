@@ -20,9 +20,24 @@
 
 namespace cryptonote
 {
+  //---------------------------------------------------------------
+  // Number of transaction and block hashes computed and taken from the caches of the objects, see CachedHash.
+  struct ObjectHashStatistics {
+    uint64_t transactionHashes;
+    uint64_t transactionHashCacheHits;
+    uint64_t prefixHashes;
+    uint64_t prefixHashCacheHits;
+    uint64_t blockHashes;
+    uint64_t blockHashCacheHits;
+  };
+
+  ObjectHashStatistics get_object_hash_statistics();
+
   //---------------------------------------------------------------
   void get_transaction_prefix_hash(const TransactionPrefix& tx, crypto::hash& h);
   crypto::hash get_transaction_prefix_hash(const TransactionPrefix& tx);
+  void get_transaction_prefix_hash(const Transaction& tx, crypto::hash& h);
+  crypto::hash get_transaction_prefix_hash(const Transaction& tx);
   bool parse_and_validate_tx_from_blob(const blobdata& tx_blob, Transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash);
   bool parse_and_validate_tx_from_blob(const blobdata& tx_blob, Transaction& tx);
 
@@ -99,6 +114,8 @@ namespace cryptonote
   bool get_block_hash(const Block& b, crypto::hash& res);
   crypto::hash get_block_hash(const Block& b);
   bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::hash& res);
+  // Long hashes of b for each of count nonces (1, 2 or 4) computed together, contexts holds count scratchpads.
+  bool get_block_longhashes(crypto::cn_context *const *contexts, Block& b, const uint32_t* nonces, size_t count, crypto::hash* res);
   bool parse_and_validate_block_from_blob(const blobdata& b_blob, Block& b);
   uint64_t get_outs_money_amount(const Transaction& tx);
   bool check_inputs_types_supported(const Transaction& tx);
@@ -156,6 +173,9 @@ namespace cryptonote
     return size;
   }
   //---------------------------------------------------------------
+  bool get_object_blobsize(const Transaction& t, size_t& size);
+  size_t get_object_blobsize(const Transaction& t);
+  //---------------------------------------------------------------
   template<class t_object>
   bool get_object_hash(const t_object& o, crypto::hash& res, size_t& blob_size)
   {
@@ -177,6 +177,10 @@ void serialize(TransactionPrefix& txP, const std::string& name, ISerializer& ser
 }
 
 void serialize(Transaction& tx, const std::string& name, ISerializer& serializer) {
+  if (serializer.type() == ISerializer::INPUT) {
+    tx.enableHashCache();
+  }
+
   serializer.beginObject(name);
 
   uint64_t version = static_cast<uint64_t>(tx.version);
@@ -350,6 +354,10 @@ void serialize(BlockHeader& header, const std::string& name, ISerializer& serial
 }
 
 void serialize(Block& block, const std::string& name, ISerializer& serializer) {
+  if (serializer.type() == ISerializer::INPUT) {
+    block.hashCache.reset(true);
+  }
+
   serializer.beginObject(name);
 
   serializeBlockHeader(block, serializer);
@@ -31,6 +31,11 @@ using namespace epee;
 
 namespace cryptonote
 {
+  namespace
+  {
+    // nonces every mining thread hashes together with the interleaved slow hash, each needs its own scratchpad
+    const size_t HASHES_PER_ROUND = 2;
+  }
 
   miner::miner(const Currency& currency, i_miner_handler* phandler):
     m_currency(currency),
@@ -58,6 +63,8 @@ namespace cryptonote
   bool miner::set_block_template(const Block& bl, const difficulty_type& di) {
     CRITICAL_REGION_LOCAL(m_template_lock);
     m_template = bl;
+    // only the nonce changes while mining, the miner transaction is hashed once per template
+    m_template.minerTx.enableHashCache();
 
     m_diffic = di;
     ++m_template_no;
@@ -245,22 +252,31 @@ namespace cryptonote
 
       for (unsigned i = 0; i < nthreads; ++i) {
         threads[i] = std::async(std::launch::async, [&, i]() {
-          crypto::cn_context localctx;
-          crypto::hash h;
+          crypto::pooled_cn_context localctx[HASHES_PER_ROUND];
+          crypto::cn_context* contexts[HASHES_PER_ROUND];
+          uint32_t nonces[HASHES_PER_ROUND];
+          crypto::hash h[HASHES_PER_ROUND];
+          for (size_t j = 0; j < HASHES_PER_ROUND; ++j) {
+            contexts[j] = &localctx[j].get();
+          }
 
           Block lb(bl); // copy to local block
 
-          for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
+          for (uint32_t nonce = startNonce + i; !found; nonce += nthreads * HASHES_PER_ROUND) {
+            for (size_t j = 0; j < HASHES_PER_ROUND; ++j) {
+              nonces[j] = nonce + static_cast<uint32_t>(j * nthreads);
+            }
 
-            if (!get_block_longhash(localctx, lb, h)) {
+            if (!get_block_longhashes(contexts, lb, nonces, HASHES_PER_ROUND, h)) {
               return;
             }
 
-            if (check_hash(h, diffic)) {
-              foundNonce = nonce;
-              found = true;
-              return;
+            for (size_t j = 0; j < HASHES_PER_ROUND; ++j) {
+              if (check_hash(h[j], diffic)) {
+                foundNonce = nonces[j];
+                found = true;
+                return;
+              }
             }
           }
         });
@@ -331,7 +347,12 @@ namespace cryptonote
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    crypto::cn_context context;
+    crypto::pooled_cn_context context[HASHES_PER_ROUND];
+    crypto::cn_context* contexts[HASHES_PER_ROUND];
+    for (size_t i = 0; i < HASHES_PER_ROUND; ++i) {
+      contexts[i] = &context[i].get();
+    }
+
     Block b;
     while(!m_stop)
     {
@@ -359,16 +380,24 @@ namespace cryptonote
         continue;
       }
 
-      b.nonce = nonce;
-      crypto::hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
+      uint32_t nonces[HASHES_PER_ROUND];
+      for (size_t i = 0; i < HASHES_PER_ROUND; ++i) {
+        nonces[i] = nonce + static_cast<uint32_t>(i * m_threads_total);
+      }
+
+      crypto::hash h[HASHES_PER_ROUND];
+      if (!m_stop && !get_block_longhashes(contexts, b, nonces, HASHES_PER_ROUND, h)) {
         LOG_ERROR("Failed to get block long hash");
         m_stop = true;
       }
 
-      if (!m_stop && check_hash(h, local_diff))
+      for (size_t i = 0; i < HASHES_PER_ROUND && !m_stop; ++i)
       {
+        if (!check_hash(h[i], local_diff))
+          continue;
+
         //we lucky!
+        b.nonce = nonces[i];
         ++m_config.current_extra_message_index;
         LOG_PRINT_GREEN("Found block for difficulty: " << local_diff, LOG_LEVEL_0);
         if(!m_phandler->handle_block_found(b))
@@ -379,10 +408,12 @@ namespace cryptonote
           //success update, lets update config
           epee::serialization::store_t_to_json_file(m_config, m_config_folder_path + "/" + cryptonote::parameters::MINER_CONFIG_FILE_NAME);
         }
+
+        break;
       }
 
-      nonce+=m_threads_total;
-      ++m_hashes;
+      nonce += static_cast<uint32_t>(HASHES_PER_ROUND * m_threads_total);
+      m_hashes += HASHES_PER_ROUND;
     }
     LOG_PRINT_L0("Miner thread stopped ["<< th_local_index << "]");
     return true;
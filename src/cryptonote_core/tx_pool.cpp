@@ -92,7 +92,10 @@ namespace cryptonote {
     m_validator(validator), 
     m_timeProvider(timeProvider), 
     m_txCheckInterval(60, timeProvider),
-    m_fee_index(boost::get<1>(m_transactions)) {
+    m_fee_index(boost::get<1>(m_transactions)),
+    m_readyVersion(0),
+    m_chainChanges(0) {
+    m_templateCache.valid = false;
   }
 
   //---------------------------------------------------------------------------------
@@ -131,10 +134,16 @@ namespace cryptonote {
       }
     }
 
+    uint64_t chainChanges;
+    {
+      CRITICAL_REGION_LOCAL(m_transactions_lock);
+      chainChanges = m_chainChanges;
+    }
+
     BlockInfo maxUsedBlock;
 
-    // check inputs
-    bool inputsValid = m_validator.checkTransactionInputs(tx, maxUsedBlock);
+    // check inputs, below the last checkpoint those of a block's transactions are only checked when the block is pushed
+    bool inputsValid = (keptByBlock && m_validator.isInCheckpointZone()) || m_validator.checkTransactionInputs(tx, maxUsedBlock);
 
     if (!inputsValid) {
       if (!keptByBlock) {
@@ -149,6 +158,19 @@ namespace cryptonote {
 
     CRITICAL_REGION_LOCAL(m_transactions_lock);
 
+    // the inputs were checked without the lock, meanwhile the same transaction or one spending the same inputs may
+    // have been added by another thread
+    if (m_transactions.find(id) != m_transactions.end()) {
+      LOG_PRINT_L2("tx " << id << " is already in transaction pool");
+      return true;
+    }
+
+    if (!keptByBlock && haveSpentInputs(tx)) {
+      LOG_PRINT_L0("Transaction with id= " << id << " used already spent inputs");
+      tvc.m_verifivation_failed = true;
+      return false;
+    }
+
     // add to pool
     {
       TransactionDetails txd;
@@ -165,6 +187,11 @@ namespace cryptonote {
 
       auto txd_p = m_transactions.insert(std::move(txd));
       CHECK_AND_ASSERT_MES(txd_p.second, false, "transaction already exists at inserting in memory pool");
+      if (inputsValid && !maxUsedBlock.empty() && chainChanges == m_chainChanges) {
+        setReady(*txd_p.first, true);
+      } else {
+        m_uncheckedTransactions.insert(id);
+      }
     }
 
     tvc.m_added_to_pool = true;
@@ -202,6 +229,8 @@ namespace cryptonote {
     blobSize = txd.blobSize;
     fee = txd.fee;
 
+    ++m_chainChanges;
+    uncheckConflictingTransactions(txd);
     removeTransaction(it);
     return true;
   }
@@ -245,10 +274,23 @@ namespace cryptonote {
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const crypto::hash& top_block_id) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    ++m_chainChanges;
+    // ready transactions stay ready on a longer chain, their inputs spent by the block were unchecked by take_tx
+    uncheckFailedTransactions();
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const crypto::hash& top_block_id) {
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
+    ++m_chainChanges;
+    uncheckFailedTransactions();
+    for (const TransactionDetails* txd : m_readyTransactions) {
+      m_uncheckedTransactions.insert(txd->id);
+    }
+
+    m_readyTransactions.clear();
+    ++m_readyVersion;
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -312,30 +354,35 @@ namespace cryptonote {
     size_t max_total_size = (125 * median_size) / 100 - m_currency.minerTxBlobReservedSize();
     max_total_size = std::min(max_total_size, maxCumulativeSize);
 
-    BlockTemplate blockTemplate;
+    checkUncheckedTransactions();
+    if (m_templateCache.valid && m_templateCache.readyVersion == m_readyVersion && m_templateCache.maxTotalSize == max_total_size) {
+      bl.txHashes = m_templateCache.txHashes;
+      total_size = m_templateCache.totalSize;
+      fee = m_templateCache.fee;
+      return true;
+    }
 
-    for (auto i = m_fee_index.begin(); i != m_fee_index.end(); ++i) {
-      const auto& txd = *i;
+    BlockTemplate blockTemplate;
 
-      if (max_total_size < total_size + txd.blobSize) {
+    for (const TransactionDetails* txd : m_readyTransactions) {
+      if (max_total_size < total_size + txd->blobSize) {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
-
-      // update item state
-      m_fee_index.modify(i, [&checkInfo](TransactionCheckInfo& item) {
-        item = checkInfo;
-      });
-      
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) {
-        total_size += txd.blobSize;
-        fee += txd.fee;
+      if (blockTemplate.addTransaction(txd->id, txd->tx)) {
+        total_size += txd->blobSize;
+        fee += txd->fee;
       }
     }
 
     bl.txHashes = blockTemplate.getTransactions();
+
+    m_templateCache.valid = true;
+    m_templateCache.readyVersion = m_readyVersion;
+    m_templateCache.maxTotalSize = max_total_size;
+    m_templateCache.txHashes = bl.txHashes;
+    m_templateCache.totalSize = total_size;
+    m_templateCache.fee = fee;
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -356,6 +403,11 @@ namespace cryptonote {
       m_spent_key_images.clear();
       m_spentOutputs.clear();
     }
+
+    // the chain may have changed since the pool was stored
+    for (const auto& txd : m_transactions) {
+      m_uncheckedTransactions.insert(txd.id);
+    }
     // Ignore deserialization error
     return true;
   }
@@ -409,10 +461,105 @@ namespace cryptonote {
   }
 
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
+    setReady(*i, false);
+    m_uncheckedTransactions.erase(i->id);
+    m_failedTransactions.erase(i->id);
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
     return m_transactions.erase(i);
   }
 
+  void tx_memory_pool::setReady(const TransactionDetails& txd, bool ready) {
+    bool changed = ready ? m_readyTransactions.insert(&txd).second : m_readyTransactions.erase(&txd) != 0;
+    if (changed) {
+      ++m_readyVersion;
+    }
+  }
+
+  // Unchecks the ready transactions that spend an input of txd, txd is about to be taken into a block.
+  void tx_memory_pool::uncheckConflictingTransactions(const TransactionDetails& txd) {
+    bool hasMultisignatureInputs = false;
+    for (const auto& in : txd.tx.vin) {
+      if (in.type() == typeid(TransactionInputToKey)) {
+        auto it = m_spent_key_images.find(boost::get<TransactionInputToKey>(in).keyImage);
+        if (it == m_spent_key_images.end()) {
+          continue;
+        }
+
+        for (const crypto::hash& id : it->second) {
+          auto conflicting = m_transactions.find(id);
+          if (id != txd.id && conflicting != m_transactions.end() && m_readyTransactions.count(&*conflicting) != 0) {
+            setReady(*conflicting, false);
+            m_uncheckedTransactions.insert(id);
+          }
+        }
+      } else if (in.type() == typeid(TransactionInputMultisignature)) {
+        hasMultisignatureInputs = true;
+      }
+    }
+
+    if (!hasMultisignatureInputs) {
+      return;
+    }
+
+    // multisignature inputs of transactions kept by block are not indexed, look through the ready transactions
+    std::set<GlobalOutput> outputs;
+    for (const auto& in : txd.tx.vin) {
+      if (in.type() == typeid(TransactionInputMultisignature)) {
+        const auto& msig = boost::get<TransactionInputMultisignature>(in);
+        outputs.insert(GlobalOutput(msig.amount, msig.outputIndex));
+      }
+    }
+
+    for (auto it = m_readyTransactions.begin(); it != m_readyTransactions.end();) {
+      const TransactionDetails* ready = *it;
+      bool conflicts = false;
+      for (const auto& in : ready->tx.vin) {
+        if (in.type() == typeid(TransactionInputMultisignature)) {
+          const auto& msig = boost::get<TransactionInputMultisignature>(in);
+          conflicts = conflicts || outputs.count(GlobalOutput(msig.amount, msig.outputIndex)) != 0;
+        }
+      }
+
+      if (conflicts && ready->id != txd.id) {
+        m_uncheckedTransactions.insert(ready->id);
+        it = m_readyTransactions.erase(it);
+        ++m_readyVersion;
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void tx_memory_pool::uncheckFailedTransactions() {
+    m_uncheckedTransactions.insert(m_failedTransactions.begin(), m_failedTransactions.end());
+    m_failedTransactions.clear();
+  }
+
+  void tx_memory_pool::checkUncheckedTransactions() {
+    for (const crypto::hash& id : m_uncheckedTransactions) {
+      auto it = m_transactions.find(id);
+      if (it == m_transactions.end()) {
+        continue;
+      }
+
+      TransactionCheckInfo checkInfo(*it);
+      bool ready = is_transaction_ready_to_go(it->tx, checkInfo);
+
+      // update item state
+      m_transactions.modify(it, [&checkInfo](TransactionCheckInfo& item) {
+        item = checkInfo;
+      });
+
+      if (ready) {
+        setReady(*it, true);
+      } else {
+        m_failedTransactions.insert(id);
+      }
+    }
+
+    m_uncheckedTransactions.clear();
+  }
+
   bool tx_memory_pool::removeTransactionInputs(const crypto::hash& tx_id, const Transaction& tx, bool keptByBlock) {
     for (const auto& in : tx.vin) {
       if (in.type() == typeid(TransactionInputToKey)) {
@@ -6,6 +6,7 @@
 #pragma once
 #include "include_base_utils.h"
 
+#include <cstring>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -168,6 +169,24 @@ namespace cryptonote {
       }
     };
 
+    struct ReadyTransactionComparator {
+      bool operator()(const TransactionDetails* lhs, const TransactionDetails* rhs) const {
+        TransactionPriorityComparator priority;
+        return priority(*lhs, *rhs) || (!priority(*rhs, *lhs) && memcmp(&lhs->id, &rhs->id, sizeof(crypto::hash)) < 0);
+      }
+    };
+
+    // Block template of the last fill_block_template call, reused while neither the ready transactions nor the
+    // size limit change.
+    struct TemplateCache {
+      bool valid;
+      uint64_t readyVersion;
+      size_t maxTotalSize;
+      std::vector<crypto::hash> txHashes;
+      size_t totalSize;
+      uint64_t fee;
+    };
+
     typedef hashed_unique<BOOST_MULTI_INDEX_MEMBER(TransactionDetails, crypto::hash, id)> main_index_t;
     typedef ordered_non_unique<identity<TransactionDetails>, TransactionPriorityComparator> fee_index_t;
 
@@ -189,6 +208,12 @@ namespace cryptonote {
     bool removeExpiredTransactions();
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
 
+    // ready set maintenance
+    void setReady(const TransactionDetails& txd, bool ready);
+    void uncheckConflictingTransactions(const TransactionDetails& txd);
+    void uncheckFailedTransactions();
+    void checkUncheckedTransactions();
+
     tools::ObserverManager<ITxPoolObserver> m_observerManager;
 
     const cryptonote::Currency& m_currency;
@@ -204,6 +229,20 @@ namespace cryptonote {
     tx_container_t m_transactions;  
     tx_container_t::nth_index<1>::type& m_fee_index;
 
+    // Every pool transaction is in exactly one of these: ready to go into a block on top of the current chain, not
+    // checked against the current chain yet, or found not ready on the current chain. Transactions are checked
+    // when they arrive and the failed ones again after the chain changes, so fill_block_template only selects from
+    // m_readyTransactions. A block's transactions leave the pool through take_tx, which also unchecks the ones
+    // spending the same inputs. Popping a block unchecks everything.
+    std::set<const TransactionDetails*, ReadyTransactionComparator> m_readyTransactions;
+    std::unordered_set<crypto::hash> m_uncheckedTransactions;
+    std::unordered_set<crypto::hash> m_failedTransactions;
+    uint64_t m_readyVersion;
+    // Incremented by take_tx and the chain notifications. add_tx checks inputs without holding the lock, a change
+    // in between means the result may be stale and the transaction goes in unchecked.
+    uint64_t m_chainChanges;
+    TemplateCache m_templateCache;
+
 #if defined(DEBUG_CREATE_BLOCK_TEMPLATE)
     friend class blockchain_storage;
 #endif
@@ -16,6 +16,7 @@ namespace cryptonote
     bool m_verifivation_impossible; //the transaction is related with an alternative blockchain
     bool m_added_to_pool; 
     bool m_tx_fee_too_small;
+    bool m_already_exists; //in the pool or the chain
   };
 
   struct block_verification_context
@@ -32,11 +32,14 @@ namespace cryptonote
   struct BlockFullInfo : public block_complete_entry
   {
     crypto::hash block_id;
+    // of the miner transaction outputs and then of the outputs of txs, empty unless requested
+    std::vector<uint64_t> global_output_indexes;
 
     BEGIN_KV_SERIALIZE_MAP()
     KV_SERIALIZE_VAL_POD_AS_BLOB(block_id)
     KV_SERIALIZE(block)
     KV_SERIALIZE(txs)
+    KV_SERIALIZE_CONTAINER_POD_AS_BLOB(global_output_indexes)
     END_KV_SERIALIZE_MAP()
   };
 
@@ -68,9 +71,11 @@ namespace cryptonote
   struct NOTIFY_NEW_TRANSACTIONS_request
   {
     std::list<blobdata>   txs;
+    std::list<crypto::hash> missed_txs; //requested with NOTIFY_REQUEST_TXS but no longer in the pool
 
     BEGIN_KV_SERIALIZE_MAP()
       KV_SERIALIZE(txs)
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(missed_txs)
     END_KV_SERIALIZE_MAP()
   };
 
@@ -126,10 +131,14 @@ namespace cryptonote
   {
     uint64_t current_height;
     crypto::hash  top_id;
+    bool compact_blocks; //peer handles NOTIFY_NEW_COMPACT_BLOCK, absent (false) in the sync data of older peers
+    bool tx_inventory; //peer handles NOTIFY_TX_INVENTORY, absent (false) in the sync data of older peers
 
     BEGIN_KV_SERIALIZE_MAP()
       KV_SERIALIZE(current_height)
       KV_SERIALIZE_VAL_POD_AS_BLOB(top_id)
+      KV_SERIALIZE(compact_blocks)
+      KV_SERIALIZE(tx_inventory)
     END_KV_SERIALIZE_MAP()
   };
 
@@ -166,4 +175,86 @@ namespace cryptonote
     typedef NOTIFY_RESPONSE_CHAIN_ENTRY_request request;
   };
 
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_NEW_COMPACT_BLOCK_request
+  {
+    blobdata block; //header, miner transaction and txHashes, the transactions are taken from the pool of the receiver
+    uint64_t current_blockchain_height;
+    uint32_t hop;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(block)
+      KV_SERIALIZE(current_blockchain_height)
+      KV_SERIALIZE(hop)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_NEW_COMPACT_BLOCK
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 8;
+    typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS_request
+  {
+    crypto::hash block_id;
+    std::list<crypto::hash> txs; //transactions of the block missing in the pool of the requester
+    uint32_t hop; //of the compact block, returned in the response
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_VAL_POD_AS_BLOB(block_id)
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txs)
+      KV_SERIALIZE(hop)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 9;
+    typedef NOTIFY_REQUEST_BLOCK_TXS_request request;
+  };
+
+  //the block with the requested transactions only, the others are in the pool of the requester
+  struct NOTIFY_RESPONSE_BLOCK_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 10;
+    typedef NOTIFY_NEW_BLOCK_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_TX_INVENTORY_request
+  {
+    std::list<crypto::hash> txs; //new transactions, the unknown ones are requested with NOTIFY_REQUEST_TXS
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txs)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_TX_INVENTORY
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 11;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  //answered with NOTIFY_NEW_TRANSACTIONS, transactions no longer in the pool are listed in its missed_txs
+  struct NOTIFY_REQUEST_TXS_request
+  {
+    std::list<crypto::hash> txs;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE_CONTAINER_POD_AS_BLOB(txs)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  struct NOTIFY_REQUEST_TXS
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 12;
+    typedef NOTIFY_REQUEST_TXS_request request;
+  };
+
 }
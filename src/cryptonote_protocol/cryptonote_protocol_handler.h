@@ -5,7 +5,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include <boost/program_options/variables_map.hpp>
 #include <common/ObserverManager.h>
@@ -16,6 +23,9 @@
 
 #include "cryptonote_core/connection_context.h"
 #include "cryptonote_core/cryptonote_stat_info.h"
+#include "cryptonote_core/SyncBlockQueue.h"
+#include "cryptonote_core/SyncPeerScores.h"
+#include "cryptonote_core/TxRelayInventory.h"
 #include "cryptonote_core/verification_context.h"
 #include "cryptonote_protocol/cryptonote_protocol_defs.h"
 #include "cryptonote_protocol/cryptonote_protocol_handler_common.h"
@@ -37,6 +47,7 @@ namespace cryptonote {
     typedef CORE_SYNC_DATA payload_type;
 
     t_cryptonote_protocol_handler(t_core& rcore, nodetool::i_p2p_endpoint<connection_context>* p_net_layout);
+    ~t_cryptonote_protocol_handler();
 
     BEGIN_INVOKE_MAP2(cryptonote_protocol_handler)
       HANDLE_NOTIFY_T2(NOTIFY_NEW_BLOCK, &cryptonote_protocol_handler::handle_notify_new_block)
@@ -45,6 +56,11 @@ namespace cryptonote {
       HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_GET_OBJECTS, &cryptonote_protocol_handler::handle_response_get_objects)
       HANDLE_NOTIFY_T2(NOTIFY_REQUEST_CHAIN, &cryptonote_protocol_handler::handle_request_chain)
       HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_CHAIN_ENTRY, &cryptonote_protocol_handler::handle_response_chain_entry)
+      HANDLE_NOTIFY_T2(NOTIFY_NEW_COMPACT_BLOCK, &cryptonote_protocol_handler::handle_notify_new_compact_block)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_BLOCK_TXS, &cryptonote_protocol_handler::handle_request_block_txs)
+      HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_BLOCK_TXS, &cryptonote_protocol_handler::handle_response_block_txs)
+      HANDLE_NOTIFY_T2(NOTIFY_TX_INVENTORY, &cryptonote_protocol_handler::handle_notify_tx_inventory)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_TXS, &cryptonote_protocol_handler::handle_request_txs)
     END_INVOKE_MAP2()
 
     bool init();
@@ -57,6 +73,7 @@ namespace cryptonote {
     t_core& get_core() { return m_core; }
     bool is_synchronized() const { return m_synchronized; }
     void log_connections();
+    void log_sync_peers();
 
     // Interface t_payload_net_handler, where t_payload_net_handler is template argument of nodetool::node_server
     void stop();
@@ -78,34 +95,65 @@ namespace cryptonote {
     int handle_response_get_objects(int command, NOTIFY_RESPONSE_GET_OBJECTS::request& arg, cryptonote_connection_context& context);
     int handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, cryptonote_connection_context& context);
     int handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, cryptonote_connection_context& context);
+    int handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, cryptonote_connection_context& context);
+    int handle_request_block_txs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, cryptonote_connection_context& context);
+    int handle_response_block_txs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, cryptonote_connection_context& context);
+    int handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg, cryptonote_connection_context& context);
+    int handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, cryptonote_connection_context& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relay_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& exclude_context) override;
     virtual void relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& exclude_context) override;
     //----------------------------------------------------------------------------------
 
+    int process_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context);
+    void serve_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, cryptonote_connection_context& context);
+    void serve_deferred_get_objects();
+    void announce_transactions();
+    void request_expired_transactions();
     bool request_missing_objects(cryptonote_connection_context& context, bool check_having_blocks);
+    void request_needed_objects(cryptonote_connection_context& context, bool check_having_blocks);
+    void validation_loop();
+    bool validate_synchronized_block(const SyncBlock& block);
+    void drop_invalid_source(const epee::net_utils::connection_context_base& source);
+    void wake_waiting_connections();
+    void drop_stalled_connections();
+    void stop_validation();
     size_t get_synchronizing_connections_count();
     bool on_connection_synchronized();
     void updateObservedHeight(uint64_t peerHeight, const cryptonote_connection_context& context);
     void recalculateMaxObservedHeight(const cryptonote_connection_context& context);
+    static epee::net_utils::send_priority get_send_priority(int command);
 
     template<class t_parametr>
-    bool post_notify(typename t_parametr::request& arg, cryptonote_connection_context& context)
+    bool post_notify(typename t_parametr::request& arg, const epee::net_utils::connection_context_base& context)
     {
       LOG_PRINT_L2("[" << epee::net_utils::print_connection_context_short(context) << "] post " << typeid(t_parametr).name() << " -->");
-      std::string blob;
-      epee::serialization::store_t_to_binary(arg, blob);
-      return m_p2p->invoke_notify_to_peer(t_parametr::ID, blob, context);
+      boost::shared_ptr<std::string> blob(new std::string());
+      epee::serialization::store_t_to_binary(arg, *blob);
+      return m_p2p->invoke_notify_to_peer(t_parametr::ID, blob, context, get_send_priority(t_parametr::ID));
     }
 
     template<class t_parametr>
     void relay_post_notify(typename t_parametr::request& arg, cryptonote_connection_context& exlude_context)
     {
       LOG_PRINT_L2("[" << epee::net_utils::print_connection_context_short(exlude_context) << "] post relay " << typeid(t_parametr).name() << " -->");
-      std::string arg_buff;
-      epee::serialization::store_t_to_binary(arg, arg_buff);
-      m_p2p->relay_notify_to_all(t_parametr::ID, arg_buff, exlude_context);
+      //serialized once, every connection queues the same buffer
+      boost::shared_ptr<std::string> arg_buff(new std::string());
+      epee::serialization::store_t_to_binary(arg, *arg_buff);
+      m_p2p->relay_notify_to_all(t_parametr::ID, arg_buff, exlude_context, get_send_priority(t_parametr::ID));
+    }
+
+    template<class t_parametr>
+    void post_notify_to_peers(typename t_parametr::request& arg, const std::list<epee::net_utils::connection_context_base>& peers)
+    {
+      LOG_PRINT_L2("post " << typeid(t_parametr).name() << " to " << peers.size() << " peers -->");
+      boost::shared_ptr<std::string> arg_buff(new std::string());
+      epee::serialization::store_t_to_binary(arg, *arg_buff);
+      epee::net_utils::send_priority priority = get_send_priority(t_parametr::ID);
+      for (const auto& peer : peers) {
+        m_p2p->invoke_notify_to_peer(t_parametr::ID, arg_buff, peer, priority);
+      }
     }
 
   private:
@@ -120,6 +168,17 @@ namespace cryptonote {
     uint64_t m_observedHeight;
 
     std::atomic<size_t> m_peersCount;
+
+    SyncBlockQueue m_syncQueue;
+    TxRelayInventory m_txInventory;
+    SyncPeerScores m_peerScores;
+    std::mutex m_deferredGetObjectsMutex;
+    std::map<boost::uuids::uuid, std::list<NOTIFY_REQUEST_GET_OBJECTS::request>> m_deferredGetObjects;
+    //the first height of each run of blocks one connection delivered below the last checkpoint, these blocks are
+    //accepted without proof of work and only the hash of the next checkpoint tells whether they were forged
+    std::map<uint64_t, epee::net_utils::connection_context_base> m_checkpointZoneSources;
+    std::mutex m_validationThreadMutex;
+    std::thread m_validationThread;
     tools::ObserverManager<ICryptonoteProtocolObserver> m_observerManager;
   };
 }
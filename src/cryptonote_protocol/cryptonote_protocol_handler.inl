@@ -17,21 +17,31 @@ namespace cryptonote
       m_p2p(p_net_layout),
       m_synchronized(false),
       m_stop(false),
-      m_observedHeight(0) {
+      m_observedHeight(0),
+      m_syncQueue(BLOCKS_SYNCHRONIZING_QUEUE_SIZE),
+      m_txInventory(P2P_TX_INVENTORY_KNOWN_LIMIT, std::chrono::seconds(P2P_TX_REQUEST_TIMEOUT)),
+      m_peerScores(P2P_SYNC_PEER_SCORES_LIMIT) {
     if (!m_p2p) {
       m_p2p = &m_p2p_stub;
     }
   }
 
+  template<class t_core>
+  t_cryptonote_protocol_handler<t_core>::~t_cryptonote_protocol_handler() {
+    stop_validation();
+  }
+
   template<class t_core>
   bool t_cryptonote_protocol_handler<t_core>::init() {
     m_peersCount = 0;
+    m_validationThread = std::thread(&t_cryptonote_protocol_handler::validation_loop, this);
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   bool t_cryptonote_protocol_handler<t_core>::deinit()
   {
+    stop_validation();
     return true;
   }
 
@@ -51,6 +61,7 @@ namespace cryptonote
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
   void t_cryptonote_protocol_handler<t_core>::onConnectionOpened(cryptonote_connection_context& context) {
+    m_peerScores.addConnection(context.m_remote_ip);
   }
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
@@ -74,12 +85,30 @@ namespace cryptonote
       m_peersCount--;
       m_observerManager.notify(&ICryptonoteProtocolObserver::peerCountUpdated, m_peersCount.load());
     }
+
+    m_syncQueue.releaseConnection(context.m_connection_id);
+    m_txInventory.removeConnection(context.m_connection_id);
+    m_peerScores.removeConnection(context.m_remote_ip);
+
+    std::lock_guard<std::mutex> lock(m_deferredGetObjectsMutex);
+    m_deferredGetObjects.erase(context.m_connection_id);
   }
 
   //------------------------------------------------------------------------------------------------------------------------  
   template<class t_core>
   void t_cryptonote_protocol_handler<t_core>::stop() {
+    stop_validation();
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::stop_validation() {
     m_stop = true;
+    m_syncQueue.stop();
+
+    std::lock_guard<std::mutex> lock(m_validationThreadMutex);
+    if (m_validationThread.joinable()) {
+      m_validationThread.join();
+    }
   }
 
   //------------------------------------------------------------------------------------------------------------------------  
@@ -92,6 +121,14 @@ namespace cryptonote
 
     if(context.m_state == cryptonote_connection_context::state_synchronizing)
     {
+      if(context.m_waiting_for_sync_queue)
+      {
+        //woken by the validation thread, blocks were validated or released
+        context.m_waiting_for_sync_queue = false;
+        request_missing_objects(context, true);
+        return true;
+      }
+
       NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
       m_core.get_short_chain_history(r.block_ids);
       LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size() );
@@ -116,6 +153,8 @@ namespace cryptonote
       << std::setw(20) << "Peer id"
       << std::setw(25) << "Recv/Sent (inactive,sec)"
       << std::setw(25) << "State"
+      << std::setw(20) << "Duplicate txs"
+      << std::setw(20) << "Send queue(bytes)"
       << std::setw(20) << "Livetime(seconds)" << ENDL;
 
     m_p2p->for_each_connection([&](const connection_context& cntxt, nodetool::peerid_type peer_id)
@@ -125,18 +164,51 @@ namespace cryptonote
         << std::setw(20) << std::hex << peer_id
         << std::setw(25) << std::to_string(cntxt.m_recv_cnt)+ "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
         << std::setw(25) << get_protocol_state_string(cntxt.m_state)
+        << std::setw(20) << std::to_string(cntxt.m_duplicate_txs)
+        << std::setw(20) << std::to_string(cntxt.m_send_que_size)
         << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
       return true;
     });
     LOG_PRINT_L0("Connections: " << ENDL << ss.str());
   }
   //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::log_sync_peers()
+  {
+    std::stringstream ss;
+
+    ss << std::setw(20) << std::left << "Remote Host"
+      << std::setw(15) << "Connections"
+      << std::setw(15) << "Responses"
+      << std::setw(15) << "Invalid"
+      << std::setw(15) << "Stalls"
+      << std::setw(20) << "Round trip(ms)"
+      << std::setw(20) << "Speed(bytes/s)"
+      << std::setw(20) << "Score" << ENDL;
+
+    for (const auto& peer : m_peerScores.getStats()) {
+      const SyncPeerScores::PeerStats& stats = peer.second;
+      ss << std::setw(20) << std::left << epee::string_tools::get_ip_string_from_int32(peer.first)
+        << std::setw(15) << stats.connections
+        << std::setw(15) << stats.responses
+        << std::setw(15) << stats.invalid
+        << std::setw(15) << stats.stalls
+        << std::setw(20) << stats.roundTrip.count()
+        << std::setw(20) << stats.bytesPerSecond
+        << std::setw(20) << static_cast<uint64_t>(stats.score) << ENDL;
+    }
+    LOG_PRINT_L0("Synchronization peers, best first: " << ENDL << ss.str());
+  }
+  //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   bool t_cryptonote_protocol_handler<t_core>::process_payload_sync_data(const CORE_SYNC_DATA& hshd, cryptonote_connection_context& context, bool is_inital)
   {
     if(context.m_state == cryptonote_connection_context::state_befor_handshake && !is_inital)
       return true;
 
+    context.m_supports_compact_blocks = hshd.compact_blocks;
+    context.m_supports_tx_inventory = hshd.tx_inventory;
+
     if(context.m_state == cryptonote_connection_context::state_synchronizing) {
     } else if(m_core.have_block(hshd.top_id)) {
       context.m_state = cryptonote_connection_context::state_normal;
@@ -161,6 +233,7 @@ namespace cryptonote
     context.m_remote_blockchain_height = hshd.current_height;
 
     if (is_inital) {
+      m_txInventory.addConnection(context.m_connection_id);
       m_peersCount++;
       m_observerManager.notify(&ICryptonoteProtocolObserver::peerCountUpdated, m_peersCount.load());
     }
@@ -173,6 +246,8 @@ namespace cryptonote
   {
     m_core.get_blockchain_top(hshd.current_height, hshd.top_id);
     hshd.current_height +=1;
+    hshd.compact_blocks = true;
+    hshd.tx_inventory = true;
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------  
@@ -188,9 +263,114 @@ namespace cryptonote
       return 1;
     }
 
-    for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
-      cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      m_core.handle_incoming_tx(*tx_blob_it, tvc, true);
+    return process_new_block(arg, context);
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")");
+
+    updateObservedHeight(arg.current_blockchain_height, context);
+
+    context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+    if (context.m_state != cryptonote_connection_context::state_normal) {
+      return 1;
+    }
+
+    Block b;
+    if (!parse_and_validate_block_from_blob(arg.block, b)) {
+      LOG_PRINT_CCONTEXT_L1("Failed to parse compact block, dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    crypto::hash id = get_block_hash(b);
+    if (m_core.have_block(id)) {
+      return 1;
+    }
+
+    //an orphaned block goes to the core as it is, the chain is requested instead of its transactions
+    NOTIFY_REQUEST_BLOCK_TXS::request request;
+    if (m_core.have_block(b.prevId)) {
+      m_core.get_missing_pool_transactions(b.txHashes, request.txs);
+    }
+
+    if (!request.txs.empty()) {
+      request.block_id = id;
+      request.hop = arg.hop;
+      LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << request.txs.size() << " of " << b.txHashes.size());
+      post_notify<NOTIFY_REQUEST_BLOCK_TXS>(request, context);
+      return 1;
+    }
+
+    NOTIFY_NEW_BLOCK::request block;
+    block.b.block = std::move(arg.block);
+    block.current_blockchain_height = arg.current_blockchain_height;
+    block.hop = arg.hop;
+    return process_new_block(block, context);
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_block_txs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << arg.txs.size());
+
+    Block b;
+    if (!m_core.get_block_by_hash(arg.block_id, b)) {
+      LOG_PRINT_CCONTEXT_L1("NOTIFY_REQUEST_BLOCK_TXS for unknown block " << arg.block_id << ", ignored");
+      return 1;
+    }
+
+    if (arg.txs.size() > b.txHashes.size()) {
+      LOG_ERROR_CCONTEXT("sent wrong NOTIFY_REQUEST_BLOCK_TXS: txs.size()=" << arg.txs.size() << " > txHashes.size()=" << b.txHashes.size()
+        << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    //the block was relayed after it had been added, its transactions are in the main chain unless it was reorganized away
+    std::vector<crypto::hash> txIds(arg.txs.begin(), arg.txs.end());
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missedTxs;
+    m_core.get_transactions(txIds, txs, missedTxs);
+    if (!missedTxs.empty()) {
+      LOG_PRINT_CCONTEXT_L1("NOTIFY_REQUEST_BLOCK_TXS for block " << arg.block_id << " not in the main chain, ignored");
+      return 1;
+    }
+
+    NOTIFY_RESPONSE_BLOCK_TXS::request rsp;
+    rsp.current_blockchain_height = m_core.get_current_blockchain_height();
+    rsp.hop = arg.hop;
+    rsp.b.block = block_to_blob(b);
+    for (const Transaction& tx : txs) {
+      rsp.b.txs.push_back(tx_to_blob(tx));
+    }
+
+    LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_RESPONSE_BLOCK_TXS: txs.size()=" << rsp.b.txs.size());
+    post_notify<NOTIFY_RESPONSE_BLOCK_TXS>(rsp, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_response_block_txs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, cryptonote_connection_context& context) {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_RESPONSE_BLOCK_TXS (hop " << arg.hop << ")");
+
+    updateObservedHeight(arg.current_blockchain_height, context);
+
+    context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+    if (context.m_state != cryptonote_connection_context::state_normal) {
+      return 1;
+    }
+
+    return process_new_block(arg, context);
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::process_new_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& context) {
+    std::vector<cryptonote::tx_verification_context> tvcs;
+    m_core.handle_incoming_txs(arg.b.txs, tvcs, true);
+    for (const cryptonote::tx_verification_context& tvc : tvcs) {
       if (tvc.m_verifivation_failed) {
         LOG_PRINT_CCONTEXT_L0("Block verification failed: transaction verification failed, dropping connection");
         m_p2p->drop_connection(context);
@@ -227,16 +407,32 @@ namespace cryptonote
     if(context.m_state != cryptonote_connection_context::state_normal)
       return 1;
 
-    for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end();)
+    std::vector<crypto::hash> txIds;
+    txIds.reserve(arg.txs.size());
+    for (const blobdata& txBlob : arg.txs) {
+      txIds.push_back(get_blob_hash(txBlob));
+    }
+
+    m_txInventory.addKnown(context.m_connection_id, txIds);
+    m_txInventory.received(txIds);
+    if (!arg.missed_txs.empty()) {
+      m_txInventory.missed(context.m_connection_id, std::vector<crypto::hash>(arg.missed_txs.begin(), arg.missed_txs.end()));
+    }
+
+    std::vector<cryptonote::tx_verification_context> tvcs;
+    m_core.handle_incoming_txs(arg.txs, tvcs, false);
+    auto tvc_it = tvcs.begin();
+    for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end(); ++tvc_it)
     {
-      cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      m_core.handle_incoming_tx(*tx_blob_it, tvc, false);
+      const cryptonote::tx_verification_context& tvc = *tvc_it;
       if(tvc.m_verifivation_failed)
       {
         LOG_PRINT_CCONTEXT_L0("Tx verification failed, dropping connection");
         m_p2p->drop_connection(context);
         return 1;
       }
+      if(tvc.m_already_exists)
+        ++context.m_duplicate_txs;
       if(tvc.m_should_be_relayed)
         ++tx_blob_it;
       else
@@ -245,17 +441,99 @@ namespace cryptonote
 
     if(arg.txs.size())
     {
-      //TODO: add announce usage here
       relay_transactions(arg, context);
     }
 
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_notify_tx_inventory(int command, NOTIFY_TX_INVENTORY::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_TX_INVENTORY: txs.size()=" << arg.txs.size());
+    if (arg.txs.size() > P2P_TX_INVENTORY_MAX_COUNT) {
+      LOG_ERROR_CCONTEXT("sent wrong NOTIFY_TX_INVENTORY: txs.size()=" << arg.txs.size() << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    if (context.m_state != cryptonote_connection_context::state_normal) {
+      return 1;
+    }
+
+    std::vector<crypto::hash> txIds(arg.txs.begin(), arg.txs.end());
+    m_txInventory.addKnown(context.m_connection_id, txIds);
+
+    std::list<crypto::hash> unknownTxs;
+    m_core.get_unknown_transactions(txIds, unknownTxs);
+
+    //a transaction announced by several peers is requested from the first one, the others are asked on idle if it does not arrive
+    std::vector<crypto::hash> requestedTxs;
+    m_txInventory.takeRequests(context.m_connection_id, std::vector<crypto::hash>(unknownTxs.begin(), unknownTxs.end()), std::chrono::steady_clock::now(), requestedTxs);
+    if (!requestedTxs.empty()) {
+      NOTIFY_REQUEST_TXS::request request;
+      request.txs.assign(requestedTxs.begin(), requestedTxs.end());
+      LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_TXS: txs.size()=" << request.txs.size());
+      post_notify<NOTIFY_REQUEST_TXS>(request, context);
+    }
+
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_txs(int command, NOTIFY_REQUEST_TXS::request& arg, cryptonote_connection_context& context)
+  {
+    LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_TXS: txs.size()=" << arg.txs.size());
+    if (arg.txs.size() > P2P_TX_INVENTORY_MAX_COUNT) {
+      LOG_ERROR_CCONTEXT("sent wrong NOTIFY_REQUEST_TXS: txs.size()=" << arg.txs.size() << ", dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missedTxs;
+    m_core.get_pool_transactions(std::vector<crypto::hash>(arg.txs.begin(), arg.txs.end()), txs, missedTxs);
+    if (txs.empty() && missedTxs.empty()) {
+      return 1;
+    }
+
+    //the missed transactions are listed, so the peer requests them from another one right away
+    NOTIFY_NEW_TRANSACTIONS::request rsp;
+    rsp.missed_txs = missedTxs;
+    std::vector<crypto::hash> txIds;
+    for (const Transaction& tx : txs) {
+      rsp.txs.push_back(tx_to_blob(tx));
+      txIds.push_back(get_blob_hash(rsp.txs.back()));
+    }
+
+    m_txInventory.addKnown(context.m_connection_id, txIds);
+    LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_NEW_TRANSACTIONS: txs.size()=" << rsp.txs.size() << ", missed " << missedTxs.size());
+    post_notify<NOTIFY_NEW_TRANSACTIONS>(rsp, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   int t_cryptonote_protocol_handler<t_core>::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, cryptonote_connection_context& context)
   {
     LOG_PRINT_CCONTEXT_L2("NOTIFY_REQUEST_GET_OBJECTS");
+    {
+      //a peer that does not take what was sent to it yet is not sent more blocks, its requests wait in order
+      std::lock_guard<std::mutex> lock(m_deferredGetObjectsMutex);
+      auto it = m_deferredGetObjects.find(context.m_connection_id);
+      if (context.m_send_que_size > P2P_SYNC_SERVE_QUEUE_LIMIT || it != m_deferredGetObjects.end()) {
+        LOG_PRINT_CCONTEXT_L2("Send queue size " << context.m_send_que_size << ", NOTIFY_REQUEST_GET_OBJECTS deferred");
+        m_deferredGetObjects[context.m_connection_id].push_back(std::move(arg));
+        return 1;
+      }
+    }
+
+    serve_get_objects(arg, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::serve_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, cryptonote_connection_context& context)
+  {
     NOTIFY_RESPONSE_GET_OBJECTS::request rsp;
     if(!m_core.handle_get_objects(arg, rsp, context))
     {
@@ -265,7 +543,40 @@ namespace cryptonote
     LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()=" << rsp.blocks.size() << ", txs.size()=" << rsp.txs.size() 
                             << ", rsp.m_current_blockchain_height=" << rsp.current_blockchain_height << ", missed_ids.size()=" << rsp.missed_ids.size());
     post_notify<NOTIFY_RESPONSE_GET_OBJECTS>(rsp, context);
-    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::serve_deferred_get_objects()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_deferredGetObjectsMutex);
+      if (m_deferredGetObjects.empty()) {
+        return;
+      }
+    }
+
+    std::list<cryptonote_connection_context> peers;
+    std::list<std::list<NOTIFY_REQUEST_GET_OBJECTS::request>> requests;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+      if (ctx.m_send_que_size <= P2P_SYNC_SERVE_QUEUE_LIMIT) {
+        std::lock_guard<std::mutex> lock(m_deferredGetObjectsMutex);
+        auto it = m_deferredGetObjects.find(ctx.m_connection_id);
+        if (it != m_deferredGetObjects.end()) {
+          peers.push_back(ctx);
+          requests.push_back(std::move(it->second));
+          m_deferredGetObjects.erase(it);
+        }
+      }
+      return true;
+    });
+
+    auto peerIt = peers.begin();
+    for (auto& peerRequests : requests) {
+      for (auto& request : peerRequests) {
+        serve_get_objects(request, *peerIt);
+      }
+      ++peerIt;
+    }
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core>
@@ -284,8 +595,22 @@ namespace cryptonote
 
     context.m_remote_blockchain_height = arg.current_blockchain_height;
 
+    if(context.m_requested_objects.empty())
+    {
+      LOG_ERROR_CCONTEXT("sent NOTIFY_RESPONSE_GET_OBJECTS without request, dropping connection");
+      m_p2p->drop_connection(context);
+      return 1;
+    }
+
+    //responses come in the order of the requests
+    cryptonote_connection_context::sync_request& request = context.m_requested_objects.front();
+    std::unordered_map<crypto::hash, uint64_t>& requested = request.blocks;
+    std::vector<SyncBlock> blocks;
+    blocks.reserve(arg.blocks.size());
+
     size_t count = 0;
-    for (const block_complete_entry& block_entry : arg.blocks)
+    uint64_t bytes = 0;
+    for (block_complete_entry& block_entry : arg.blocks)
     {
       ++count;
       Block b;
@@ -293,27 +618,32 @@ namespace cryptonote
       {
         LOG_ERROR_CCONTEXT("sent wrong block: failed to parse and validate block: \r\n" 
           << epee::string_tools::buff_to_hex_nodelimer(block_entry.block) << "\r\n dropping connection");
+        m_peerScores.addInvalid(context.m_remote_ip);
         m_p2p->drop_connection(context);
         return 1;
       }
+
+      crypto::hash id = get_block_hash(b);
       //to avoid concurrency in core between connections, suspend connections which delivered block later then first one
       if(count == 2)
       { 
-        if(m_core.have_block(get_block_hash(b)))
+        if(m_core.have_block(id))
         {
           context.m_state = cryptonote_connection_context::state_idle;
           context.m_needed_objects.clear();
           context.m_requested_objects.clear();
+          m_syncQueue.releaseConnection(context.m_connection_id);
           LOG_PRINT_CCONTEXT_L1("Connection set to idle state.");
           return 1;
         }
       }
 
-      auto req_it = context.m_requested_objects.find(get_block_hash(b));
-      if(req_it == context.m_requested_objects.end())
+      auto req_it = requested.find(id);
+      if(req_it == requested.end())
       {
         LOG_ERROR_CCONTEXT("sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << epee::string_tools::pod_to_hex(get_blob_hash(block_entry.block)) 
           << " wasn't requested, dropping connection");
+        m_peerScores.addInvalid(context.m_remote_ip);
         m_p2p->drop_connection(context);
         return 1;
       }
@@ -321,76 +651,210 @@ namespace cryptonote
       {
         LOG_ERROR_CCONTEXT("sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << epee::string_tools::pod_to_hex(get_blob_hash(block_entry.block)) 
           << ", txHashes.size()=" << b.txHashes.size() << " mismatch with block_complete_entry.m_txs.size()=" << block_entry.txs.size() << ", dropping connection");
+        m_peerScores.addInvalid(context.m_remote_ip);
         m_p2p->drop_connection(context);
         return 1;
       }
 
-      context.m_requested_objects.erase(req_it);
+      bytes += block_entry.block.size();
+      for (const blobdata& tx : block_entry.txs) {
+        bytes += tx.size();
+      }
+
+      blocks.push_back(SyncBlock{ req_it->second, id, std::move(block_entry), context });
+      requested.erase(req_it);
     }
 
-    if(context.m_requested_objects.size())
+    if(requested.size())
     {
-      LOG_PRINT_CCONTEXT_RED("returned not all requested objects (context.m_requested_objects.size()=" 
-        << context.m_requested_objects.size() << "), dropping connection", LOG_LEVEL_0);
+      LOG_PRINT_CCONTEXT_RED("returned not all requested objects (requested.size()=" 
+        << requested.size() << "), dropping connection", LOG_LEVEL_0);
+      m_peerScores.addInvalid(context.m_remote_ip);
       m_p2p->drop_connection(context);
       return 1;
     }
 
-    {
-      m_core.pause_mining();
-      epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler(
-        std::bind(&t_core::update_block_template_and_resume_mining, &m_core));
+    //with several requests in flight the response comes after the previous one at the earliest
+    auto now = std::chrono::steady_clock::now();
+    m_peerScores.addResponse(context.m_remote_ip, now - request.sent, now - std::max(request.sent, context.m_last_response_time), bytes);
+    context.m_last_response_time = now;
+    context.m_requested_objects.pop_front();
 
-      for (const block_complete_entry& block_entry : arg.blocks) {
-        if (m_stop) {
-          break;
-        }
+    //blocks are validated on the validation thread, keep the connection busy meanwhile
+    for (SyncBlock& block : blocks) {
+      m_syncQueue.push(std::move(block));
+    }
+
+    if (!m_stop) {
+      request_missing_objects(context, true);
+    }
+
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::validation_loop()
+  {
+    while (!m_stop) {
+      std::vector<SyncBlock> blocks;
+      if (!m_syncQueue.pop(m_core.get_current_blockchain_height(), BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, blocks, std::chrono::milliseconds(1000))) {
+        wake_waiting_connections();
+        continue;
+      }
+
+      {
+        m_core.pause_mining();
+        epee::misc_utils::auto_scope_leave_caller scope_exit_handler = epee::misc_utils::create_scope_leave_handler(
+          std::bind(&t_core::update_block_template_and_resume_mining, &m_core));
 
-        //process transactions
-        TIME_MEASURE_START(transactions_process_time);
-        for (auto& tx_blob : block_entry.txs) {
-          tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-          m_core.handle_incoming_tx(tx_blob, tvc, true);
-          if (tvc.m_verifivation_failed) {
-            LOG_ERROR_CCONTEXT("transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = " 
-              << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)) << ", dropping connection");
-            m_p2p->drop_connection(context);
-            return 1;
+        bool failed = false;
+        for (SyncBlock& block : blocks) {
+          if (m_stop) {
+            break;
           }
-        }
-        TIME_MEASURE_FINISH(transactions_process_time);
 
-        //process block
-        TIME_MEASURE_START(block_process_time);
-        block_verification_context bvc = boost::value_initialized<block_verification_context>();
-        m_core.handle_incoming_block_blob(block_entry.block, bvc, false, false);
+          if (failed) {
+            //the blocks above the failed one wait for it again, the ones of the dropped connection are discarded
+            m_syncQueue.push(std::move(block));
+          } else if (!validate_synchronized_block(block)) {
+            failed = true;
+            drop_invalid_source(block.source);
 
-        if (bvc.m_verifivation_failed) {
-          LOG_PRINT_CCONTEXT_L1("Block verification failed, dropping connection");
-          m_p2p->drop_connection(context);
-          return 1;
-        } else if (bvc.m_marked_as_orphaned) {
-          LOG_PRINT_CCONTEXT_L0("Block received at sync phase was marked as orphaned, dropping connection");
-          m_p2p->drop_connection(context);
-          return 1;
+            //a checkpoint mismatch pops the chain back to the checkpoint below it, the popped blocks were forged too
+            uint64_t height = m_core.get_current_blockchain_height();
+            if (height < block.height) {
+              auto sourceIt = m_checkpointZoneSources.upper_bound(height);
+              if (sourceIt != m_checkpointZoneSources.begin()) {
+                --sourceIt;
+              }
+
+              std::set<boost::uuids::uuid> dropped = { block.source.m_connection_id };
+              for (; sourceIt != m_checkpointZoneSources.end(); ++sourceIt) {
+                if (dropped.insert(sourceIt->second.m_connection_id).second) {
+                  LOG_PRINT_CC_L0(sourceIt->second, "Delivered blocks rolled back on checkpoint mismatch at height " << block.height << ", dropping connection");
+                  drop_invalid_source(sourceIt->second);
+                }
+              }
+
+              m_checkpointZoneSources.erase(m_checkpointZoneSources.lower_bound(height), m_checkpointZoneSources.end());
+            }
+          } else {
+            m_syncQueue.complete(block.id);
+            if (!m_core.get_blockchain_storage().isInCheckpointZone()) {
+              m_checkpointZoneSources.clear();
+            } else if (m_checkpointZoneSources.empty() ||
+              m_checkpointZoneSources.rbegin()->second.m_connection_id != block.source.m_connection_id) {
+              m_checkpointZoneSources.emplace(block.height, block.source);
+            }
+          }
         }
+      }
 
-        TIME_MEASURE_FINISH(block_process_time);
-        LOG_PRINT_CCONTEXT_L2("Block process time: " << block_process_time + transactions_process_time <<
-          " (" << transactions_process_time << " / " << block_process_time << ") ms");
+      wake_waiting_connections();
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::drop_invalid_source(const epee::net_utils::connection_context_base& source)
+  {
+    m_peerScores.addInvalid(source.m_remote_ip);
+    m_p2p->drop_connection(source);
+    m_syncQueue.releaseConnection(source.m_connection_id);
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::validate_synchronized_block(const SyncBlock& block)
+  {
+    //process transactions
+    TIME_MEASURE_START(transactions_process_time);
+    std::vector<tx_verification_context> tvcs;
+    m_core.handle_incoming_txs(block.entry.txs, tvcs, true);
+    auto tvc_it = tvcs.begin();
+    for (auto& tx_blob : block.entry.txs) {
+      const tx_verification_context& tvc = *tvc_it++;
+      if (tvc.m_verifivation_failed) {
+        LOG_ERROR_CC(block.source, "transaction verification failed on NOTIFY_RESPONSE_GET_OBJECTS, \r\ntx_id = " 
+          << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)) << ", dropping connection");
+        return false;
       }
     }
+    TIME_MEASURE_FINISH(transactions_process_time);
 
-    if (!m_stop) {
-      request_missing_objects(context, true);
+    //process block
+    TIME_MEASURE_START(block_process_time);
+    block_verification_context bvc = boost::value_initialized<block_verification_context>();
+    m_core.handle_incoming_block_blob(block.entry.block, bvc, false, false);
+
+    if (bvc.m_verifivation_failed) {
+      LOG_PRINT_CC_L1(block.source, "Block verification failed, dropping connection");
+      return false;
+    } else if (bvc.m_marked_as_orphaned) {
+      LOG_PRINT_CC_L0(block.source, "Block received at sync phase was marked as orphaned, dropping connection");
+      return false;
     }
 
-    return 1;
+    TIME_MEASURE_FINISH(block_process_time);
+    LOG_PRINT_CC_L2(block.source, "Block process time: " << block_process_time + transactions_process_time <<
+      " (" << transactions_process_time << " / " << block_process_time << ") ms");
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::wake_waiting_connections()
+  {
+    std::set<boost::uuids::uuid> waiting = m_syncQueue.takeWaiting();
+    if (waiting.empty()) {
+      return;
+    }
+
+    //the best peers are woken first, so they claim the lowest blocks
+    std::multimap<double, epee::net_utils::connection_context_base, std::greater<double>> peers;
+    m_p2p->for_each_connection([&](cryptonote_connection_context& context, nodetool::peerid_type peer_id) {
+      if (waiting.count(context.m_connection_id) != 0) {
+        ++context.m_callback_request_count;
+        peers.emplace(m_peerScores.score(context.m_remote_ip), context);
+      }
+      return true;
+    });
+
+    for (const auto& peer : peers) {
+      m_p2p->request_callback(peer.second);
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::drop_stalled_connections()
+  {
+    //the blocks downloaded from all peers wait for the next block of the chain, a peer that does not deliver it is
+    //dropped, its claims are released and the block is requested from another connection
+    std::vector<boost::uuids::uuid> stalled = m_syncQueue.getStalledConnections(m_core.get_current_blockchain_height(),
+      std::chrono::steady_clock::now(), std::chrono::seconds(P2P_SYNC_STALL_TIMEOUT));
+    if (stalled.empty() || get_synchronizing_connections_count() < 2) {
+      return;
+    }
+
+    std::list<epee::net_utils::connection_context_base> peers;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& context, nodetool::peerid_type peer_id) {
+      if (std::find(stalled.begin(), stalled.end(), context.m_connection_id) != stalled.end()) {
+        peers.push_back(context);
+      }
+      return true;
+    });
+
+    for (const auto& peer : peers) {
+      LOG_PRINT_CC_L1(peer, "Next block of the chain not delivered in " << P2P_SYNC_STALL_TIMEOUT << " seconds, dropping connection");
+      m_peerScores.addStall(peer.m_remote_ip);
+      m_syncQueue.releaseConnection(peer.m_connection_id);
+      m_p2p->drop_connection(peer);
+    }
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   bool t_cryptonote_protocol_handler<t_core>::on_idle()
   {
+    drop_stalled_connections();
+    announce_transactions();
+    serve_deferred_get_objects();
     return m_core.on_idle();
   }
   //------------------------------------------------------------------------------------------------------------------------
@@ -410,27 +874,58 @@ namespace cryptonote
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
-  bool t_cryptonote_protocol_handler<t_core>::request_missing_objects(cryptonote_connection_context& context, bool check_having_blocks)
+  void t_cryptonote_protocol_handler<t_core>::request_needed_objects(cryptonote_connection_context& context, bool check_having_blocks)
   {
-    if(context.m_needed_objects.size())
+    //request the lowest blocks no other connection requested yet, keeping several requests in flight unless the peer
+    //is much slower than the others
+    size_t max_requests = m_peerScores.isSlow(context.m_remote_ip) ? 1 : BLOCKS_SYNCHRONIZING_MAX_REQUESTS;
+    while(context.m_requested_objects.size() < max_requests && !m_syncQueue.full())
     {
-      //we know objects that we need, request this objects
       NOTIFY_REQUEST_GET_OBJECTS::request req;
-      size_t count = 0;
+      std::unordered_map<crypto::hash, uint64_t> requested;
       auto it = context.m_needed_objects.begin();
 
-      while(it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)
+      while(it != context.m_needed_objects.end() && req.blocks.size() < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT && !m_syncQueue.full())
       {
-        if( !(check_having_blocks && m_core.have_block(*it)))
+        if(check_having_blocks && m_core.have_block(it->second))
+        {
+          context.m_needed_objects.erase(it++);
+        }
+        else if(m_syncQueue.claim(it->second, it->first, context.m_connection_id, std::chrono::steady_clock::now()))
+        {
+          req.blocks.push_back(it->second);
+          requested.emplace(it->second, it->first);
+          context.m_needed_objects.erase(it++);
+        }
+        else
         {
-          req.blocks.push_back(*it);
-          ++count;
-          context.m_requested_objects.insert(*it);
+          //requested by another connection, kept in case that connection goes away
+          ++it;
         }
-        context.m_needed_objects.erase(it++);
       }
+
+      if(req.blocks.empty())
+        break;
+
+      context.m_requested_objects.push_back(cryptonote_connection_context::sync_request{ std::move(requested), std::chrono::steady_clock::now() });
       LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size());
-      post_notify<NOTIFY_REQUEST_GET_OBJECTS>(req, context);    
+      post_notify<NOTIFY_REQUEST_GET_OBJECTS>(req, context);
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core> 
+  bool t_cryptonote_protocol_handler<t_core>::request_missing_objects(cryptonote_connection_context& context, bool check_having_blocks)
+  {
+    request_needed_objects(context, check_having_blocks);
+
+    if(context.m_requested_objects.size())
+    {
+      //the next response continues
+    }else if(context.m_needed_objects.size())
+    {
+      //the queue is full or the needed objects are requested by other connections
+      context.m_waiting_for_sync_queue = true;
+      m_syncQueue.addWaiting(context.m_connection_id);
     }else if(context.m_last_response_height < context.m_remote_blockchain_height-1)
     {//we have to fetch more objects ids, request blockchain entry
      
@@ -438,6 +933,11 @@ namespace cryptonote
       m_core.get_short_chain_history(r.block_ids);
       LOG_PRINT_CCONTEXT_L2("-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size() );
       post_notify<NOTIFY_REQUEST_CHAIN>(r, context);
+    }else if(!m_syncQueue.idle())
+    {
+      //downloaded blocks are still being validated
+      context.m_waiting_for_sync_queue = true;
+      m_syncQueue.addWaiting(context.m_connection_id);
     }else
     { 
       CHECK_AND_ASSERT_MES(context.m_last_response_height == context.m_remote_blockchain_height-1 
@@ -465,11 +965,15 @@ namespace cryptonote
       LOG_PRINT_L0(ENDL << "**********************************************************************" << ENDL 
         << "You are now synchronized with the network. You may now start simplewallet." << ENDL 
         << ENDL
-        << "Please note, that the blockchain will be saved only after you quit the daemon with \"exit\" command or if you use \"save\" command." << ENDL 
-        << "Otherwise, you will possibly need to synchronize the blockchain again." << ENDL
+        << "Blocks are stored as they arrive, the blockchain cache is saved every " << BLOCKCHAIN_CACHE_STORE_INTERVAL / 60 << " minutes and when you quit the daemon with \"exit\" command." << ENDL 
+        << "After an unclean shutdown only the blocks since the last save are processed again on the next start." << ENDL
         << ENDL
         << "Use \"help\" command to see the list of available commands." << ENDL
         << "**********************************************************************");
+      ObjectHashStatistics st = get_object_hash_statistics();
+      LOG_PRINT_L1("Hashes computed/cached: transactions " << st.transactionHashes << "/" << st.transactionHashCacheHits <<
+        ", transaction prefixes " << st.prefixHashes << "/" << st.prefixHashCacheHits <<
+        ", blocks " << st.blockHashes << "/" << st.blockHashCacheHits);
       m_core.on_synchronized();
     }
     return true;
@@ -518,9 +1022,11 @@ namespace cryptonote
       m_p2p->drop_connection(context);
     }
 
+    uint64_t height = arg.start_height;
     for (auto& bl_id : arg.m_block_ids) {
       if(!m_core.have_block(bl_id))
-        context.m_needed_objects.push_back(bl_id);
+        context.m_needed_objects[height] = bl_id;
+      ++height;
     }
 
     request_missing_objects(context, false);
@@ -530,13 +1036,170 @@ namespace cryptonote
   template<class t_core> 
   void t_cryptonote_protocol_handler<t_core>::relay_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& exclude_context)
   {
-    relay_post_notify<NOTIFY_NEW_BLOCK>(arg, exclude_context);
+    std::list<epee::net_utils::connection_context_base> compactPeers;
+    std::list<epee::net_utils::connection_context_base> fullPeers;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+      if (peer_id && ctx.m_connection_id != exclude_context.m_connection_id) {
+        (ctx.m_supports_compact_blocks ? compactPeers : fullPeers).push_back(ctx);
+      }
+      return true;
+    });
+
+    if (!compactPeers.empty()) {
+      NOTIFY_NEW_COMPACT_BLOCK::request compact;
+      compact.block = arg.b.block;
+      compact.current_blockchain_height = arg.current_blockchain_height;
+      compact.hop = arg.hop;
+      post_notify_to_peers<NOTIFY_NEW_COMPACT_BLOCK>(compact, compactPeers);
+    }
+
+    if (fullPeers.empty()) {
+      return;
+    }
+
+    //a block rebuilt from the pool comes without some or all of its transactions, older peers need all of them
+    Block b;
+    if (!parse_and_validate_block_from_blob(arg.b.block, b)) {
+      LOG_ERROR("Failed to parse relayed block");
+      return;
+    }
+
+    if (arg.b.txs.size() != b.txHashes.size()) {
+      std::list<Transaction> txs;
+      std::list<crypto::hash> missedTxs;
+      m_core.get_transactions(b.txHashes, txs, missedTxs);
+      if (!missedTxs.empty()) {
+        LOG_PRINT_L1("Block " << get_block_hash(b) << " is not in the main chain any more, not relayed to " << fullPeers.size() << " peers");
+        return;
+      }
+
+      arg.b.txs.clear();
+      for (const Transaction& tx : txs) {
+        arg.b.txs.push_back(tx_to_blob(tx));
+      }
+    }
+
+    post_notify_to_peers<NOTIFY_NEW_BLOCK>(arg, fullPeers);
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
   void t_cryptonote_protocol_handler<t_core>::relay_transactions(NOTIFY_NEW_TRANSACTIONS::request& arg, cryptonote_connection_context& exclude_context)
   {
-    relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(arg, exclude_context);
+    std::vector<crypto::hash> txIds;
+    std::unordered_map<crypto::hash, const blobdata*> txBlobs;
+    for (const blobdata& txBlob : arg.txs) {
+      txIds.push_back(get_blob_hash(txBlob));
+      txBlobs.emplace(txIds.back(), &txBlob);
+    }
+
+    //peers that handle inventory get the ids with the next announcement and request the transactions they miss
+    m_txInventory.queue(txIds);
+
+    std::list<epee::net_utils::connection_context_base> fullPeers;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+      if (peer_id && !ctx.m_supports_tx_inventory && ctx.m_connection_id != exclude_context.m_connection_id) {
+        fullPeers.push_back(ctx);
+      }
+      return true;
+    });
+
+    //the transactions a peer sent or was sent already are left out
+    std::list<epee::net_utils::connection_context_base> allTxsPeers;
+    for (const auto& peer : fullPeers) {
+      std::vector<crypto::hash> unknownTxs;
+      m_txInventory.takeUnknown(peer.m_connection_id, txIds, unknownTxs);
+      if (unknownTxs.size() == txIds.size()) {
+        allTxsPeers.push_back(peer);
+      } else if (!unknownTxs.empty()) {
+        NOTIFY_NEW_TRANSACTIONS::request r;
+        for (const crypto::hash& id : unknownTxs) {
+          r.txs.push_back(*txBlobs[id]);
+        }
+
+        post_notify<NOTIFY_NEW_TRANSACTIONS>(r, peer);
+      }
+    }
+
+    if (!allTxsPeers.empty()) {
+      post_notify_to_peers<NOTIFY_NEW_TRANSACTIONS>(arg, allTxsPeers);
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::announce_transactions()
+  {
+    //runs on idle, the transactions relayed since the last call are announced in one batch
+    request_expired_transactions();
+
+    std::vector<crypto::hash> txIds = m_txInventory.takeQueued();
+    if (txIds.empty()) {
+      return;
+    }
+
+    std::list<epee::net_utils::connection_context_base> peers;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+      if (peer_id && ctx.m_supports_tx_inventory) {
+        peers.push_back(ctx);
+      }
+      return true;
+    });
+
+    for (const auto& peer : peers) {
+      std::vector<crypto::hash> unknownTxs;
+      m_txInventory.takeUnknown(peer.m_connection_id, txIds, unknownTxs);
+      for (size_t i = 0; i < unknownTxs.size(); i += P2P_TX_INVENTORY_MAX_COUNT) {
+        NOTIFY_TX_INVENTORY::request r;
+        r.txs.assign(unknownTxs.begin() + i, unknownTxs.begin() + std::min(unknownTxs.size(), i + P2P_TX_INVENTORY_MAX_COUNT));
+        post_notify<NOTIFY_TX_INVENTORY>(r, peer);
+      }
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::request_expired_transactions()
+  {
+    //transactions that did not arrive in time are requested from the next peer that announced them
+    std::map<boost::uuids::uuid, std::vector<crypto::hash>> requests;
+    m_txInventory.takeExpiredRequests(std::chrono::steady_clock::now(), requests);
+    if (requests.empty()) {
+      return;
+    }
+
+    std::list<epee::net_utils::connection_context_base> peers;
+    m_p2p->for_each_connection([&](const cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+      if (requests.count(ctx.m_connection_id) != 0) {
+        peers.push_back(ctx);
+      }
+      return true;
+    });
+
+    for (const auto& peer : peers) {
+      std::list<crypto::hash> unknownTxs;
+      m_core.get_unknown_transactions(requests[peer.m_connection_id], unknownTxs);
+      if (!unknownTxs.empty()) {
+        NOTIFY_REQUEST_TXS::request request;
+        request.txs = std::move(unknownTxs);
+        LOG_PRINT_CC_L2(peer, "-->>NOTIFY_REQUEST_TXS: txs.size()=" << request.txs.size() << ", requested again");
+        post_notify<NOTIFY_REQUEST_TXS>(request, peer);
+      }
+    }
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  epee::net_utils::send_priority t_cryptonote_protocol_handler<t_core>::get_send_priority(int command)
+  {
+    switch (command) {
+    case NOTIFY_NEW_BLOCK::ID:
+    case NOTIFY_NEW_COMPACT_BLOCK::ID:
+    case NOTIFY_REQUEST_BLOCK_TXS::ID:
+    case NOTIFY_RESPONSE_BLOCK_TXS::ID:
+      return epee::net_utils::send_priority_high;
+    case NOTIFY_RESPONSE_GET_OBJECTS::ID:
+    case NOTIFY_RESPONSE_CHAIN_ENTRY::ID:
+      return epee::net_utils::send_priority_bulk;
+    default:
+      return epee::net_utils::send_priority_normal;
+    }
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core> 
@@ -25,7 +25,10 @@ public:
     m_cmd_binder.set_handler("help", boost::bind(&daemon_cmmands_handler::help, this, _1), "Show this help");
     m_cmd_binder.set_handler("print_pl", boost::bind(&daemon_cmmands_handler::print_pl, this, _1), "Print peer list");
     m_cmd_binder.set_handler("print_cn", boost::bind(&daemon_cmmands_handler::print_cn, this, _1), "Print connections");
+    m_cmd_binder.set_handler("print_sync_peers", boost::bind(&daemon_cmmands_handler::print_sync_peers, this, _1), "Print block download statistics and scores of the peers");
     m_cmd_binder.set_handler("print_bc", boost::bind(&daemon_cmmands_handler::print_bc, this, _1), "Print blockchain info in a given blocks range, print_bc <begin_height> [<end_height>]");
+    m_cmd_binder.set_handler("print_bc_cache", boost::bind(&daemon_cmmands_handler::print_bc_cache, this, _1), "Print blockchain storage cache statistics");
+    m_cmd_binder.set_handler("print_hash_cache", boost::bind(&daemon_cmmands_handler::print_hash_cache, this, _1), "Print transaction and block hash cache statistics");
     //m_cmd_binder.set_handler("print_bci", boost::bind(&daemon_cmmands_handler::print_bci, this, _1));
     //m_cmd_binder.set_handler("print_bc_outs", boost::bind(&daemon_cmmands_handler::print_bc_outs, this, _1));
     m_cmd_binder.set_handler("print_block", boost::bind(&daemon_cmmands_handler::print_block, this, _1), "Print block, print_block <block_hash> | <block_height>");
@@ -113,6 +116,12 @@ private:
      return true;
   }
   //--------------------------------------------------------------------------------
+  bool print_sync_peers(const std::vector<std::string>& args)
+  {
+    m_srv.get_payload_object().log_sync_peers();
+    return true;
+  }
+  //--------------------------------------------------------------------------------
   bool print_bc(const std::vector<std::string>& args)
   {
     if(!args.size())
@@ -152,6 +161,29 @@ private:
     return true;
   }
   //--------------------------------------------------------------------------------
+  bool print_bc_cache(const std::vector<std::string>& args)
+  {
+    MappedVectorCacheStatistics st = m_srv.get_payload_object().get_core().get_blockchain_storage().getBlockCacheStatistics();
+    uint64_t requests = st.hits + st.misses;
+    std::cout << "Block cache: " << st.items << " blocks, " << st.size << " of " << st.capacity << " bytes" << ENDL
+      << "hits: " << st.hits << ", misses: " << st.misses << ", hit ratio: " << (requests ? st.hits * 100 / requests : 0) << "%" << ENDL;
+
+    cryptonote::RingSignatureCacheStatistics sst = m_srv.get_payload_object().get_core().get_blockchain_storage().getSignatureCacheStatistics();
+    requests = sst.hits + sst.misses;
+    std::cout << "Ring signature cache: " << sst.items << " of " << sst.capacity << " signatures" << ENDL
+      << "hits: " << sst.hits << ", misses: " << sst.misses << ", hit ratio: " << (requests ? sst.hits * 100 / requests : 0) << "%" << ENDL;
+    return true;
+  }
+  //--------------------------------------------------------------------------------
+  bool print_hash_cache(const std::vector<std::string>& args)
+  {
+    cryptonote::ObjectHashStatistics st = cryptonote::get_object_hash_statistics();
+    std::cout << "Transaction hashes computed: " << st.transactionHashes << ", cached: " << st.transactionHashCacheHits << ENDL
+      << "Transaction prefix hashes computed: " << st.prefixHashes << ", cached: " << st.prefixHashCacheHits << ENDL
+      << "Block hashes computed: " << st.blockHashes << ", cached: " << st.blockHashCacheHits << ENDL;
+    return true;
+  }
+  //--------------------------------------------------------------------------------
   bool print_bci(const std::vector<std::string>& args)
   {
     m_srv.get_payload_object().get_core().print_blockchain_index();
@@ -430,7 +430,7 @@ std::error_code InProcessNode::doQueryBlocks(std::list<crypto::hash>&& knownBloc
   uint64_t currentHeight, fullOffset;
   std::list<cryptonote::BlockFullInfo> entries;
 
-  if (!core.queryBlocks(knownBlockIds, timestamp, startHeight, currentHeight, fullOffset, entries)) {
+  if (!core.queryBlocks(knownBlockIds, timestamp, true, startHeight, currentHeight, fullOffset, entries)) {
     return make_error_code(cryptonote::error::INTERNAL_NODE_ERROR);
   }
 
@@ -439,6 +439,7 @@ std::error_code InProcessNode::doQueryBlocks(std::list<crypto::hash>&& knownBloc
     bce.blockHash = entry.block_id;
     bce.block = entry.block;
     std::copy(entry.txs.begin(), entry.txs.end(), std::back_inserter(bce.txs));
+    bce.globalOutputIndexes = entry.global_output_indexes;
 
     newBlocks.push_back(std::move(bce));
   }
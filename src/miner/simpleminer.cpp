@@ -101,7 +101,8 @@ namespace mining
     std::string pool_session_id;
     simpleminer::job_details_native job = AUTO_VAL_INIT(job);
     uint64_t last_job_ticks = 0;
-    crypto::cn_context context;
+    crypto::pooled_cn_context context[2];
+    crypto::cn_context* contexts[2] = { &context[0].get(), &context[1].get() };
 
     while(true)
     {
@@ -157,9 +158,23 @@ namespace mining
       while(epee::misc_utils::get_tick_count() - last_job_ticks < 20000)
       {
         //uint32_t c = (*((uint32_t*)&job.blob.data()[39]));
+        //hash two consecutive nonces at once, job.blob ends up holding the winning or the last one
         ++(*((uint32_t*)&job.blob.data()[39]));
-        crypto::hash h = cryptonote::null_hash;
-        crypto::cn_slow_hash(context, job.blob.data(), job.blob.size(), h);
+        std::string next_blob = job.blob;
+        ++(*((uint32_t*)&next_blob[39]));
+        const void* blobs[2] = { job.blob.data(), next_blob.data() };
+        crypto::hash hashes[2];
+        crypto::cn_slow_hash_2(contexts, blobs, job.blob.size(), hashes);
+        crypto::hash h = hashes[1];
+        if( ((uint32_t*)&hashes[0])[7] < job.target )
+        {
+          h = hashes[0];
+        }
+        else
+        {
+          job.blob.swap(next_blob);
+        }
+
         if(  ((uint32_t*)&h)[7] < job.target )
         {
           //found!
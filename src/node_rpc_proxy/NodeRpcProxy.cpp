@@ -274,6 +274,7 @@ void NodeRpcProxy::doQueryBlocks(const std::list<crypto::hash>& knownBlockIds, u
   
   req.block_ids = knownBlockIds;
   req.timestamp = timestamp;
+  req.global_output_indexes = true;
 
   bool r = epee::net_utils::invoke_http_bin_remote_command2(m_nodeAddress + "/queryblocks.bin", req, rsp, m_httpClient, m_rpcTimeout);
 
@@ -286,6 +287,7 @@ void NodeRpcProxy::doQueryBlocks(const std::list<crypto::hash>& knownBlockIds, u
       entry.blockHash = item.block_id;
       entry.block = std::move(item.block);
       entry.txs = std::move(item.txs);
+      entry.globalOutputIndexes = std::move(item.global_output_indexes);
 
       newBlocks.push_back(std::move(entry));
     }
@@ -118,9 +118,9 @@ namespace nodetool
     virtual void on_connection_close(p2p_connection_context& context) override;
     virtual void callback(p2p_connection_context& context) override;
     //----------------- i_p2p_endpoint -------------------------------------------------------------
-    virtual void relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context) override;
+    virtual void relay_notify_to_all(int command, const boost::shared_ptr<const std::string>& data_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority) override;
     virtual bool invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context) override;
-    virtual bool invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context) override;
+    virtual bool invoke_notify_to_peer(int command, const boost::shared_ptr<const std::string>& req_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority) override;
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context) override;
     virtual void request_callback(const epee::net_utils::connection_context_base& context) override;
     virtual void for_each_connection(std::function<bool(typename t_payload_net_handler::connection_context&, peerid_type)> f) override;
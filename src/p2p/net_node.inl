@@ -816,7 +816,7 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
-  void node_server<t_payload_net_handler>::relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context)
+  void node_server<t_payload_net_handler>::relay_notify_to_all(int command, const boost::shared_ptr<const std::string>& data_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)
   {
     std::list<boost::uuids::uuid> connections;
     m_net_server.get_config_object().foreach_connection([&](const p2p_connection_context& cntxt)
@@ -828,7 +828,7 @@ namespace nodetool
 
     BOOST_FOREACH(const auto& c_id, connections)
     {
-      m_net_server.get_config_object().notify(command, data_buff, c_id);
+      m_net_server.get_config_object().notify(command, data_buff, c_id, priority);
     }
   }
   //-----------------------------------------------------------------------------------
@@ -839,9 +839,9 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
-  bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context)
+  bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, const boost::shared_ptr<const std::string>& req_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)
   {
-    int res = m_net_server.get_config_object().notify(command, req_buff, context.m_connection_id);
+    int res = m_net_server.get_config_object().notify(command, req_buff, context.m_connection_id, priority);
     return res > 0;
   }
   //-----------------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <boost/uuid/uuid.hpp>
 #include "net/net_utils_base.h"
 
@@ -18,9 +19,9 @@ namespace nodetool
   template<class t_connection_context>
   struct i_p2p_endpoint
   {
-    virtual void relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context)=0;
+    virtual void relay_notify_to_all(int command, const boost::shared_ptr<const std::string>& data_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)=0;
     virtual bool invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context)=0;
-    virtual bool invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context)=0;
+    virtual bool invoke_notify_to_peer(int command, const boost::shared_ptr<const std::string>& req_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)=0;
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context)=0;
     virtual void request_callback(const epee::net_utils::connection_context_base& context)=0;
     virtual uint64_t get_connections_count()=0;
@@ -30,14 +31,14 @@ namespace nodetool
   template<class t_connection_context>
   struct p2p_endpoint_stub: public i_p2p_endpoint<t_connection_context>
   {
-    virtual void relay_notify_to_all(int command, const std::string& data_buff, const epee::net_utils::connection_context_base& context)
+    virtual void relay_notify_to_all(int command, const boost::shared_ptr<const std::string>& data_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)
     {
     }
     virtual bool invoke_command_to_peer(int command, const std::string& req_buff, std::string& resp_buff, const epee::net_utils::connection_context_base& context)
     {
       return false;
     }
-    virtual bool invoke_notify_to_peer(int command, const std::string& req_buff, const epee::net_utils::connection_context_base& context)
+    virtual bool invoke_notify_to_peer(int command, const boost::shared_ptr<const std::string>& req_buff, const epee::net_utils::connection_context_base& context, epee::net_utils::send_priority priority)
     {
       return true;
     }
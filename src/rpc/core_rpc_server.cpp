@@ -93,21 +93,12 @@ namespace cryptonote
   bool core_rpc_server::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res, connection_context& cntx)
   {
     CHECK_CORE_READY();
-    std::list<std::pair<Block, std::list<Transaction> > > bs;
-    if(!m_core.find_blockchain_supplement(req.block_ids, bs, res.current_height, res.start_height, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT))
+    if(!m_core.find_blockchain_supplement(req.block_ids, res.blocks, res.current_height, res.start_height, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT))
     {
       res.status = "Failed";
       return false;
     }
 
-    for (auto& b : bs) {
-      res.blocks.resize(res.blocks.size()+1);
-      res.blocks.back().block = block_to_blob(b.first);
-      for (auto& t : b.second) {
-        res.blocks.back().txs.push_back(tx_to_blob(t));
-      }
-    }
-
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
@@ -117,7 +108,7 @@ namespace cryptonote
   {
     CHECK_CORE_READY();
 
-    if (!m_core.queryBlocks(req.block_ids, req.timestamp, res.start_height, res.current_height, res.full_offset, res.items)) {
+    if (!m_core.queryBlocks(req.block_ids, req.timestamp, req.global_output_indexes, res.start_height, res.current_height, res.full_offset, res.items)) {
       res.status = "Failed to perform query";
       return false;
     }
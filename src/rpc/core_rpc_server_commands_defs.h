@@ -479,10 +479,15 @@ namespace cryptonote
     {
       std::list<crypto::hash> block_ids; //*first 10 blocks id goes sequential, next goes in pow(2,n) offset, like 2, 4, 8, 16, 32, 64 and so on, and the last one is always genesis block */
       uint64_t timestamp;
+      bool global_output_indexes; // fill BlockFullInfo::global_output_indexes, ignored by older daemons
+
+      // older clients leave out global_output_indexes, the serializer keeps the defaults of missing fields
+      request() : timestamp(0), global_output_indexes(false) {}
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE_CONTAINER_POD_AS_BLOB(block_ids)
         KV_SERIALIZE(timestamp)
+        KV_SERIALIZE(global_output_indexes)
       END_KV_SERIALIZE_MAP()
     };
 
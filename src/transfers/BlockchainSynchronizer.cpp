@@ -20,6 +20,26 @@ inline std::vector<uint8_t> stringToVector(const std::string& s) {
   return vec;
 }
 
+// Splits the indexes sent along with a block by the output counts of its transactions. Leaves result empty if they
+// do not add up, the consumers then request the indexes of each transaction they need.
+void splitGlobalOutputIndexes(const std::vector<uint64_t>& indexes, const CryptoNote::CompleteBlock& block, std::vector<std::vector<uint64_t>>& result) {
+  size_t outputCount = 0;
+  for (const auto& tx : block.transactions) {
+    outputCount += tx->getOutputCount();
+  }
+
+  if (indexes.empty() || indexes.size() != outputCount) {
+    return;
+  }
+
+  auto position = indexes.begin();
+  result.reserve(block.transactions.size());
+  for (const auto& tx : block.transactions) {
+    result.emplace_back(position, position + tx->getOutputCount());
+    position += tx->getOutputCount();
+  }
+}
+
 }
 
 namespace CryptoNote {
@@ -356,6 +376,8 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
           std::make_error_code(std::errc::invalid_argument));
         return;
       }
+
+      splitGlobalOutputIndexes(block.globalOutputIndexes, completeBlock, completeBlock.globalOutputIndexes);
     }
 
     blocks.push_back(std::move(completeBlock));
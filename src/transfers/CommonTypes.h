@@ -26,6 +26,8 @@ struct CompleteBlock {
   boost::optional<cryptonote::Block> block;
   // first transaction is always coinbase
   std::list<std::shared_ptr<ITransactionReader>> transactions;
+  // global output indexes of each of the transactions, empty if the node did not send them
+  std::vector<std::vector<uint64_t>> globalOutputIndexes;
 };
 
 }
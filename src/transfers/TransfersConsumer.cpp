@@ -154,6 +154,7 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint64_t startH
   struct Tx {
     BlockInfo blockInfo;
     const ITransactionReader* tx;
+    const std::vector<uint64_t>* globalIdxs;
   };
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
@@ -188,13 +189,18 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint64_t startH
       blockInfo.timestamp = block->timestamp;
       blockInfo.transactionIndex = 0; // position in block
 
+      const auto& globalIdxs = blocks[i].globalOutputIndexes;
+      size_t txIndex = 0;
       for (const auto& tx : blocks[i].transactions) {
+        const std::vector<uint64_t>* txGlobalIdxs = globalIdxs.empty() ? nullptr : &globalIdxs[txIndex];
+        ++txIndex;
+
         auto pubKey = tx->getTransactionPublicKey();
         if (*reinterpret_cast<crypto::public_key*>(&pubKey) == cryptonote::null_pkey) {
           continue;
         }
 
-        Tx item = { blockInfo, tx.get() };
+        Tx item = { blockInfo, tx.get(), txGlobalIdxs };
         inputQueue.push(item);
         ++blockInfo.transactionIndex;
       }
@@ -210,7 +216,7 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint64_t startH
       PreprocessedTx output;
       static_cast<Tx&>(output) = item;
 
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
+      ec = preprocessOutputs(item.blockInfo, *item.tx, item.globalIdxs, output);
       if (ec) {
         stopProcessing = true;
         break;
@@ -311,13 +317,16 @@ void TransfersConsumer::getKnownPoolTxIds(std::vector<crypto::hash>& ids) {
   ids.assign(knownIds.begin(), knownIds.end());
 }
 
-std::error_code TransfersConsumer::preprocessOutputs(const BlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
+std::error_code TransfersConsumer::preprocessOutputs(const BlockInfo& blockInfo, const ITransactionReader& tx,
+  const std::vector<uint64_t>* globalIdxs, PreprocessInfo& info) {
   findMyOutputs(tx, m_viewSecret, m_spendKeys, info.outputs);
 
   std::error_code errorCode;
   if (!info.outputs.empty()) {
-    auto txHash = tx.getTransactionHash();
-    if (blockInfo.height != UNCONFIRMED_TRANSACTION_HEIGHT) {
+    if (globalIdxs != nullptr) {
+      info.globalIdxs = *globalIdxs;
+    } else if (blockInfo.height != UNCONFIRMED_TRANSACTION_HEIGHT) {
+      auto txHash = tx.getTransactionHash();
       errorCode = getGlobalIndices(reinterpret_cast<const crypto::hash&>(txHash), info.globalIdxs);
       if (errorCode) {
         return errorCode;
@@ -330,7 +339,7 @@ std::error_code TransfersConsumer::preprocessOutputs(const BlockInfo& blockInfo,
 
 std::error_code TransfersConsumer::processTransaction(const BlockInfo& blockInfo, const ITransactionReader& tx) {
   PreprocessInfo info;
-  auto ec = preprocessOutputs(blockInfo, tx, info);
+  auto ec = preprocessOutputs(blockInfo, tx, nullptr, info);
   if (ec) {
     return ec;
   }
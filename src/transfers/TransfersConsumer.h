@@ -53,7 +53,9 @@ private:
     std::vector<uint64_t> globalIdxs;
   };
 
-  std::error_code preprocessOutputs(const BlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info);
+  // globalIdxs are the indexes of the transaction outputs if they came with the block, nullptr to request them
+  std::error_code preprocessOutputs(const BlockInfo& blockInfo, const ITransactionReader& tx, const std::vector<uint64_t>* globalIdxs,
+    PreprocessInfo& info);
   std::error_code processTransaction(const BlockInfo& blockInfo, const ITransactionReader& tx);
   std::error_code processTransaction(const BlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info);
   std::error_code processOutputs(const BlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
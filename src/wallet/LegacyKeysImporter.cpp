@@ -49,8 +49,7 @@ void loadKeysFromFile(const std::string& filename, const std::string& password,
   THROW_WALLET_EXCEPTION_IF(!r, tools::error::wallet_internal_error, "internal error: failed to deserialize \"" + filename + '\"');
 
   crypto::chacha_key key;
-  crypto::cn_context cn_context;
-  crypto::generate_chacha8_key(cn_context, password, key);
+  crypto::generate_chacha8_key(password, key);
   std::string account_data;
   account_data.resize(keys_file_data.account_data.size());
   crypto::chacha8(keys_file_data.account_data.data(), keys_file_data.account_data.size(), key, keys_file_data.iv, &account_data[0]);
@@ -261,8 +261,7 @@ void Wallet::doLoad(std::istream& source) {
 
 void Wallet::decrypt(const std::string& cipher, std::string& plain, crypto::chacha_iv iv, const std::string& password) {
   crypto::chacha_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, password, key);
+  crypto::generate_chacha8_key(password, key);
 
   plain.resize(cipher.size());
 
@@ -381,8 +380,7 @@ void Wallet::doSave(std::ostream& destination, bool saveDetailed, bool saveCache
 
 crypto::chacha_iv Wallet::encrypt(const std::string& plain, std::string& cipher) {
   crypto::chacha_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, m_password, key);
+  crypto::generate_chacha8_key(m_password, key);
 
   cipher.resize(plain.size());
 
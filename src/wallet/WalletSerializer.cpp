@@ -81,8 +81,7 @@ void WalletSerializer::saveKeys(cryptonote::ISerializer& serializer) {
 
 crypto::chacha_iv WalletSerializer::encrypt(const std::string& plain, const std::string& password, std::string& cipher) {
   crypto::chacha_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, password, key);
+  crypto::generate_chacha8_key(password, key);
 
   cipher.resize(plain.size());
 
@@ -139,8 +138,7 @@ void WalletSerializer::deserialize(std::istream& stream, const std::string& pass
 
 void WalletSerializer::decrypt(const std::string& cipher, std::string& plain, crypto::chacha_iv iv, const std::string& password) {
   crypto::chacha_key key;
-  crypto::cn_context context;
-  crypto::generate_chacha8_key(context, password, key);
+  crypto::generate_chacha8_key(password, key);
 
   plain.resize(cipher.size());
 
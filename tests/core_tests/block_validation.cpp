@@ -566,6 +566,37 @@ bool TestBlockCumulativeSizeExceedsLimit::generate(std::vector<test_event_entry>
   return false;
 }
 
+bool TestCheckpointMismatchRollsBack::generate(std::vector<test_event_entry>& events) const {
+  BLOCK_VALIDATION_INIT_GENERATE();
+  generator.defaultMajorVersion = m_blockMajorVersion;
+
+  DO_CALLBACK(events, "setCheckpoints");
+  // blocks 1..6 are events 2..7, block 6 doesn't match its checkpoint
+  REWIND_BLOCKS_N(events, blk_6, blk_0, miner_account, 6);
+  DO_CALLBACK(events, "checkRolledBack");
+
+  return true;
+}
+
+bool TestCheckpointMismatchRollsBack::setCheckpoints(cryptonote::core& c, size_t eventIdx, const std::vector<test_event_entry>& events) {
+  cryptonote::checkpoints checkpoints;
+  checkpoints.add_checkpoint(3, epee::string_tools::pod_to_hex(get_block_hash(boost::get<Block>(events[eventIdx + 3]))));
+  checkpoints.add_checkpoint(6, epee::string_tools::pod_to_hex(null_hash));
+  c.set_checkpoints(std::move(checkpoints));
+  return true;
+}
+
+bool TestCheckpointMismatchRollsBack::checkRolledBack(cryptonote::core& c, size_t eventIdx, const std::vector<test_event_entry>& events) {
+  DEFINE_TESTS_ERROR_CONTEXT("TestCheckpointMismatchRollsBack::checkRolledBack");
+
+  // blocks 4 and 5 were only vouched for by the mismatching checkpoint
+  CHECK_EQ(4, c.get_current_blockchain_height());
+  CHECK_TEST_CONDITION(c.get_tail_id() == get_block_hash(boost::get<Block>(events[4])));
+  CHECK_EQ(0, c.get_pool_transactions_count());
+
+  return true;
+}
+
 gen_block_invalid_binary_format::gen_block_invalid_binary_format(uint8_t blockMajorVersion) : 
     m_corrupt_blocks_begin_idx(0),
     m_blockMajorVersion(blockMajorVersion) {
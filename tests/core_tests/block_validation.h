@@ -303,6 +303,18 @@ struct TestBlockCumulativeSizeExceedsLimit : public CheckBlockPurged {
   bool generate(std::vector<test_event_entry>& events) const;
 };
 
+struct TestCheckpointMismatchRollsBack : public CheckBlockPurged {
+  TestCheckpointMismatchRollsBack(uint8_t blockMajorVersion)
+    : CheckBlockPurged(7, blockMajorVersion) {
+    REGISTER_CALLBACK("setCheckpoints", TestCheckpointMismatchRollsBack::setCheckpoints);
+    REGISTER_CALLBACK("checkRolledBack", TestCheckpointMismatchRollsBack::checkRolledBack);
+  }
+
+  bool generate(std::vector<test_event_entry>& events) const;
+  bool setCheckpoints(cryptonote::core& c, size_t eventIdx, const std::vector<test_event_entry>& events);
+  bool checkRolledBack(cryptonote::core& c, size_t eventIdx, const std::vector<test_event_entry>& events);
+};
+
 struct gen_block_invalid_binary_format : public test_chain_unit_base
 {
   gen_block_invalid_binary_format(uint8_t blockMajorVersion);
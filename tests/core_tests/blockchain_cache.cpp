@@ -0,0 +1,195 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockchain_cache.h"
+
+#include <boost/filesystem.hpp>
+
+#include "TestGenerator.h"
+#include "cryptonote_protocol/cryptonote_protocol_handler_common.h"
+
+using namespace cryptonote;
+
+#define CHECK(cond) if((cond) == false) { LOG_ERROR("Condition "#cond" failed"); return false; }
+
+namespace {
+
+std::vector<std::string> cacheFileNames(const Currency& currency) {
+  return { currency.blocksCacheFileName(), currency.txIndexFileName(), currency.blockHeadersFileName(),
+    currency.keyImagesFileName() };
+}
+
+bool copyFiles(const Currency& currency, const boost::filesystem::path& from, const boost::filesystem::path& to) {
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(to, ec);
+  for (const std::string& fileName : cacheFileNames(currency)) {
+    boost::filesystem::remove(to / fileName, ec);
+    boost::filesystem::copy_file(from / fileName, to / fileName, ec);
+    if (ec) {
+      LOG_ERROR("Failed to copy " << (from / fileName).string() << ": " << ec.message());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool pushBlocks(core& source, core& target, uint64_t startHeight, uint64_t endHeight) {
+  for (uint64_t height = startHeight; height < endHeight; ++height) {
+    std::list<Block> blocks;
+    std::list<Transaction> txs;
+    CHECK(source.get_blocks(height, 1, blocks, txs));
+    CHECK(blocks.size() == 1);
+
+    for (const Transaction& tx : txs) {
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      CHECK(target.handle_incoming_tx(tx_to_blob(tx), tvc, true));
+      CHECK(!tvc.m_verifivation_failed);
+    }
+
+    block_verification_context bvc = boost::value_initialized<block_verification_context>();
+    CHECK(target.handle_incoming_block_blob(block_to_blob(blocks.front()), bvc, false, false));
+    CHECK(bvc.m_added_to_main_chain);
+  }
+
+  return true;
+}
+
+bool compareIndexes(core& expected, core& actual) {
+  uint64_t height = expected.get_current_blockchain_height();
+  CHECK(actual.get_current_blockchain_height() == height);
+
+  blockchain_storage& expectedStorage = expected.get_blockchain_storage();
+  blockchain_storage& actualStorage = actual.get_blockchain_storage();
+  CHECK(actualStorage.get_total_transactions() == expectedStorage.get_total_transactions());
+  CHECK(actualStorage.get_difficulty_for_next_block() == expectedStorage.get_difficulty_for_next_block());
+
+  std::vector<size_t> expectedSizes;
+  std::vector<size_t> actualSizes;
+  CHECK(expectedStorage.get_backward_blocks_sizes(height - 1, expectedSizes, height));
+  CHECK(actualStorage.get_backward_blocks_sizes(height - 1, actualSizes, height));
+  CHECK(actualSizes == expectedSizes);
+
+  for (uint64_t b = 0; b < height; ++b) {
+    CHECK(actualStorage.get_block_id_by_height(b) == expectedStorage.get_block_id_by_height(b));
+    CHECK(actualStorage.block_difficulty(b) == expectedStorage.block_difficulty(b));
+
+    uint64_t expectedTimestamp;
+    uint64_t actualTimestamp;
+    CHECK(expectedStorage.getBlockTimestamp(b, expectedTimestamp));
+    CHECK(actualStorage.getBlockTimestamp(b, actualTimestamp));
+    CHECK(actualTimestamp == expectedTimestamp);
+
+    std::list<Block> blocks;
+    std::list<Transaction> txs;
+    CHECK(expected.get_blocks(b, 1, blocks, txs));
+    txs.push_front(blocks.front().minerTx);
+    for (const Transaction& tx : txs) {
+      std::vector<uint64_t> expectedIndexes;
+      std::vector<uint64_t> actualIndexes;
+      CHECK(expected.get_tx_outputs_gindexs(get_transaction_hash(tx), expectedIndexes));
+      CHECK(actual.get_tx_outputs_gindexs(get_transaction_hash(tx), actualIndexes));
+      CHECK(actualIndexes == expectedIndexes);
+      CHECK(actualStorage.have_tx_keyimges_as_spent(tx) == expectedStorage.have_tx_keyimges_as_spent(tx));
+    }
+  }
+
+  return check_key_outputs(actual);
+}
+
+}
+
+BlockchainCacheTailReplay::BlockchainCacheTailReplay() {
+  REGISTER_CALLBACK_METHOD(BlockchainCacheTailReplay, checkTailReplay);
+}
+
+bool BlockchainCacheTailReplay::generate(std::vector<test_event_entry>& events) const {
+  test_generator chainGenerator(m_currency);
+  std::vector<size_t> blockSizes;
+  chainGenerator.addBlock(m_currency.genesisBlock(), 0, 0, blockSizes, 0);
+  events.push_back(m_currency.genesisBlock());
+
+  cryptonote::account_base minerAccount;
+  TestGenerator generator(chainGenerator, minerAccount, m_currency.genesisBlock(), m_currency, events);
+  generator.generateBlocks();
+
+  // spend below and above the height of the stored cache
+  for (size_t i = 0; i < 2 * m_currency.minedMoneyUnlockWindow(); ++i) {
+    auto builder = generator.createTxBuilder(
+      generator.minerAccount, generator.minerAccount, MK_COINS(1), m_currency.minimumFee());
+
+    auto tx = builder.build();
+    generator.addEvent(tx);
+    generator.makeNextBlock(tx);
+  }
+
+  generator.generateBlocks();
+  generator.addCallback("checkTailReplay");
+
+  return true;
+}
+
+bool BlockchainCacheTailReplay::checkTailReplay(core& c, size_t ev_index, const std::vector<test_event_entry>& events) {
+  boost::filesystem::path folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  bool result = replayTail(c, folder.string());
+
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(folder, ec);
+  return result;
+}
+
+bool BlockchainCacheTailReplay::replayTail(core& c, const std::string& folder) {
+  uint64_t height = c.get_current_blockchain_height();
+  uint64_t cachedHeight = height / 2;
+
+  boost::filesystem::path chainFolder = boost::filesystem::path(folder) / "chain";
+  boost::filesystem::path cacheFolder = boost::filesystem::path(folder) / "cache";
+
+  CoreConfig config;
+  config.configFolder = chainFolder.string();
+  MinerConfig minerConfig;
+  cryptonote_protocol_stub protocol;
+
+  {
+    core replica(m_currency, &protocol);
+    CHECK(replica.init(config, minerConfig, false));
+    CHECK(pushBlocks(c, replica, 1, cachedHeight));
+    CHECK(replica.deinit());
+  }
+
+  // keep the cache stored at cachedHeight, then store the rest of the chain without it
+  CHECK(copyFiles(m_currency, chainFolder, cacheFolder));
+
+  {
+    core replica(m_currency, &protocol);
+    CHECK(replica.init(config, minerConfig, true));
+    CHECK(pushBlocks(c, replica, cachedHeight, height));
+    CHECK(replica.deinit());
+  }
+
+  CHECK(copyFiles(m_currency, cacheFolder, chainFolder));
+
+  // the blocks above the cache are replayed on top of it
+  {
+    core replica(m_currency, &protocol);
+    CHECK(replica.init(config, minerConfig, true));
+    CHECK(compareIndexes(c, replica));
+    CHECK(replica.deinit());
+  }
+
+  for (const std::string& fileName : cacheFileNames(m_currency)) {
+    boost::filesystem::remove(chainFolder / fileName);
+  }
+
+  // without a cache the whole chain is replayed
+  {
+    core replica(m_currency, &protocol);
+    CHECK(replica.init(config, minerConfig, true));
+    CHECK(compareIndexes(c, replica));
+    CHECK(replica.deinit());
+  }
+
+  return true;
+}
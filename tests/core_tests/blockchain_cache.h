@@ -0,0 +1,22 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once 
+
+#include "chaingen.h"
+
+// Builds a chain on the genesis block of the currency, so that cores reloading it from their folders accept it
+struct BlockchainCacheTailReplay : public test_chain_unit_base
+{
+  BlockchainCacheTailReplay();
+
+  bool generate(std::vector<test_event_entry>& events) const;
+
+private:
+
+  bool checkTailReplay(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+  bool replayTail(cryptonote::core& c, const std::string& folder);
+
+};
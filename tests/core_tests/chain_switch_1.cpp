@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chain_switch_1.h"
+#include "TestGenerator.h"
 
 using namespace epee;
 using namespace cryptonote;
@@ -180,3 +181,120 @@ bool gen_chain_switch_1::check_split_switched(cryptonote::core& c, size_t ev_ind
 
   return true;
 }
+
+//-----------------------------------------------------------------------------------------------------
+ChainSwitchFailureRestoresMainChain::ChainSwitchFailureRestoresMainChain()
+  : m_switchBlockIdx(0)
+  , m_height(0)
+{
+  REGISTER_CALLBACK_METHOD(ChainSwitchFailureRestoresMainChain, rememberMainChain);
+  REGISTER_CALLBACK_METHOD(ChainSwitchFailureRestoresMainChain, markSwitchBlock);
+  REGISTER_CALLBACK_METHOD(ChainSwitchFailureRestoresMainChain, checkMainChainRestored);
+}
+
+bool ChainSwitchFailureRestoresMainChain::generate(std::vector<test_event_entry>& events) const
+{
+  TestGenerator generator(m_currency, events);
+  generator.generateBlocks();
+  Block forkBlock = generator.lastBlock;
+
+  // main chain, every block has a transaction
+  size_t mainBlockCount = m_currency.minedMoneyUnlockWindow();
+  for (size_t i = 0; i < mainBlockCount; ++i) {
+    auto builder = generator.createTxBuilder(generator.minerAccount, generator.minerAccount, MK_COINS(1), m_currency.minimumFee());
+    auto tx = builder.build();
+    generator.addEvent(tx);
+    generator.makeNextBlock(tx);
+  }
+
+  generator.addCallback("rememberMainChain");
+
+  // alternative chain, its third block claims twice the reward
+  TestGenerator alternative(generator.generator, generator.minerAccount, forkBlock, m_currency, events);
+  alternative.generateBlocks(2);
+
+  Transaction minerTx;
+  if (!constructMinerTxManually(m_currency, get_block_height(alternative.lastBlock) + 1,
+    alternative.generator.getAlreadyGeneratedCoins(alternative.lastBlock),
+    alternative.minerAccount.get_keys().m_account_address, minerTx, 0)) {
+    return false;
+  }
+
+  minerTx.vout[0].amount *= 2;
+  Block invalidBlock;
+  alternative.generator.constructBlockManually(invalidBlock, alternative.lastBlock, alternative.minerAccount,
+    test_generator::bf_major_ver | test_generator::bf_miner_tx, BLOCK_MAJOR_VERSION_1, 0, 0, crypto::hash(), 0, minerTx);
+  events.push_back(invalidBlock);
+  alternative.lastBlock = invalidBlock;
+
+  // the block that makes the alternative chain longer starts the switch
+  alternative.generateBlocks(mainBlockCount - 3);
+  alternative.addCallback("markSwitchBlock");
+  alternative.generateBlocks(1);
+
+  generator.addCallback("checkMainChainRestored");
+  return true;
+}
+
+bool ChainSwitchFailureRestoresMainChain::check_block_verification_context(const cryptonote::block_verification_context& bvc, size_t event_idx, const cryptonote::Block& /*blk*/)
+{
+  if (m_switchBlockIdx == event_idx) {
+    return bvc.m_verifivation_failed;
+  } else {
+    return !bvc.m_verifivation_failed;
+  }
+}
+
+bool ChainSwitchFailureRestoresMainChain::rememberMainChain(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events)
+{
+  DEFINE_TESTS_ERROR_CONTEXT("ChainSwitchFailureRestoresMainChain::rememberMainChain");
+
+  m_height = c.get_current_blockchain_height();
+  m_tailId = c.get_tail_id();
+
+  std::list<Block> blocks;
+  std::list<Transaction> txs;
+  CHECK_TEST_CONDITION(c.get_blocks(0, static_cast<size_t>(m_height), blocks, txs));
+  for (const Block& blk : blocks) {
+    txs.push_back(blk.minerTx);
+  }
+
+  for (const Transaction& tx : txs) {
+    CHECK_TEST_CONDITION(c.get_tx_outputs_gindexs(get_transaction_hash(tx), m_outputIndexes[get_transaction_hash(tx)]));
+  }
+
+  CHECK_EQ(0, c.get_pool_transactions_count());
+  return check_key_outputs(c);
+}
+
+bool ChainSwitchFailureRestoresMainChain::markSwitchBlock(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events)
+{
+  m_switchBlockIdx = ev_index + 1;
+  return true;
+}
+
+bool ChainSwitchFailureRestoresMainChain::checkMainChainRestored(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events)
+{
+  DEFINE_TESTS_ERROR_CONTEXT("ChainSwitchFailureRestoresMainChain::checkMainChainRestored");
+
+  CHECK_EQ(m_height, c.get_current_blockchain_height());
+  CHECK_TEST_CONDITION(m_tailId == c.get_tail_id());
+  CHECK_EQ(0, c.get_pool_transactions_count());
+
+  for (const auto& outputIndexes : m_outputIndexes) {
+    std::vector<uint64_t> indexes;
+    CHECK_TEST_CONDITION(c.get_tx_outputs_gindexs(outputIndexes.first, indexes));
+    CHECK_TEST_CONDITION(indexes == outputIndexes.second);
+
+    std::vector<crypto::hash> ids(1, outputIndexes.first);
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missed;
+    c.get_transactions(ids, txs, missed);
+    CHECK_EQ(1, txs.size());
+    if (txs.front().vin.front().type() == typeid(TransactionInputToKey)) {
+      CHECK_TEST_CONDITION(c.get_blockchain_storage().have_tx_keyimges_as_spent(txs.front()));
+    }
+  }
+
+  return check_key_outputs(c);
+}
@@ -29,3 +29,25 @@ private:
 
   std::list<cryptonote::Transaction> m_tx_pool;
 };
+
+// An alternative chain with an invalid block in its middle is connected up to that block and rolled back,
+// the main chain gets its indexes and transactions back
+class ChainSwitchFailureRestoresMainChain : public test_chain_unit_base
+{
+public:
+  ChainSwitchFailureRestoresMainChain();
+
+  bool generate(std::vector<test_event_entry>& events) const;
+
+  bool check_block_verification_context(const cryptonote::block_verification_context& bvc, size_t event_idx, const cryptonote::Block& blk);
+
+  bool rememberMainChain(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+  bool markSwitchBlock(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+  bool checkMainChainRestored(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+
+private:
+  size_t m_switchBlockIdx;
+  crypto::hash m_tailId;
+  uint64_t m_height;
+  std::unordered_map<crypto::hash, std::vector<uint64_t>> m_outputIndexes;
+};
@@ -5,6 +5,8 @@
 
 #include "chaingen.h"
 
+#include <limits>
+#include <map>
 #include <vector>
 #include <iostream>
 #include <stdint.h>
@@ -25,6 +27,7 @@
 #include "cryptonote_core/cryptonote_boost_serialization.h"
 #include "cryptonote_core/Currency.h"
 #include "cryptonote_core/UpgradeDetector.h"
+#include "rpc/core_rpc_server_commands_defs.h"
 
 using namespace std;
 
@@ -380,6 +383,67 @@ bool find_block_chain(const std::vector<test_event_entry>& events, std::vector<c
 }
 
 
+bool check_key_outputs(cryptonote::core& c)
+{
+  const Currency& currency = c.currency();
+  uint64_t height = c.get_current_blockchain_height();
+
+  // walk the chain and collect the outputs a wallet can use as decoys, by amount and global index
+  std::map<uint64_t, std::map<uint64_t, crypto::public_key>> expected;
+  std::list<Block> blocks;
+  CHECK_AND_ASSERT_MES(c.get_blocks(0, static_cast<size_t>(height), blocks), false, "Failed to get blocks");
+  uint64_t b = 0;
+  for (const Block& blk : blocks)
+  {
+    std::list<Transaction> txs;
+    std::list<crypto::hash> missed;
+    c.get_transactions(blk.txHashes, txs, missed);
+    CHECK_AND_ASSERT_MES(missed.empty(), false, "Failed to get transactions of block " << b);
+    txs.push_front(blk.minerTx);
+
+    for (const Transaction& tx : txs)
+    {
+      std::vector<uint64_t> indexes;
+      CHECK_AND_ASSERT_MES(c.get_tx_outputs_gindexs(get_transaction_hash(tx), indexes), false, "Failed to get output indexes");
+      CHECK_AND_ASSERT_MES(indexes.size() == tx.vout.size(), false, "Wrong output index count in block " << b);
+
+      bool unlocked = tx.unlockTime >= currency.maxBlockHeight() ||
+        height - 1 + currency.lockedTxAllowedDeltaBlocks() >= tx.unlockTime;
+      for (size_t o = 0; o < tx.vout.size(); ++o)
+      {
+        const TransactionOutput& out = tx.vout[o];
+        if (out.target.type() != typeid(TransactionOutputToKey))
+          continue;
+
+        std::map<uint64_t, crypto::public_key>& amountOutputs = expected[out.amount];
+        if (unlocked && b + currency.minedMoneyUnlockWindow() <= height)
+          amountOutputs[indexes[o]] = boost::get<TransactionOutputToKey>(out.target).key;
+      }
+    }
+
+    ++b;
+  }
+
+  COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
+  COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
+  for (const auto& amountOutputs : expected)
+    req.amounts.push_back(amountOutputs.first);
+  req.outs_count = std::numeric_limits<uint64_t>::max();
+  CHECK_AND_ASSERT_MES(c.get_random_outs_for_amounts(req, res), false, "Failed to get random outputs");
+
+  for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& amountOuts : res.outs)
+  {
+    std::map<uint64_t, crypto::public_key> actual;
+    for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& entry : amountOuts.outs)
+      actual[entry.global_amount_index] = entry.out_key;
+
+    CHECK_AND_ASSERT_MES(actual == expected[amountOuts.amount], false, "Key outputs of amount " << amountOuts.amount <<
+      " do not match the chain: " << actual.size() << " returned, " << expected[amountOuts.amount].size() << " expected");
+  }
+
+  return true;
+}
+
 const cryptonote::Currency& test_chain_unit_base::currency() const
 {
   return m_currency;
@@ -175,6 +175,8 @@ void fill_tx_sources_and_destinations(const std::vector<test_event_entry>& event
                                       std::vector<cryptonote::tx_source_entry>& sources,
                                       std::vector<cryptonote::tx_destination_entry>& destinations);
 uint64_t get_balance(const cryptonote::account_base& addr, const std::vector<cryptonote::Block>& blockchain, const map_hash2tx_t& mtx);
+// checks that get_random_outs_for_amounts returns exactly the unlocked key outputs of the chain stored in the core
+bool check_key_outputs(cryptonote::core& c);
 
 //--------------------------------------------------------------------------
 template<class t_test_class>
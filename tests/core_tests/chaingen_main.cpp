@@ -20,6 +20,7 @@
 #include "upgrade.h"
 #include "random_outs.h"
 #include "deposit.h"
+#include "blockchain_cache.h"
 
 namespace po = boost::program_options;
 
@@ -116,6 +117,7 @@ int main(int argc, char* argv[])
     GENERATE_AND_PLAY(gen_simple_chain_split_1);
     GENERATE_AND_PLAY(one_block);
     GENERATE_AND_PLAY(gen_chain_switch_1);
+    GENERATE_AND_PLAY(ChainSwitchFailureRestoresMainChain);
     GENERATE_AND_PLAY(gen_ring_signature_1);
     GENERATE_AND_PLAY(gen_ring_signature_2);
     //GENERATE_AND_PLAY(gen_ring_signature_big); // Takes up to XXX hours (if CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW == 10)
@@ -149,6 +151,7 @@ int main(int argc, char* argv[])
     GENERATE_AND_PLAY_EX_2VER(gen_block_has_invalid_tx);
     GENERATE_AND_PLAY_EX_2VER(gen_block_is_too_big);
     GENERATE_AND_PLAY_EX_2VER(TestBlockCumulativeSizeExceedsLimit);
+    GENERATE_AND_PLAY_EX_2VER(TestCheckpointMismatchRollsBack);
     GENERATE_AND_PLAY_EX_2VER(gen_block_invalid_binary_format); // Takes up to 30 minutes, if CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW == 10
 
     // Transaction verification tests
@@ -219,6 +222,8 @@ int main(int argc, char* argv[])
     GENERATE_AND_PLAY(gen_block_reward);
     GENERATE_AND_PLAY(gen_upgrade);
     GENERATE_AND_PLAY(GetRandomOutputs);
+    GENERATE_AND_PLAY(GetRandomOutputsAfterPopAndReset);
+    GENERATE_AND_PLAY(BlockchainCacheTailReplay);
    
 
     std::cout << (failed_tests.empty() ? concolor::green : concolor::magenta);
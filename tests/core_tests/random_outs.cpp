@@ -94,3 +94,58 @@ bool GetRandomOutputs::checkFullyUnlocked(cryptonote::core& c, size_t ev_index,
 
   return true;
 }
+
+GetRandomOutputsAfterPopAndReset::GetRandomOutputsAfterPopAndReset() {
+  REGISTER_CALLBACK_METHOD(GetRandomOutputsAfterPopAndReset, checkKeyOutputs);
+  REGISTER_CALLBACK_METHOD(GetRandomOutputsAfterPopAndReset, resetChain);
+}
+
+bool GetRandomOutputsAfterPopAndReset::generate(std::vector<test_event_entry>& events) const {
+  TestGenerator generator(m_currency, events);
+  generator.generateBlocks();
+
+  std::vector<cryptonote::Block> chain;
+  for (const test_event_entry& event : events) {
+    chain.push_back(boost::get<cryptonote::Block>(event));
+  }
+
+  cryptonote::Block forkBlock = generator.lastBlock;
+  for (size_t i = 0; i < m_currency.minedMoneyUnlockWindow(); ++i) {
+    auto builder = generator.createTxBuilder(
+      generator.minerAccount, generator.minerAccount, MK_COINS(1), m_currency.minimumFee());
+
+    auto tx = builder.build();
+    generator.addEvent(tx);
+    generator.makeNextBlock(tx);
+  }
+
+  generator.addCallback("checkKeyOutputs");
+
+  // the longer alternative chain pops the blocks with the transactions
+  TestGenerator alternative(generator.generator, generator.minerAccount, forkBlock, m_currency, events);
+  for (size_t i = 0; i <= m_currency.minedMoneyUnlockWindow(); ++i) {
+    alternative.generateBlocks(1);
+    chain.push_back(alternative.lastBlock);
+  }
+
+  generator.addCallback("checkKeyOutputs");
+
+  // the chain is pushed again on its genesis block
+  generator.addCallback("resetChain");
+  for (size_t i = 1; i < chain.size(); ++i) {
+    generator.addEvent(chain[i]);
+  }
+
+  generator.addCallback("checkKeyOutputs");
+  return true;
+}
+
+bool GetRandomOutputsAfterPopAndReset::checkKeyOutputs(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events) {
+  return check_key_outputs(c);
+}
+
+bool GetRandomOutputsAfterPopAndReset::resetChain(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events) {
+  CHECK(c.set_genesis_block(boost::get<cryptonote::Block>(events[0])));
+  CHECK(c.get_current_blockchain_height() == 1);
+  return true;
+}
@@ -26,3 +26,17 @@ private:
   bool request(cryptonote::core& c, uint64_t amount, size_t mixin, cryptonote::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_response& resp);
 
 };
+
+// Outputs of popped blocks and of a chain replaced by set_genesis_block must not be offered as decoys
+struct GetRandomOutputsAfterPopAndReset : public test_chain_unit_base
+{
+  GetRandomOutputsAfterPopAndReset();
+
+  bool generate(std::vector<test_event_entry>& events) const;
+
+private:
+
+  bool checkKeyOutputs(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+  bool resetChain(cryptonote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+
+};
@@ -18,6 +18,7 @@ using namespace crypto;
 typedef crypto::hash chash;
 
 cn_context *context;
+cn_context *contexts[4];
 
 extern "C" {
 
@@ -34,13 +35,39 @@ POP_WARNINGS
   static void slow_hash(const void *data, size_t length, char *hash) {
     cn_slow_hash(*context, data, length, *reinterpret_cast<chash *>(hash));
   }
+
+  // every lane hashes the same input, all of them must match the single hash
+  static void slow_hash_lanes(size_t lanes, const void *data, size_t length, char *hash) {
+    const void *inputs[4] = { data, data, data, data };
+    chash results[4];
+    if (lanes == 2) {
+      cn_slow_hash_2(contexts, inputs, length, results);
+    } else {
+      cn_slow_hash_4(contexts, inputs, length, results);
+    }
+    for (size_t i = 1; i < lanes; i++) {
+      if (results[i] != results[0]) {
+        throw ios_base::failure("Lanes of the interleaved slow hash differ");
+      }
+    }
+    *reinterpret_cast<chash *>(hash) = results[0];
+  }
+
+  static void slow_hash_2(const void *data, size_t length, char *hash) {
+    slow_hash_lanes(2, data, length, hash);
+  }
+
+  static void slow_hash_4(const void *data, size_t length, char *hash) {
+    slow_hash_lanes(4, data, length, hash);
+  }
 }
 
 extern "C" typedef void hash_f(const void *, size_t, char *);
 struct hash_func {
   const string name;
   hash_f &f;
-} hashes[] = {{"fast", cn_fast_hash}, {"slow", slow_hash}, {"tree", hash_tree},
+} hashes[] = {{"fast", cn_fast_hash}, {"slow", slow_hash}, {"slow-2", slow_hash_2},
+  {"slow-4", slow_hash_4}, {"tree", hash_tree},
   {"extra-blake", hash_extra_blake}, {"extra-groestl", hash_extra_groestl},
   {"extra-jh", hash_extra_jh}, {"extra-skein", hash_extra_skein}};
 
@@ -69,6 +96,11 @@ int main(int argc, char *argv[]) {
   if (f == slow_hash) {
     context = new cn_context();
   }
+  if (f == slow_hash_2 || f == slow_hash_4) {
+    for (size_t i = 0; i < 4; i++) {
+      contexts[i] = new cn_context();
+    }
+  }
   input.open(argv[2], ios_base::in);
   for (;;) {
     ++test;
@@ -33,71 +33,79 @@ using namespace Tests::Common;
 void BaseFunctionalTest::launchTestnet(size_t count, Topology t) {
   if (count < 1) LOG_WARNING("Testnet has no nodes");
   for (uint16_t i = 0; i < count; ++i) {
-    std::string dataDirPath = m_dataDir + "/node";
-    dataDirPath += boost::lexical_cast<std::string>(i);
-    boost::filesystem::create_directory(dataDirPath);
+    startNode(i, count, t);
 
-    std::ofstream config(dataDirPath + "/daemon.conf", std::ios_base::trunc | std::ios_base::out);
+    nodeDaemons.push_back(
+      std::unique_ptr<TestNode>(new RPCTestNode(RPC_FIRST_PORT + i, m_dispatcher))
+      );
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10000)); //for initial update
+  nodeDaemons[0]->makeINode(mainNode);
+  makeWallet(workingWallet, mainNode);
+}
 
-    uint16_t rpcPort = RPC_FIRST_PORT + i;
-    uint16_t p2pPort = P2P_FIRST_PORT + i;
+void BaseFunctionalTest::startNode(size_t index, size_t count, Topology t, bool emptyChain) {
+  uint16_t i = static_cast<uint16_t>(index);
+  std::string dataDirPath = m_dataDir + "/node";
+  dataDirPath += boost::lexical_cast<std::string>(i);
+  if (emptyChain) {
+    boost::filesystem::remove_all(dataDirPath);
+  }
+  boost::filesystem::create_directory(dataDirPath);
 
-    config
-      << "rpc-bind-port=" << rpcPort << std::endl
-      << "p2p-bind-port=" << p2pPort << std::endl
-      << "log-level=2" << std::endl
-      << "log-file=test_" << CRYPTONOTE_NAME << "d_" << i + 1 << ".log" << std::endl;
+  std::ofstream config(dataDirPath + "/daemon.conf", std::ios_base::trunc | std::ios_base::out);
 
-    switch (t) {
-    case Line:
-      if (i != count - 1) config << "add-exclusive-node=127.0.0.1:" << p2pPort + 1 << std::endl;
-      if (i != 0)         config << "add-exclusive-node=127.0.0.1:" << p2pPort - 1 << std::endl;
-      break;
-    case Ring: {
-      uint16_t p2pExternalPort = P2P_FIRST_PORT + (i + 1) % count;
-      config << "add-exclusive-node=127.0.0.1:" << p2pExternalPort + 1 << std::endl;
+  uint16_t rpcPort = RPC_FIRST_PORT + i;
+  uint16_t p2pPort = P2P_FIRST_PORT + i;
+
+  config
+    << "rpc-bind-port=" << rpcPort << std::endl
+    << "p2p-bind-port=" << p2pPort << std::endl
+    << "log-level=2" << std::endl
+    << "log-file=test_" << CRYPTONOTE_NAME << "d_" << i + 1 << ".log" << std::endl;
+
+  switch (t) {
+  case Line:
+    if (i != count - 1) config << "add-exclusive-node=127.0.0.1:" << p2pPort + 1 << std::endl;
+    if (i != 0)         config << "add-exclusive-node=127.0.0.1:" << p2pPort - 1 << std::endl;
+    break;
+  case Ring: {
+    uint16_t p2pExternalPort = P2P_FIRST_PORT + (i + 1) % count;
+    config << "add-exclusive-node=127.0.0.1:" << p2pExternalPort + 1 << std::endl;
+  }
+    break;
+  case Star:
+    if (i == 0) {
+      for (size_t node = 1; node < count; ++node)
+        config << "add-exclusive-node=127.0.0.1:" << P2P_FIRST_PORT + node << std::endl;
     }
-      break;
-    case Star:
-      if (i == 0) {
-        for (size_t node = 1; node < count; ++node)
-          config << "add-exclusive-node=127.0.0.1:" << P2P_FIRST_PORT + node << std::endl;
-      }
-      else {
-        config << "add-exclusive-node=127.0.0.1:" << P2P_FIRST_PORT << std::endl;
-      }
-      break;
+    else {
+      config << "add-exclusive-node=127.0.0.1:" << P2P_FIRST_PORT << std::endl;
     }
-    config.close();
+    break;
+  }
+  config.close();
 #if defined WIN32
-    std::string commandLine = "start /MIN \"" + std::string(CRYPTONOTE_NAME) + "d\" \"" + m_daemonDir + "\\" + std::string(CRYPTONOTE_NAME) + "d.exe\" --testnet --data-dir=\"" + dataDirPath + "\" --config-file=daemon.conf";
-    LOG_DEBUG(commandLine);
-    system(commandLine.c_str());
+  std::string commandLine = "start /MIN \"" + std::string(CRYPTONOTE_NAME) + "d\" \"" + m_daemonDir + "\\" + std::string(CRYPTONOTE_NAME) + "d.exe\" --testnet --data-dir=\"" + dataDirPath + "\" --config-file=daemon.conf";
+  LOG_DEBUG(commandLine);
+  system(commandLine.c_str());
 #elif defined __linux__
-    auto pid = fork();
-    if(  pid == 0 ) {
-        std::string pathToDaemon = "" + m_daemonDir + "/" + std::string(CRYPTONOTE_NAME) + "d";
-        close(1);
-        close(2);
-        std::string dataDir = "--data-dir=" + dataDirPath + "";
-        if(execl(pathToDaemon.c_str(), (std::string(CRYPTONOTE_NAME) + "d").c_str(), "--testnet", dataDir.c_str(), "--config-file=daemon.conf", NULL) == -1) {
-            LOG_ERROR(TO_STRING(errno));
-        }
-        throw std::runtime_error("failed to start daemon");
-    } else if(pid > 0) {
-        pids.push_back(pid);
-    }
+  auto pid = fork();
+  if(  pid == 0 ) {
+      std::string pathToDaemon = "" + m_daemonDir + "/" + std::string(CRYPTONOTE_NAME) + "d";
+      close(1);
+      close(2);
+      std::string dataDir = "--data-dir=" + dataDirPath + "";
+      if(execl(pathToDaemon.c_str(), (std::string(CRYPTONOTE_NAME) + "d").c_str(), "--testnet", dataDir.c_str(), "--config-file=daemon.conf", NULL) == -1) {
+          LOG_ERROR(TO_STRING(errno));
+      }
+      throw std::runtime_error("failed to start daemon");
+  } else if(pid > 0) {
+      pids.push_back(pid);
+  }
 #else
 
 #endif
-
-    nodeDaemons.push_back(
-      std::unique_ptr<TestNode>(new RPCTestNode(rpcPort, m_dispatcher))
-      );
-  }
-  std::this_thread::sleep_for(std::chrono::milliseconds(10000)); //for initial update
-  nodeDaemons[0]->makeINode(mainNode);
-  makeWallet(workingWallet, mainNode);
 }
 
 void BaseFunctionalTest::launchTestnetWithInprocNode(size_t count, Topology t) {
@@ -123,6 +123,8 @@ namespace Tests {
 
       void launchTestnet(size_t count, Topology t = Line);
       void launchTestnetWithInprocNode(size_t count, Topology t = Line);
+      // Starts the daemon of one node of a testnet of count nodes, with an empty chain if asked.
+      void startNode(size_t index, size_t count, Topology t, bool emptyChain = false);
       void stopTestnet();
       bool makeWallet(std::unique_ptr<CryptoNote::IWallet> & wallet, std::unique_ptr<CryptoNote::INode>& node, const std::string& password = "pass");
       bool mineBlock(std::unique_ptr<CryptoNote::IWallet>& wallet);
@@ -53,7 +53,7 @@ struct Configuration : public Tests::Common::BaseFunctionalTestConfig {
 
     if (vm.count("test-type")) {
       auto testType = vm["test-type"].as<uint16_t>();
-      if (testType<1 || testType>6) throw ConfigurationError("Incorrect test type.");
+      if (testType<1 || testType>7) throw ConfigurationError("Incorrect test type.");
       _testType = (TestType)testType;
     } else throw ConfigurationError("Missing test type.");
     return true;
@@ -64,7 +64,8 @@ struct Configuration : public Tests::Common::BaseFunctionalTestConfig {
     BLOCKTHRUDAEMONS = 3,
     RELAYBLOCKTHRUDAEMONS = 4,
     TESTPOOLANDINPROCNODE = 5,
-    TESTPOOLDELETION = 6
+    TESTPOOLDELETION = 6,
+    SYNCHRONIZATION = 7
   } _testType;
 
   po::options_description desc;
@@ -73,7 +74,7 @@ protected:
   void init() {
     desc.add_options()
       ("help,h", "produce this help message and exit")
-      ("test-type,t", po::value<uint16_t>()->default_value(1), "test type:\r\n1 - wallet to wallet test,\r\n3 - block thru daemons test\r\n4 - relay block thru daemons\r\n5 - test tx pool and inproc node\r\n6 - deleting tx from pool due to timeout");
+      ("test-type,t", po::value<uint16_t>()->default_value(1), "test type:\r\n1 - wallet to wallet test,\r\n3 - block thru daemons test\r\n4 - relay block thru daemons\r\n5 - test tx pool and inproc node\r\n6 - deleting tx from pool due to timeout\r\n7 - synchronization speed of a new node");
     BaseFunctionalTestConfig::init(desc);
   }
 };
@@ -358,6 +359,59 @@ public:
     return true;
   }
 
+  class WaitForLocalHeightObserver : public CryptoNote::INodeObserver {
+    Tests::Common::Semaphore& m_reached;
+    uint64_t m_height;
+  public:
+    WaitForLocalHeightObserver(Tests::Common::Semaphore& reached, uint64_t height) : m_reached(reached), m_height(height) { }
+    virtual void localBlockchainUpdated(uint64_t height) override {
+      if (height >= m_height) m_reached.notify();
+    }
+  };
+
+  // The first node mines blocksCount blocks, then the second node starts with an empty chain and synchronizes
+  // from it. Prints the blocks per second of the synchronization.
+  bool perform7(size_t blocksCount = 2000) {
+    using namespace Tests::Common;
+    launchTestnet(2, Line);
+    CHECK_AND_ASSERT_MES(nodeDaemons[1]->stopDaemon(), false, "failed to stop the second node");
+    LOG_TRACE("STEP 1 PASSED");
+
+    std::unique_ptr<CryptoNote::INode> sourceNode;
+    nodeDaemons[0]->makeINode(sourceNode);
+
+    Semaphore chainMined;
+    WaitForLocalHeightObserver minedObserver(chainMined, blocksCount);
+    sourceNode->addObserver(&minedObserver);
+    CHECK_AND_ASSERT_MES(startMining(2), false, "failed to start mining");
+    chainMined.wait();
+    CHECK_AND_ASSERT_MES(stopMining(), false, "failed to stop mining");
+    sourceNode->removeObserver(&minedObserver);
+    uint64_t height = sourceNode->getLastLocalBlockHeight();
+    LOG_TRACE("STEP 2 PASSED");
+
+    auto synchronizationStart = std::chrono::steady_clock::now();
+    startNode(1, 2, Line, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2000)); //for rpc server start
+
+    std::unique_ptr<CryptoNote::INode> syncingNode;
+    nodeDaemons[1]->makeINode(syncingNode);
+
+    Semaphore chainSynchronized;
+    WaitForLocalHeightObserver synchronizedObserver(chainSynchronized, height);
+    syncingNode->addObserver(&synchronizedObserver);
+    if (syncingNode->getLastLocalBlockHeight() < height) {
+      CHECK_AND_ASSERT_MES(chainSynchronized.wait_for(std::chrono::milliseconds(30 * 60 * 1000)), false, "synchronization too slow >30min.");
+    }
+    auto synchronizationTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - synchronizationStart).count();
+    syncingNode->removeObserver(&synchronizedObserver);
+
+    LOG_TRACE("Synchronized " + TO_STRING(height) + " blocks in " + TO_STRING(synchronizationTime) + " ms, " +
+      TO_STRING(height * 1000 / std::max<int64_t>(synchronizationTime, 1)) + " blocks/s");
+    LOG_TRACE("STEP 3 PASSED");
+    return true;
+  }
+
   bool perform4() {
     using namespace CryptoNote;
     using namespace Tests::Common;
@@ -793,6 +847,7 @@ int main(int argc, char** argv) {
     case Configuration::RELAYBLOCKTHRUDAEMONS: success = t.perform4(); break;
     case Configuration::TESTPOOLANDINPROCNODE: success = t.perform5(); break;
     case Configuration::TESTPOOLDELETION: success = t.perform6(); break;
+    case Configuration::SYNCHRONIZATION: success = t.perform7(); break;
     default: throw std::runtime_error("Oh snap! Serious crap happened...");
     };
     std::this_thread::sleep_for(std::chrono::milliseconds(5000));
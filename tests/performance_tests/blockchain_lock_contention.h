@@ -0,0 +1,106 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "syncobj.h"
+
+#include "performance_utils.h"
+
+// Lookups into a hash map guarded the way blockchain_storage guards its indexes: reader threads look up
+// transactions and hash the result, while one writer keeps appending entries. Shared == false takes the old
+// exclusive recursive lock for every lookup.
+template<size_t reader_count, bool shared>
+class test_blockchain_lock_contention
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t lookups_per_reader = 20000;
+  static const size_t entry_count = 100000;
+
+  typedef typename std::conditional<shared, epee::recursive_shared_critical_section, epee::critical_section>::type lock_type;
+
+  bool init()
+  {
+    for (uint64_t i = 0; i < entry_count; ++i)
+    {
+      m_entries.insert(std::make_pair(key(i), i));
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> misses(0);
+
+    std::thread writer([this, &stop] {
+      clear_thread_affinity();
+      uint64_t next = entry_count;
+      while (!stop)
+      {
+        crypto::hash k = key(next);
+        {
+          CRITICAL_REGION_LOCAL(m_lock);
+          m_entries.insert(std::make_pair(k, next));
+        }
+
+        ++next;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < reader_count; ++r)
+    {
+      readers.emplace_back([this, r, &misses] {
+        clear_thread_affinity();
+        for (uint64_t i = 0; i < lookups_per_reader; ++i)
+        {
+          crypto::hash k = key((i * reader_count + r) % entry_count);
+          lock_region region(m_lock);
+          auto it = m_entries.find(k);
+          if (it == m_entries.end())
+          {
+            ++misses;
+            continue;
+          }
+
+          crypto::hash h;
+          crypto::cn_fast_hash(&it->second, sizeof(it->second), h);
+        }
+      });
+    }
+
+    for (auto& reader : readers)
+    {
+      reader.join();
+    }
+
+    stop = true;
+    writer.join();
+    return misses == 0;
+  }
+
+private:
+  typedef typename std::conditional<shared, epee::shared_critical_region_t<lock_type>, epee::critical_region_t<lock_type>>::type lock_region;
+
+  static crypto::hash key(uint64_t i)
+  {
+    return crypto::cn_fast_hash(&i, sizeof(i));
+  }
+
+  lock_type m_lock;
+  std::unordered_map<crypto::hash, uint64_t> m_entries;
+};
@@ -0,0 +1,76 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "cryptonote_core/RingSignatureVerifier.h"
+
+#include "performance_utils.h"
+
+// Ring signature checks of a block with input_count key inputs of ring size 10, spread over thread_count threads
+// (the calling thread included) the way blockchain_storage::pushBlock checks them.
+template<size_t thread_count, size_t input_count>
+class test_check_block_ring_signatures
+{
+  static_assert(0 < thread_count, "thread_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = 10;
+
+  bool init()
+  {
+    m_signatures.assign(input_count, std::vector<crypto::signature>(ring_size));
+    m_jobs.resize(input_count);
+    for (size_t i = 0; i < input_count; ++i)
+    {
+      cryptonote::RingSignatureJob& job = m_jobs[i];
+      job.prefixHash = crypto::cn_fast_hash(&i, sizeof(i));
+      job.outputKeys.resize(ring_size);
+
+      crypto::secret_key real_key;
+      for (size_t j = 0; j < ring_size; ++j)
+      {
+        crypto::secret_key key;
+        crypto::generate_keys(job.outputKeys[j], key);
+        if (j == ring_size / 2)
+          real_key = key;
+      }
+
+      crypto::generate_key_image(job.outputKeys[ring_size / 2], real_key, job.keyImage);
+
+      std::vector<const crypto::public_key*> keys;
+      for (const crypto::public_key& key : job.outputKeys)
+        keys.push_back(&key);
+
+      crypto::generate_ring_signature(job.prefixHash, job.keyImage, keys, real_key, ring_size / 2, m_signatures[i].data());
+      job.signatures = m_signatures[i].data();
+    }
+
+    // workers inherit the affinity of the thread that starts them, so start them from an unpinned one
+    std::thread starter([this] {
+      clear_thread_affinity();
+      m_verifier.reset(new cryptonote::RingSignatureVerifier(thread_count - 1));
+    });
+    starter.join();
+
+    return true;
+  }
+
+  bool test()
+  {
+    return m_verifier->verify(m_jobs) == m_jobs.size();
+  }
+
+private:
+  std::vector<std::vector<crypto::signature>> m_signatures;
+  std::vector<cryptonote::RingSignatureJob> m_jobs;
+  std::unique_ptr<cryptonote::RingSignatureVerifier> m_verifier;
+};
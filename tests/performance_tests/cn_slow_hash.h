@@ -8,10 +8,15 @@
 #include "crypto/crypto.h"
 #include "cryptonote_core/cryptonote_basic.h"
 
+// ways hashes per call, computed by the single or the interleaved kernel
+template<size_t ways>
 class test_cn_slow_hash
 {
+  static_assert(ways == 1 || ways == 2 || ways == 4, "ways must be 1, 2 or 4");
+
 public:
   static const size_t loop_count = 10;
+  static const size_t hashes_per_call = ways;
 
 #pragma pack(push, 1)
   struct data_t
@@ -30,18 +35,35 @@ public:
     if (!epee::string_tools::hex_to_pod("bbec2cacf69866a8e740380fe7b818fc78f8571221742d729d9d02d7f8989b87", m_expected_hash))
       return false;
 
+    for (size_t i = 0; i < ways; ++i)
+      m_contexts[i] = &m_context[i];
+
     return true;
   }
 
   bool test()
   {
-    crypto::hash hash;
-    crypto::cn_slow_hash(m_context, &m_data, sizeof(m_data), hash);
-    return hash == m_expected_hash;
+    crypto::hash hashes[ways];
+    const void* data[4] = { &m_data, &m_data, &m_data, &m_data };
+    if (ways == 1)
+      crypto::cn_slow_hash(m_context[0], &m_data, sizeof(m_data), hashes[0]);
+    else if (ways == 2)
+      crypto::cn_slow_hash_2(m_contexts, data, sizeof(m_data), hashes);
+    else
+      crypto::cn_slow_hash_4(m_contexts, data, sizeof(m_data), hashes);
+
+    for (size_t i = 0; i < ways; ++i)
+    {
+      if (hashes[i] != m_expected_hash)
+        return false;
+    }
+
+    return true;
   }
 
 private:
   data_t m_data;
   crypto::hash m_expected_hash;
-  crypto::cn_context m_context;
+  crypto::cn_context m_context[ways];
+  crypto::cn_context* m_contexts[ways];
 };
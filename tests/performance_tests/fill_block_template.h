@@ -0,0 +1,119 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <vector>
+
+#include "cryptonote_core/Currency.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/tx_pool.h"
+
+// Block templates from a pool of tx_count transactions with one key input each and fees spread over a range.
+// With replace == true a transaction is taken out of the pool and a new one added before every template, the
+// template is selected again from the ready transactions, otherwise the previous template is reused.
+template<size_t tx_count, bool replace>
+class test_fill_block_template
+{
+public:
+  static const size_t loop_count = replace ? 100 : 10000;
+  static const size_t median_size = 100000;
+
+  test_fill_block_template() :
+    m_currency(cryptonote::CurrencyBuilder().currency()),
+    m_pool(m_currency, m_validator, m_timeProvider),
+    m_next(0)
+  {
+  }
+
+  bool init()
+  {
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      if (!add_transaction())
+        return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    if (replace)
+    {
+      cryptonote::Transaction tx;
+      size_t blob_size;
+      uint64_t fee;
+      if (!m_pool.take_tx(m_ids[m_next - tx_count], tx, blob_size, fee) || !add_transaction())
+        return false;
+    }
+
+    cryptonote::Block b = boost::value_initialized<cryptonote::Block>();
+    size_t total_size;
+    uint64_t fee;
+    return m_pool.fill_block_template(b, median_size, std::numeric_limits<size_t>::max(), 0, total_size, fee) &&
+      !b.txHashes.empty();
+  }
+
+private:
+  class validator : public CryptoNote::ITransactionValidator
+  {
+  public:
+    virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, CryptoNote::BlockInfo& max_used_block)
+    {
+      max_used_block.height = 0;
+      max_used_block.id = cryptonote::get_transaction_hash(tx);
+      return true;
+    }
+
+    virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, CryptoNote::BlockInfo& max_used_block, CryptoNote::BlockInfo& last_failed)
+    {
+      return true;
+    }
+
+    virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx)
+    {
+      return false;
+    }
+
+    virtual bool isInCheckpointZone() const
+    {
+      return false;
+    }
+  };
+
+  bool add_transaction()
+  {
+    uint64_t n = m_next++;
+    crypto::hash image = crypto::cn_fast_hash(&n, sizeof(n));
+
+    cryptonote::TransactionInputToKey in;
+    in.amount = 1000000000;
+    in.keyOffsets.push_back(0);
+    in.keyImage = reinterpret_cast<const crypto::key_image&>(image);
+
+    cryptonote::TransactionOutput out;
+    out.amount = in.amount - m_currency.minimumFee() * (1 + n % 100);
+    out.target = cryptonote::TransactionOutputToKey();
+
+    cryptonote::Transaction tx;
+    tx.version = cryptonote::TRANSACTION_VERSION_1;
+    tx.vin.push_back(in);
+    tx.vout.push_back(out);
+    tx.signatures.resize(1);
+    tx.signatures[0].resize(1);
+
+    cryptonote::tx_verification_context tvc = boost::value_initialized<cryptonote::tx_verification_context>();
+    m_ids.push_back(cryptonote::get_transaction_hash(tx));
+    return m_pool.add_tx(tx, tvc, false) && tvc.m_added_to_pool;
+  }
+
+  cryptonote::Currency m_currency;
+  validator m_validator;
+  CryptoNote::RealTimeProvider m_timeProvider;
+  cryptonote::tx_memory_pool m_pool;
+  std::vector<crypto::hash> m_ids;
+  uint64_t m_next;
+};
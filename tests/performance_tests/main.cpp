@@ -8,15 +8,20 @@
 #include "crypto/hash.h"
 
 // tests
+#include "blockchain_lock_contention.h"
+#include "check_block_ring_signatures.h"
 #include "construct_tx.h"
 #include "check_ring_signature.h"
 #include "cn_slow_hash.h"
 #include "derive_public_key.h"
 #include "derive_secret_key.h"
+#include "fill_block_template.h"
 #include "generate_key_derivation.h"
 #include "generate_key_image.h"
 #include "generate_key_image_helper.h"
+#include "hash_index_lookup.h"
 #include "is_out_to_acc.h"
+#include "tx_flood.h"
 
 int main(int argc, char** argv)
 {
@@ -52,6 +57,11 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 1, 100);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 2, 100);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 4, 100);
+  TEST_PERFORMANCE2(test_check_block_ring_signatures, 8, 100);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
@@ -59,7 +69,33 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(test_derive_public_key);
   TEST_PERFORMANCE0(test_derive_secret_key);
 
-  TEST_PERFORMANCE0(test_cn_slow_hash);
+  TEST_PERFORMANCE1(test_cn_slow_hash, 1);
+  TEST_PERFORMANCE1(test_cn_slow_hash, 2);
+  TEST_PERFORMANCE1(test_cn_slow_hash, 4);
+
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 1, false);
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 1, true);
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 4, false);
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 4, true);
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 16, false);
+  TEST_PERFORMANCE2(test_blockchain_lock_contention, 16, true);
+
+  TEST_PERFORMANCE2(test_fill_block_template, 10000, false);
+  TEST_PERFORMANCE2(test_fill_block_template, 10000, true);
+  TEST_PERFORMANCE2(test_fill_block_template, 50000, false);
+  TEST_PERFORMANCE2(test_fill_block_template, 50000, true);
+  TEST_PERFORMANCE2(test_fill_block_template, 100000, false);
+  TEST_PERFORMANCE2(test_fill_block_template, 100000, true);
+
+  TEST_PERFORMANCE2(test_tx_flood, 1, 100);
+  TEST_PERFORMANCE2(test_tx_flood, 2, 100);
+  TEST_PERFORMANCE2(test_tx_flood, 4, 100);
+  TEST_PERFORMANCE2(test_tx_flood, 8, 100);
+
+  TEST_PERFORMANCE2(test_hash_index_lookup, 10000, false);
+  TEST_PERFORMANCE2(test_hash_index_lookup, 10000, true);
+  TEST_PERFORMANCE2(test_hash_index_lookup, 1000000, false);
+  TEST_PERFORMANCE2(test_hash_index_lookup, 1000000, true);
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
@@ -5,8 +5,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <stdint.h>
+#include <type_traits>
 
 #include <boost/chrono.hpp>
 
@@ -96,6 +98,29 @@ private:
   int m_elapsed;
 };
 
+// Tests that define hashes_per_call also report a hash rate.
+template <typename T>
+class has_hashes_per_call
+{
+  template <typename U> static char check(decltype(&U::hashes_per_call));
+  template <typename U> static long check(...);
+
+public:
+  static const bool value = sizeof(check<T>(0)) == sizeof(char);
+};
+
+template <typename T>
+void print_hash_rate(const test_runner<T>&, std::false_type)
+{
+}
+
+template <typename T>
+void print_hash_rate(const test_runner<T>& runner, std::true_type)
+{
+  uint64_t hashes = static_cast<uint64_t>(T::loop_count) * T::hashes_per_call;
+  std::cout << "  hash rate:     " << hashes * 1000 / std::max(runner.elapsed_time(), 1) << " H/s\n";
+}
+
 template <typename T>
 void run_test(const char* test_name)
 {
@@ -105,7 +130,9 @@ void run_test(const char* test_name)
     std::cout << test_name << " - OK:\n";
     std::cout << "  loop count:    " << T::loop_count << '\n';
     std::cout << "  elapsed:       " << runner.elapsed_time() << " ms\n";
-    std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n" << std::endl;
+    std::cout << "  time per call: " << runner.time_per_call() << " ms/call\n";
+    print_hash_rate(runner, std::integral_constant<bool, has_hashes_per_call<T>::value>());
+    std::cout << std::endl;
   }
   else
   {
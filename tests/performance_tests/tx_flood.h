@@ -0,0 +1,160 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "cryptonote_core/Currency.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "cryptonote_core/RingSignatureVerifier.h"
+#include "cryptonote_core/tx_pool.h"
+
+#include "performance_utils.h"
+
+// Admission of a relayed burst of tx_count transactions, one key input of ring size 10 each, the way
+// core::handle_incoming_txs admits them: the blobs are parsed, the ring signatures of the whole burst are checked
+// as one batch on thread_count threads (the calling thread included), then the transactions are added to a pool.
+// Admitted transactions per second are tx_count * 1000 / (time per call in ms).
+template<size_t thread_count, size_t tx_count>
+class test_tx_flood
+{
+  static_assert(0 < thread_count, "thread_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t ring_size = 10;
+
+  test_tx_flood() :
+    m_currency(cryptonote::CurrencyBuilder().currency())
+  {
+  }
+
+  bool init()
+  {
+    m_ring_keys.resize(tx_count);
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      std::vector<crypto::public_key>& ring = m_ring_keys[i];
+      ring.resize(ring_size);
+
+      crypto::secret_key real_key;
+      for (size_t j = 0; j < ring_size; ++j)
+      {
+        crypto::secret_key key;
+        crypto::generate_keys(ring[j], key);
+        if (j == ring_size / 2)
+          real_key = key;
+      }
+
+      cryptonote::TransactionInputToKey in;
+      in.amount = 1000000000;
+      for (size_t j = 0; j < ring_size; ++j)
+        in.keyOffsets.push_back(j == 0 ? 0 : 1);
+      crypto::generate_key_image(ring[ring_size / 2], real_key, in.keyImage);
+
+      cryptonote::TransactionOutputToKey out_key;
+      crypto::secret_key out_secret;
+      crypto::generate_keys(out_key.key, out_secret);
+
+      cryptonote::TransactionOutput out;
+      out.amount = in.amount - m_currency.minimumFee();
+      out.target = out_key;
+
+      cryptonote::Transaction tx;
+      tx.version = cryptonote::TRANSACTION_VERSION_1;
+      tx.vin.push_back(in);
+      tx.vout.push_back(out);
+
+      std::vector<const crypto::public_key*> keys;
+      for (const crypto::public_key& key : ring)
+        keys.push_back(&key);
+
+      tx.signatures.resize(1);
+      tx.signatures[0].resize(ring_size);
+      crypto::generate_ring_signature(cryptonote::get_transaction_prefix_hash(tx), in.keyImage, keys, real_key, ring_size / 2,
+        tx.signatures[0].data());
+
+      m_blobs.push_back(cryptonote::t_serializable_object_to_blob(tx));
+    }
+
+    // workers inherit the affinity of the thread that starts them, so start them from an unpinned one
+    std::thread starter([this] {
+      clear_thread_affinity();
+      m_verifier.reset(new cryptonote::RingSignatureVerifier(thread_count - 1));
+    });
+    starter.join();
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<cryptonote::Transaction> txs(tx_count);
+    std::vector<crypto::hash> hashes(tx_count);
+    std::vector<cryptonote::RingSignatureJob> jobs(tx_count);
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      cryptonote::RingSignatureJob& job = jobs[i];
+      if (!cryptonote::parse_and_validate_tx_from_blob(m_blobs[i], txs[i], hashes[i], job.prefixHash))
+        return false;
+
+      job.keyImage = boost::get<cryptonote::TransactionInputToKey>(txs[i].vin[0]).keyImage;
+      job.outputKeys = m_ring_keys[i];
+      job.signatures = txs[i].signatures[0].data();
+    }
+
+    if (m_verifier->verify(jobs) != jobs.size())
+      return false;
+
+    cryptonote::tx_memory_pool pool(m_currency, m_validator, m_timeProvider);
+    for (size_t i = 0; i < tx_count; ++i)
+    {
+      cryptonote::tx_verification_context tvc = boost::value_initialized<cryptonote::tx_verification_context>();
+      if (!pool.add_tx(txs[i], hashes[i], m_blobs[i].size(), tvc, false) || !tvc.m_added_to_pool)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  // the outputs were looked up and the signatures checked before, as with a warm signature cache
+  class validator : public CryptoNote::ITransactionValidator
+  {
+  public:
+    virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, CryptoNote::BlockInfo& max_used_block)
+    {
+      max_used_block.height = 0;
+      max_used_block.id = cryptonote::get_transaction_hash(tx);
+      return true;
+    }
+
+    virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, CryptoNote::BlockInfo& max_used_block, CryptoNote::BlockInfo& last_failed)
+    {
+      return true;
+    }
+
+    virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx)
+    {
+      return false;
+    }
+
+    virtual bool isInCheckpointZone() const
+    {
+      return false;
+    }
+  };
+
+  cryptonote::Currency m_currency;
+  validator m_validator;
+  CryptoNote::RealTimeProvider m_timeProvider;
+  std::vector<cryptonote::blobdata> m_blobs;
+  std::vector<std::vector<crypto::public_key>> m_ring_keys;
+  std::unique_ptr<cryptonote::RingSignatureVerifier> m_verifier;
+};
@@ -69,7 +69,7 @@ bool ICoreStub::getPoolSymmetricDifference(const std::vector<crypto::hash>& know
   return true;
 }
 
-bool ICoreStub::queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp,
+bool ICoreStub::queryBlocks(const std::list<crypto::hash>& block_ids, uint64_t timestamp, bool withGlobalOutputIndexes,
     uint64_t& start_height, uint64_t& current_height, uint64_t& full_offset, std::list<cryptonote::BlockFullInfo>& entries) {
   //stub
   return true;
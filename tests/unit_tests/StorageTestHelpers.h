@@ -0,0 +1,58 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace unit_test {
+  inline crypto::hash makeHash(uint64_t n) {
+    return crypto::cn_fast_hash(&n, sizeof(n));
+  }
+
+  inline crypto::key_image makeKeyImage(uint64_t n) {
+    crypto::hash hash = makeHash(n);
+    return reinterpret_cast<const crypto::key_image&>(hash);
+  }
+
+  // keys that fall into the same group of a FlatHashIndex and carry the same tag
+  template<typename Key>
+  Key makeColliding(Key key) {
+    memset(&key, 0, 10);
+    return key;
+  }
+
+  inline crypto::hash makeCollidingHash(uint64_t n) {
+    return makeColliding(makeHash(n));
+  }
+
+  inline crypto::key_image makeCollidingKeyImage(uint64_t n) {
+    return makeColliding(makeKeyImage(n));
+  }
+
+  // gives each test a fresh temporary file name and removes the file afterwards
+  class TemporaryFileTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() override {
+      fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    }
+
+    virtual void TearDown() override {
+      boost::system::error_code ec;
+      boost::filesystem::remove(fileName, ec);
+    }
+
+    std::string fileName;
+  };
+}
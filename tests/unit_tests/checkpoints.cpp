@@ -139,3 +139,18 @@ TEST(checkpoints_is_alternative_block_allowed, handles_two_and_more_checkpoints)
   ASSERT_TRUE (cp.is_alternative_block_allowed(11, 10));
   ASSERT_TRUE (cp.is_alternative_block_allowed(11, 11));
 }
+
+TEST(checkpoints_get_checkpoint_below, returns_previous_checkpoint_height)
+{
+  checkpoints cp;
+  ASSERT_EQ(0, cp.get_checkpoint_below(10));
+
+  cp.add_checkpoint(5, "0000000000000000000000000000000000000000000000000000000000000000");
+  cp.add_checkpoint(9, "0000000000000000000000000000000000000000000000000000000000000000");
+
+  ASSERT_EQ(0, cp.get_checkpoint_below(0));
+  ASSERT_EQ(0, cp.get_checkpoint_below(5));
+  ASSERT_EQ(5, cp.get_checkpoint_below(6));
+  ASSERT_EQ(5, cp.get_checkpoint_below(9));
+  ASSERT_EQ(9, cp.get_checkpoint_below(10));
+}
@@ -396,6 +396,26 @@ TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_process
   ASSERT_EQ(3, m_commands_handler.callback_counter());
 }
 
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_sends_shared_notify_buffer)
+{
+  const int expected_command = 3572469;
+
+  test_connection_ptr conn = create_connection();
+
+  boost::shared_ptr<const std::string> out_data(new std::string(256, 'n'));
+  ASSERT_EQ(1, m_handler_config.notify(expected_command, out_data, conn->m_protocol_handler.get_connection_id()));
+
+  std::string send_data = conn->last_send_data();
+  ASSERT_EQ(sizeof(epee::levin::bucket_head2) + out_data->size(), send_data.size());
+  epee::levin::bucket_head2 head = *reinterpret_cast<const epee::levin::bucket_head2*>(send_data.data());
+  ASSERT_EQ(LEVIN_SIGNATURE, head.m_signature);
+  ASSERT_EQ(expected_command, head.m_command);
+  ASSERT_EQ(out_data->size(), head.m_cb);
+  ASSERT_FALSE(head.m_have_to_return_data);
+  ASSERT_EQ(*out_data, send_data.substr(sizeof(head)));
+  ASSERT_EQ(256, out_data->size());
+}
+
 TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_big_packet_1)
 {
   std::string buf("yyyyyy");
@@ -505,3 +525,28 @@ TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_unexpe
 
   ASSERT_FALSE(m_conn->m_protocol_handler.handle_recv(m_buf.data(), m_buf.size()));
 }
+
+TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_byte_by_byte_chunks)
+{
+  prepare_buf();
+  m_buf.append(m_buf);
+
+  for (size_t i = 0; i < m_buf.size(); ++i)
+  {
+    ASSERT_TRUE(m_conn->m_protocol_handler.handle_recv(m_buf.data() + i, 1));
+    ASSERT_EQ(i + 1 < m_buf.size() / 2 ? 0 : (i + 1 < m_buf.size() ? 1 : 2), m_commands_handler.invoke_counter());
+  }
+
+  ASSERT_EQ(m_in_data, m_commands_handler.last_in_buf());
+}
+
+TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_empty_body)
+{
+  m_in_data.clear();
+  m_req_head.m_cb = 0;
+  prepare_buf();
+
+  ASSERT_TRUE(m_conn->m_protocol_handler.handle_recv(m_buf.data(), m_buf.size()));
+  ASSERT_EQ(1, m_commands_handler.invoke_counter());
+  ASSERT_TRUE(m_commands_handler.last_in_buf().empty());
+}
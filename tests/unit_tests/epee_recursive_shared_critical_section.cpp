@@ -0,0 +1,95 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "syncobj.h"
+
+namespace
+{
+  const std::chrono::milliseconds wait_time(100);
+}
+
+TEST(recursive_shared_critical_section, readers_share_the_lock)
+{
+  epee::recursive_shared_critical_section section;
+  SHARED_CRITICAL_REGION_LOCAL(section);
+
+  auto reader = std::async(std::launch::async, [&section] {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+    return true;
+  });
+
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(wait_time));
+}
+
+TEST(recursive_shared_critical_section, writer_excludes_readers)
+{
+  epee::recursive_shared_critical_section section;
+  std::atomic<bool> writer_done(false);
+
+  std::future<bool> reader;
+  {
+    CRITICAL_REGION_LOCAL(section);
+    reader = std::async(std::launch::async, [&section, &writer_done] {
+      SHARED_CRITICAL_REGION_LOCAL(section);
+      return writer_done.load();
+    });
+
+    ASSERT_EQ(std::future_status::timeout, reader.wait_for(wait_time));
+    writer_done = true;
+  }
+
+  ASSERT_TRUE(reader.get());
+}
+
+TEST(recursive_shared_critical_section, writer_waits_for_readers)
+{
+  epee::recursive_shared_critical_section section;
+
+  std::future<void> writer;
+  {
+    SHARED_CRITICAL_REGION_LOCAL(section);
+    writer = std::async(std::launch::async, [&section] {
+      CRITICAL_REGION_LOCAL(section);
+    });
+
+    ASSERT_EQ(std::future_status::timeout, writer.wait_for(wait_time));
+
+    // a reader re-entering the lock must not block behind the waiting writer
+    SHARED_CRITICAL_REGION_LOCAL1(section);
+  }
+
+  ASSERT_EQ(std::future_status::ready, writer.wait_for(wait_time));
+}
+
+TEST(recursive_shared_critical_section, writer_reenters_in_both_modes)
+{
+  epee::recursive_shared_critical_section section;
+
+  std::future<void> reader;
+  {
+    CRITICAL_REGION_LOCAL(section);
+    {
+      CRITICAL_REGION_LOCAL1(section);
+    }
+    {
+      SHARED_CRITICAL_REGION_LOCAL1(section);
+    }
+
+    reader = std::async(std::launch::async, [&section] {
+      SHARED_CRITICAL_REGION_LOCAL(section);
+    });
+
+    ASSERT_EQ(std::future_status::timeout, reader.wait_for(wait_time));
+  }
+
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(wait_time));
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockEntryBlob.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+#include "serialization/binary_utils.h"
+
+using namespace cryptonote;
+
+namespace {
+  // same layout as blockchain_storage::TransactionEntry and blockchain_storage::BlockEntry
+  struct TestTransactionEntry {
+    Transaction tx;
+    std::vector<uint32_t> m_global_output_indexes;
+
+    BEGIN_SERIALIZE_OBJECT()
+      FIELD(tx)
+      FIELD(m_global_output_indexes)
+    END_SERIALIZE()
+  };
+
+  struct TestBlockEntry {
+    Block bl;
+    uint32_t height;
+    uint64_t block_cumulative_size;
+    difficulty_type cumulative_difficulty;
+    uint64_t already_generated_coins;
+    std::vector<TestTransactionEntry> transactions;
+
+    BEGIN_SERIALIZE_OBJECT()
+      FIELD(bl)
+      VARINT_FIELD(height)
+      VARINT_FIELD(block_cumulative_size)
+      VARINT_FIELD(cumulative_difficulty)
+      VARINT_FIELD(already_generated_coins)
+      FIELD(transactions)
+    END_SERIALIZE()
+  };
+
+  template<typename T> T makeBlob(uint8_t fill) {
+    T blob;
+    memset(&blob, fill, sizeof(blob));
+    return blob;
+  }
+
+  Transaction makeMinerTransaction(uint32_t height) {
+    Transaction tx;
+    tx.version = TRANSACTION_VERSION_1;
+    tx.unlockTime = height + 10;
+    tx.vin.push_back(TransactionInputGenerate{ height });
+    TransactionOutput output;
+    output.amount = 70000000000;
+    output.target = TransactionOutputToKey(makeBlob<crypto::public_key>(1));
+    tx.vout.push_back(output);
+    tx.extra.assign(33, 0x01);
+    return tx;
+  }
+
+  Transaction makeTransaction(uint8_t fill) {
+    Transaction tx;
+    tx.version = TRANSACTION_VERSION_2;
+    tx.unlockTime = 0;
+
+    TransactionInputToKey keyInput;
+    keyInput.amount = 1000;
+    keyInput.keyOffsets = { 5, 300, 70000 };
+    keyInput.keyImage = makeBlob<crypto::key_image>(fill);
+    tx.vin.push_back(keyInput);
+
+    TransactionInputMultisignature multisignatureInput;
+    multisignatureInput.amount = 20000;
+    multisignatureInput.signatures = 2;
+    multisignatureInput.outputIndex = 129;
+    multisignatureInput.term = 0;
+    tx.vin.push_back(multisignatureInput);
+
+    TransactionOutput keyOutput;
+    keyOutput.amount = 900;
+    keyOutput.target = TransactionOutputToKey(makeBlob<crypto::public_key>(fill));
+    tx.vout.push_back(keyOutput);
+
+    TransactionOutputMultisignature multisignatureTarget;
+    multisignatureTarget.keys = { makeBlob<crypto::public_key>(2), makeBlob<crypto::public_key>(3) };
+    multisignatureTarget.requiredSignatures = 1;
+    multisignatureTarget.term = 0;
+    TransactionOutput multisignatureOutput;
+    multisignatureOutput.amount = 20000;
+    multisignatureOutput.target = multisignatureTarget;
+    tx.vout.push_back(multisignatureOutput);
+
+    tx.extra.assign(200, fill);
+    tx.signatures.push_back(std::vector<crypto::signature>(3, makeBlob<crypto::signature>(fill)));
+    tx.signatures.push_back(std::vector<crypto::signature>(2, makeBlob<crypto::signature>(fill + 1)));
+    return tx;
+  }
+
+  TestBlockEntry makeBlockEntry() {
+    TestBlockEntry entry;
+    entry.bl.majorVersion = BLOCK_MAJOR_VERSION_2;
+    entry.bl.minorVersion = BLOCK_MINOR_VERSION_0;
+    entry.bl.timestamp = 1430000000;
+    entry.bl.prevId = makeBlob<crypto::hash>(7);
+    entry.bl.nonce = 0x12345678;
+    entry.bl.minerTx = makeMinerTransaction(200000);
+    entry.height = 200000;
+    entry.block_cumulative_size = 300000;
+    entry.cumulative_difficulty = 1234567890123;
+    entry.already_generated_coins = 10000000000000;
+
+    entry.transactions.resize(1);
+    entry.transactions[0].tx = entry.bl.minerTx;
+    entry.transactions[0].m_global_output_indexes = { 1000000 };
+    for (uint8_t i = 0; i < 2; ++i) {
+      entry.transactions.resize(entry.transactions.size() + 1);
+      entry.transactions.back().tx = makeTransaction(10 + i);
+      entry.transactions.back().m_global_output_indexes = { 50, 1 };
+      entry.bl.txHashes.push_back(get_transaction_hash(entry.transactions.back().tx));
+    }
+
+    return entry;
+  }
+}
+
+TEST(BlockEntryBlob, splitMatchesSerializedObjects) {
+  TestBlockEntry entry = makeBlockEntry();
+  blobdata entryBlob;
+  ASSERT_TRUE(::serialization::dump_binary(entry, entryBlob));
+
+  blobdata block;
+  std::list<blobdata> txs;
+  std::vector<uint64_t> globalOutputIndexes;
+  ASSERT_TRUE(splitBlockEntryBlob(entryBlob.data(), entryBlob.size(), block, txs, globalOutputIndexes));
+  ASSERT_EQ(block_to_blob(entry.bl), block);
+  ASSERT_EQ(2, txs.size());
+  ASSERT_EQ(tx_to_blob(entry.transactions[1].tx), txs.front());
+  ASSERT_EQ(tx_to_blob(entry.transactions[2].tx), txs.back());
+  ASSERT_EQ(std::vector<uint64_t>({ 1000000, 50, 1, 50, 1 }), globalOutputIndexes);
+}
+
+TEST(BlockEntryBlob, splitRejectsMalformedData) {
+  TestBlockEntry entry = makeBlockEntry();
+  blobdata entryBlob;
+  ASSERT_TRUE(::serialization::dump_binary(entry, entryBlob));
+
+  blobdata block;
+  std::list<blobdata> txs;
+  std::vector<uint64_t> globalOutputIndexes;
+  for (size_t size = 0; size < entryBlob.size(); size += 7) {
+    ASSERT_FALSE(splitBlockEntryBlob(entryBlob.data(), size, block, txs, globalOutputIndexes));
+  }
+
+  blobdata longer = entryBlob + '\0';
+  ASSERT_FALSE(splitBlockEntryBlob(longer.data(), longer.size(), block, txs, globalOutputIndexes));
+
+  blobdata otherVersion = entryBlob;
+  otherVersion[0] = BLOCK_MAJOR_VERSION_2 + 1;
+  ASSERT_FALSE(splitBlockEntryBlob(otherVersion.data(), otherVersion.size(), block, txs, globalOutputIndexes));
+
+  ASSERT_TRUE(block.empty());
+  ASSERT_TRUE(txs.empty());
+  ASSERT_TRUE(globalOutputIndexes.empty());
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockHeaderColumns.h"
+
+#include "StorageTestHelpers.h"
+
+using namespace cryptonote;
+
+namespace {
+  void pushBlocks(BlockHeaderColumns& headers, uint64_t count) {
+    for (uint64_t i = headers.size(); i < count; ++i) {
+      headers.push(1000 + i * 120, (i + 1) * 10, 100 + i, i < count / 2 ? BLOCK_MAJOR_VERSION_1 : BLOCK_MAJOR_VERSION_2,
+        BLOCK_MINOR_VERSION_0);
+    }
+  }
+
+  typedef unit_test::TemporaryFileTest BlockHeaderColumnsFile;
+}
+
+TEST(BlockHeaderColumns, pushAndPop) {
+  BlockHeaderColumns headers;
+  ASSERT_TRUE(headers.empty());
+
+  pushBlocks(headers, 10);
+  ASSERT_EQ(10, headers.size());
+  ASSERT_EQ(1000 + 9 * 120, headers.timestamps().back());
+  ASSERT_EQ(100, headers.cumulativeDifficulties().back());
+  ASSERT_EQ(109, headers.cumulativeSizes().back());
+  ASSERT_EQ(BLOCK_MAJOR_VERSION_1, headers.majorVersion(4));
+  ASSERT_EQ(BLOCK_MAJOR_VERSION_2, headers.majorVersion(5));
+  ASSERT_EQ(BLOCK_MINOR_VERSION_0, headers.minorVersion(5));
+
+  headers.pop();
+  ASSERT_EQ(9, headers.size());
+  ASSERT_EQ(90, headers.cumulativeDifficulties().back());
+
+  headers.clear();
+  ASSERT_TRUE(headers.empty());
+}
+
+TEST_F(BlockHeaderColumnsFile, loadRestoresSavedColumns) {
+  BlockHeaderColumns headers;
+  pushBlocks(headers, 1000);
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(headers.save(fileName, headers.size(), lastBlockHash));
+
+  BlockHeaderColumns loaded;
+  ASSERT_TRUE(loaded.load(fileName, 1000, lastBlockHash));
+  ASSERT_EQ(headers.timestamps(), loaded.timestamps());
+  ASSERT_EQ(headers.cumulativeDifficulties(), loaded.cumulativeDifficulties());
+  ASSERT_EQ(headers.cumulativeSizes(), loaded.cumulativeSizes());
+  for (uint64_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(headers.majorVersion(i), loaded.majorVersion(i));
+    ASSERT_EQ(headers.minorVersion(i), loaded.minorVersion(i));
+  }
+}
+
+TEST_F(BlockHeaderColumnsFile, loadRejectsOtherChainState) {
+  BlockHeaderColumns headers;
+  pushBlocks(headers, 10);
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(headers.save(fileName, headers.size(), lastBlockHash));
+
+  BlockHeaderColumns loaded;
+  ASSERT_FALSE(loaded.load(fileName, 11, lastBlockHash));
+  ASSERT_FALSE(loaded.load(fileName, 10, crypto::cn_fast_hash("other", 5)));
+  ASSERT_FALSE(loaded.load(fileName + ".missing", 10, lastBlockHash));
+  ASSERT_TRUE(loaded.empty());
+}
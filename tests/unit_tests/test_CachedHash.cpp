@@ -0,0 +1,107 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/cryptonote_basic.h"
+#include "cryptonote_core/cryptonote_format_utils.h"
+
+using namespace cryptonote;
+
+namespace {
+  Transaction makeTransaction(uint64_t height) {
+    Transaction tx;
+    tx.version = TRANSACTION_VERSION_1;
+    tx.unlockTime = height;
+    TransactionInputGenerate in;
+    in.height = height;
+    tx.vin.push_back(in);
+    return tx;
+  }
+
+  Transaction parseTransaction(const Transaction& source) {
+    Transaction tx;
+    crypto::hash hash;
+    crypto::hash prefixHash;
+    EXPECT_TRUE(parse_and_validate_tx_from_blob(t_serializable_object_to_blob(source), tx, hash, prefixHash));
+    return tx;
+  }
+
+  // hash of the current content, bypassing the cache
+  crypto::hash computeHash(const Transaction& tx) {
+    return get_blob_hash(t_serializable_object_to_blob(tx));
+  }
+}
+
+TEST(CachedHash, builtTransactionIsHashedOnEveryUse) {
+  Transaction tx = makeTransaction(1);
+  crypto::hash before = get_transaction_hash(tx);
+
+  tx.unlockTime = 2;
+  ASSERT_NE(before, get_transaction_hash(tx));
+  ASSERT_EQ(computeHash(tx), get_transaction_hash(tx));
+}
+
+TEST(CachedHash, parsedTransactionIsHashedOnce) {
+  Transaction tx = parseTransaction(makeTransaction(1));
+  ObjectHashStatistics before = get_object_hash_statistics();
+
+  ASSERT_EQ(computeHash(tx), get_transaction_hash(tx));
+  ASSERT_EQ(t_serializable_object_to_blob(tx).size(), get_object_blobsize(tx));
+  ASSERT_EQ(get_transaction_prefix_hash(static_cast<const TransactionPrefix&>(tx)), get_transaction_prefix_hash(tx));
+
+  ObjectHashStatistics after = get_object_hash_statistics();
+  ASSERT_EQ(before.transactionHashes, after.transactionHashes);
+  ASSERT_LE(before.transactionHashCacheHits + 2, after.transactionHashCacheHits);
+  ASSERT_EQ(before.prefixHashes, after.prefixHashes);
+}
+
+TEST(CachedHash, invalidatedTransactionIsHashedAgain) {
+  Transaction tx = parseTransaction(makeTransaction(1));
+  get_transaction_hash(tx);
+
+  tx.unlockTime = 2;
+  tx.invalidateHashes();
+  ASSERT_EQ(computeHash(tx), get_transaction_hash(tx));
+  ASSERT_EQ(get_transaction_prefix_hash(static_cast<const TransactionPrefix&>(tx)), get_transaction_prefix_hash(tx));
+}
+
+TEST(CachedHash, cacheIsCopiedAndDroppedByClear) {
+  Transaction parsed = parseTransaction(makeTransaction(1));
+  crypto::hash hash = get_transaction_hash(parsed);
+
+  Transaction copy = parsed;
+  crypto::hash cached;
+  size_t size;
+  ASSERT_TRUE(copy.hashCache.get(cached, size));
+  ASSERT_EQ(hash, cached);
+
+  copy.clear();
+  ASSERT_FALSE(copy.hashCache.get(cached, size));
+  ASSERT_FALSE(copy.hashCache.enabled());
+}
+
+TEST(CachedHash, parsedBlockIsHashedOnce) {
+  Block block = boost::value_initialized<Block>();
+  block.majorVersion = BLOCK_MAJOR_VERSION_1;
+  block.minerTx = makeTransaction(1);
+  block.txHashes.push_back(get_transaction_hash(makeTransaction(2)));
+
+  Block parsed;
+  ASSERT_TRUE(parse_and_validate_block_from_blob(block_to_blob(block), parsed));
+  crypto::hash hash = get_block_hash(block);
+
+  ObjectHashStatistics before = get_object_hash_statistics();
+  ASSERT_EQ(hash, get_block_hash(parsed));
+  ASSERT_EQ(hash, get_block_hash(parsed));
+  ObjectHashStatistics after = get_object_hash_statistics();
+  ASSERT_EQ(before.blockHashes + 1, after.blockHashes);
+  ASSERT_EQ(before.blockHashCacheHits + 1, after.blockHashCacheHits);
+
+  parsed.nonce = 1;
+  parsed.invalidateHashes();
+  block.nonce = 1;
+  ASSERT_EQ(get_block_hash(block), get_block_hash(parsed));
+}
@@ -0,0 +1,214 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/BlockIndex.h"
+#include "cryptonote_core/FlatHashIndex.h"
+
+#include "StorageTestHelpers.h"
+
+using namespace cryptonote;
+using namespace unit_test;
+
+namespace {
+  struct Entry {
+    crypto::hash key;
+    uint64_t value;
+  };
+
+  struct EntryKey {
+    const crypto::hash& operator()(const Entry& entry) const {
+      return entry.key;
+    }
+  };
+
+  typedef FlatHashIndex<Entry, EntryKey> Index;
+
+  Entry makeEntry(const crypto::hash& key, uint64_t value) {
+    Entry entry = { key, value };
+    return entry;
+  }
+
+  typedef unit_test::TemporaryFileTest FlatHashIndexFile;
+}
+
+TEST(FlatHashIndex, insertFindErase) {
+  Index index;
+  ASSERT_EQ(nullptr, index.find(makeHash(1)));
+
+  ASSERT_TRUE(index.insert(makeEntry(makeHash(1), 10)));
+  ASSERT_FALSE(index.insert(makeEntry(makeHash(1), 11)));
+  ASSERT_EQ(1, index.size());
+
+  const Entry* entry = index.find(makeHash(1));
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(10, entry->value);
+
+  ASSERT_TRUE(index.erase(makeHash(1)));
+  ASSERT_FALSE(index.erase(makeHash(1)));
+  ASSERT_EQ(nullptr, index.find(makeHash(1)));
+  ASSERT_EQ(0, index.size());
+}
+
+TEST(FlatHashIndex, growsAndKeepsAllEntries) {
+  Index index;
+  const uint64_t count = 100000;
+  for (uint64_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(index.insert(makeEntry(makeHash(i), i)));
+  }
+
+  ASSERT_EQ(count, index.size());
+  ASSERT_LE(count * 8, index.capacity() * 7);
+  ASSERT_EQ(index.capacity() * (sizeof(Entry) + 2), index.memoryUsage());
+  for (uint64_t i = 0; i < count; ++i) {
+    const Entry* entry = index.find(makeHash(i));
+    ASSERT_NE(nullptr, entry);
+    ASSERT_EQ(i, entry->value);
+    ASSERT_EQ(nullptr, index.find(makeHash(count + i)));
+  }
+}
+
+TEST(FlatHashIndex, reserveAvoidsRehash) {
+  Index index;
+  index.reserve(1000);
+  size_t capacity = index.capacity();
+  for (uint64_t i = 0; i < 1000; ++i) {
+    index.insert(makeEntry(makeHash(i), i));
+  }
+
+  ASSERT_EQ(capacity, index.capacity());
+}
+
+TEST(FlatHashIndex, collidingKeysProbeFurtherGroups) {
+  Index index;
+  for (uint64_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(index.insert(makeEntry(makeCollidingHash(i), i)));
+  }
+
+  for (uint64_t i = 0; i < 40; i += 2) {
+    ASSERT_TRUE(index.erase(makeCollidingHash(i)));
+  }
+
+  for (uint64_t i = 0; i < 40; ++i) {
+    ASSERT_EQ(i % 2 == 1, index.find(makeCollidingHash(i)) != nullptr);
+  }
+
+  ASSERT_EQ(nullptr, index.find(makeCollidingHash(40)));
+}
+
+TEST(FlatHashIndex, erasedSlotsAreReused) {
+  Index index;
+  for (uint64_t round = 0; round < 100; ++round) {
+    for (uint64_t i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(index.insert(makeEntry(makeHash(round * 1000 + i), i)));
+    }
+
+    for (uint64_t i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(index.erase(makeHash(round * 1000 + i)));
+    }
+  }
+
+  ASSERT_EQ(0, index.size());
+  ASSERT_GE(4096, index.capacity());
+}
+
+TEST_F(FlatHashIndexFile, loadRestoresSavedIndex) {
+  Index index;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    index.insert(makeEntry(makeHash(i), i));
+  }
+
+  index.erase(makeHash(0));
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(index.save(fileName, 10, lastBlockHash));
+
+  Index loaded;
+  ASSERT_TRUE(loaded.load(fileName, 10, lastBlockHash));
+  ASSERT_EQ(index.size(), loaded.size());
+  ASSERT_EQ(nullptr, loaded.find(makeHash(0)));
+  for (uint64_t i = 1; i < 1000; ++i) {
+    const Entry* entry = loaded.find(makeHash(i));
+    ASSERT_NE(nullptr, entry);
+    ASSERT_EQ(i, entry->value);
+  }
+
+  ASSERT_TRUE(loaded.insert(makeEntry(makeHash(1000), 1000)));
+  ASSERT_NE(nullptr, loaded.find(makeHash(1000)));
+}
+
+TEST_F(FlatHashIndexFile, loadRejectsOtherChainState) {
+  Index index;
+  index.insert(makeEntry(makeHash(1), 1));
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(index.save(fileName, 10, lastBlockHash));
+
+  Index loaded;
+  ASSERT_FALSE(loaded.load(fileName, 11, lastBlockHash));
+  ASSERT_FALSE(loaded.load(fileName, 10, crypto::cn_fast_hash("other", 5)));
+  ASSERT_FALSE(loaded.load(fileName + ".missing", 10, lastBlockHash));
+  ASSERT_EQ(nullptr, loaded.find(makeHash(1)));
+}
+
+TEST_F(FlatHashIndexFile, loadRejectsOtherEntrySize) {
+  Index index;
+  index.insert(makeEntry(makeHash(1), 1));
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(index.save(fileName, 10, lastBlockHash));
+
+  struct SmallEntry {
+    crypto::hash key;
+  };
+
+  struct SmallEntryKey {
+    const crypto::hash& operator()(const SmallEntry& entry) const {
+      return entry.key;
+    }
+  };
+
+  FlatHashIndex<SmallEntry, SmallEntryKey> loaded;
+  ASSERT_FALSE(loaded.load(fileName, 10, lastBlockHash));
+}
+
+TEST(BlockIndex, pushPopAndLookup) {
+  CryptoNote::BlockIndex index;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(index.push(makeHash(i)));
+  }
+
+  ASSERT_FALSE(index.push(makeHash(10)));
+  ASSERT_EQ(1000, index.size());
+
+  uint64_t height = 0;
+  ASSERT_TRUE(index.getBlockHeight(makeHash(500), height));
+  ASSERT_EQ(500, height);
+  ASSERT_EQ(makeHash(500), index.getBlockId(500));
+
+  index.pop();
+  ASSERT_FALSE(index.hasBlock(makeHash(999)));
+  ASSERT_EQ(makeHash(998), index.getTailId());
+
+  ASSERT_TRUE(index.push(makeHash(999)));
+  ASSERT_TRUE(index.getBlockHeight(makeHash(999), height));
+  ASSERT_EQ(999, height);
+}
+
+TEST(BlockIndex, copyIsIndependent) {
+  CryptoNote::BlockIndex index;
+  for (uint64_t i = 0; i < 100; ++i) {
+    ASSERT_TRUE(index.push(makeHash(i)));
+  }
+
+  CryptoNote::BlockIndex copy(index);
+  index.pop();
+  index.push(makeHash(1000));
+
+  uint64_t height = 0;
+  ASSERT_EQ(100, copy.size());
+  ASSERT_TRUE(copy.getBlockHeight(makeHash(99), height));
+  ASSERT_EQ(99, height);
+  ASSERT_FALSE(copy.hasBlock(makeHash(1000)));
+  ASSERT_EQ(makeHash(99), copy.getTailId());
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/KeyImageSet.h"
+
+#include "StorageTestHelpers.h"
+
+using namespace cryptonote;
+using namespace unit_test;
+
+namespace {
+  typedef unit_test::TemporaryFileTest KeyImageSetFile;
+}
+
+TEST(KeyImageSet, insertContainsErase) {
+  KeyImageSet set;
+  ASSERT_FALSE(set.contains(makeKeyImage(1)));
+
+  ASSERT_TRUE(set.insert(makeKeyImage(1)));
+  ASSERT_FALSE(set.insert(makeKeyImage(1)));
+  ASSERT_TRUE(set.contains(makeKeyImage(1)));
+  ASSERT_EQ(1, set.size());
+
+  ASSERT_TRUE(set.erase(makeKeyImage(1)));
+  ASSERT_FALSE(set.erase(makeKeyImage(1)));
+  ASSERT_FALSE(set.contains(makeKeyImage(1)));
+  ASSERT_EQ(0, set.size());
+}
+
+TEST(KeyImageSet, growsAndKeepsAllKeys) {
+  KeyImageSet set;
+  const uint64_t count = 100000;
+  for (uint64_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(set.insert(makeKeyImage(i)));
+  }
+
+  ASSERT_EQ(count, set.size());
+  ASSERT_LE(count * 8, set.capacity() * 7);
+  for (uint64_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(set.contains(makeKeyImage(i)));
+    ASSERT_FALSE(set.contains(makeKeyImage(count + i)));
+  }
+}
+
+TEST(KeyImageSet, collidingKeysProbeFurtherGroups) {
+  KeyImageSet set;
+  for (uint64_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(set.insert(makeCollidingKeyImage(i)));
+  }
+
+  for (uint64_t i = 0; i < 40; i += 2) {
+    ASSERT_TRUE(set.erase(makeCollidingKeyImage(i)));
+  }
+
+  for (uint64_t i = 0; i < 40; ++i) {
+    ASSERT_EQ(i % 2 == 1, set.contains(makeCollidingKeyImage(i)));
+  }
+
+  ASSERT_FALSE(set.contains(makeCollidingKeyImage(40)));
+}
+
+TEST(KeyImageSet, erasedSlotsAreReused) {
+  KeyImageSet set;
+  for (uint64_t round = 0; round < 100; ++round) {
+    for (uint64_t i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(set.insert(makeKeyImage(round * 1000 + i)));
+    }
+
+    for (uint64_t i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(set.erase(makeKeyImage(round * 1000 + i)));
+    }
+  }
+
+  ASSERT_EQ(0, set.size());
+  ASSERT_GE(4096, set.capacity());
+}
+
+TEST_F(KeyImageSetFile, loadRestoresSavedSet) {
+  KeyImageSet set;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    set.insert(makeKeyImage(i));
+  }
+
+  set.erase(makeKeyImage(0));
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(set.save(fileName, 10, lastBlockHash));
+
+  KeyImageSet loaded;
+  ASSERT_TRUE(loaded.load(fileName, 10, lastBlockHash));
+  ASSERT_EQ(set.size(), loaded.size());
+  ASSERT_FALSE(loaded.contains(makeKeyImage(0)));
+  for (uint64_t i = 1; i < 1000; ++i) {
+    ASSERT_TRUE(loaded.contains(makeKeyImage(i)));
+  }
+
+  ASSERT_TRUE(loaded.insert(makeKeyImage(1000)));
+  ASSERT_TRUE(loaded.contains(makeKeyImage(1000)));
+}
+
+TEST_F(KeyImageSetFile, loadRejectsOtherChainState) {
+  KeyImageSet set;
+  set.insert(makeKeyImage(1));
+  crypto::hash lastBlockHash = crypto::cn_fast_hash("block", 5);
+  ASSERT_TRUE(set.save(fileName, 10, lastBlockHash));
+
+  KeyImageSet loaded;
+  ASSERT_FALSE(loaded.load(fileName, 11, lastBlockHash));
+  ASSERT_FALSE(loaded.load(fileName, 10, crypto::cn_fast_hash("other", 5)));
+  ASSERT_FALSE(loaded.load(fileName + ".missing", 10, lastBlockHash));
+  ASSERT_FALSE(loaded.contains(makeKeyImage(1)));
+}
@@ -0,0 +1,288 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "cryptonote_core/MappedVector.h"
+#include "serialization/serialization.h"
+#include "serialization/string.h"
+#include "serialization/binary_utils.h"
+
+namespace {
+  struct Item {
+    uint64_t number;
+    std::string payload;
+
+    BEGIN_SERIALIZE_OBJECT()
+      VARINT_FIELD(number)
+      FIELD(payload)
+    END_SERIALIZE()
+  };
+
+  Item makeItem(uint64_t number) {
+    Item item;
+    item.number = number;
+    item.payload.assign(static_cast<size_t>(number % 100 + 1), static_cast<char>('a' + number % 26));
+    return item;
+  }
+
+  class MappedVectorTest : public ::testing::Test {
+  public:
+    MappedVectorTest() : m_directory(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+      boost::filesystem::create_directories(m_directory);
+      m_itemsFileName = (m_directory / "items.dat").string();
+      m_indexesFileName = (m_directory / "indexes.dat").string();
+    }
+
+    ~MappedVectorTest() {
+      boost::system::error_code ec;
+      boost::filesystem::remove_all(m_directory, ec);
+    }
+
+  protected:
+    boost::filesystem::path m_directory;
+    std::string m_itemsFileName;
+    std::string m_indexesFileName;
+  };
+}
+
+TEST_F(MappedVectorTest, pushedItemsSurviveReopen) {
+  {
+    MappedVector<Item> items;
+    ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+    for (uint64_t i = 0; i < 100; ++i) {
+      items.push_back(makeItem(i));
+    }
+
+    items.pop_back();
+    ASSERT_EQ(99, items.size());
+  }
+
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  ASSERT_EQ(99, items.size());
+  for (uint64_t i = 0; i < items.size(); ++i) {
+    Item expected = makeItem(i);
+    ASSERT_EQ(expected.number, items[i]->number);
+    ASSERT_EQ(expected.payload, items.get(i)->payload);
+  }
+
+  EXPECT_EQ(98, items.back()->number);
+}
+
+TEST_F(MappedVectorTest, blobIsSerializedItem) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  Item item = makeItem(42);
+  items.push_back(item);
+
+  std::string expected;
+  ASSERT_TRUE(serialization::dump_binary(item, expected));
+  EXPECT_EQ(expected, items.getBlob(0).str());
+}
+
+TEST_F(MappedVectorTest, heldBlobSurvivesReplacedItem) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  Item item = makeItem(9);
+  items.push_back(item);
+
+  // the replacing item has the same size and is written over the popped one
+  MappedVector<Item>::Blob blob = items.getBlob(0);
+  items.pop_back();
+  items.push_back(makeItem(109));
+
+  std::string expected;
+  ASSERT_TRUE(serialization::dump_binary(item, expected));
+  EXPECT_EQ(expected, blob.str());
+  EXPECT_EQ(109, items.get(0)->number);
+}
+
+TEST_F(MappedVectorTest, cacheIsBoundedAndCountsHits) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 16 * 256));
+  for (uint64_t i = 0; i < 1000; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  auto statistics = items.getCacheStatistics();
+  EXPECT_LE(statistics.size, statistics.capacity);
+  EXPECT_EQ(0, statistics.misses);
+
+  items.get(0);
+  items.get(0);
+  statistics = items.getCacheStatistics();
+  EXPECT_EQ(1, statistics.misses);
+  EXPECT_EQ(1, statistics.hits);
+}
+
+TEST_F(MappedVectorTest, heldItemsOutliveEviction) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 16 * 256));
+  items.push_back(makeItem(0));
+  std::shared_ptr<const Item> first = items[0];
+  for (uint64_t i = 1; i < 1000; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  auto statistics = items.getCacheStatistics();
+  EXPECT_LE(statistics.size, statistics.capacity);
+  EXPECT_EQ(0, first->number);
+  EXPECT_EQ(makeItem(0).payload, first->payload);
+}
+
+TEST_F(MappedVectorTest, concurrentReadersSeeConsistentItems) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 16 * 1024));
+  for (uint64_t i = 0; i < 2000; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  std::vector<std::thread> readers;
+  std::atomic<size_t> failures(0);
+  for (size_t t = 0; t < 4; ++t) {
+    readers.emplace_back([&items, &failures, t] {
+      for (uint64_t i = t; i < 2000; i += 3) {
+        auto item = items.get(i);
+        if (item->number != i || item->payload != makeItem(i).payload) {
+          ++failures;
+        }
+      }
+    });
+  }
+
+  for (uint64_t i = 2000; i < 2500; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(0, failures);
+  EXPECT_EQ(2500, items.size());
+}
+
+TEST_F(MappedVectorTest, readersRacingWithReplacedItemNeverCacheIt) {
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024 * 1024));
+  for (uint64_t i = 0; i < 10; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  // the last item is popped and pushed again with another content at the same place in the file
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> failures(0);
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < 4; ++t) {
+    readers.emplace_back([&items, &stop, &failures] {
+      while (!stop) {
+        try {
+          auto item = items.get(9);
+          if (item->payload != makeItem(item->number).payload || item->number % 100 != 9) {
+            ++failures;
+          }
+
+          Item blobItem;
+          if (!serialization::parse_binary(items.getBlob(9).str(), blobItem) || blobItem.payload != makeItem(blobItem.number).payload) {
+            ++failures;
+          }
+        } catch (std::runtime_error&) {
+          // the item is popped and not pushed yet
+        }
+      }
+    });
+  }
+
+  for (uint64_t i = 1; i <= 2000; ++i) {
+    items.pop_back();
+    items.push_back(makeItem(9 + i * 100));
+  }
+
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(0, failures);
+  EXPECT_EQ(9 + 2000 * 100, items.get(9)->number);
+  EXPECT_EQ(9 + 2000 * 100, items.load(9)->number);
+}
+
+TEST_F(MappedVectorTest, loadBypassesCache) {
+  {
+    MappedVector<Item> items;
+    ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+    items.push_back(makeItem(1));
+  }
+
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  EXPECT_EQ(1, items.load(0)->number);
+  auto statistics = items.getCacheStatistics();
+  EXPECT_EQ(0, statistics.items);
+  EXPECT_EQ(0, statistics.misses);
+
+  EXPECT_EQ(1, items.get(0)->number);
+  statistics = items.getCacheStatistics();
+  EXPECT_EQ(1, statistics.items);
+  EXPECT_EQ(1, statistics.misses);
+}
+
+TEST_F(MappedVectorTest, batchedIndexesAreWrittenOnFlush) {
+  {
+    MappedVector<Item> items;
+    ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+    items.setIndexBatchSize(10);
+    for (uint64_t i = 0; i < 25; ++i) {
+      items.push_back(makeItem(i));
+    }
+
+    // the last item of the pending batch is dropped without touching the index file
+    items.pop_back();
+    ASSERT_EQ(24, items.size());
+    EXPECT_EQ(23, items.back()->number);
+
+    items.flush();
+    items.push_back(makeItem(24));
+  }
+
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  ASSERT_EQ(25, items.size());
+  for (uint64_t i = 0; i < items.size(); ++i) {
+    ASSERT_EQ(i, items[i]->number);
+    ASSERT_EQ(makeItem(i).payload, items[i]->payload);
+  }
+}
+
+TEST_F(MappedVectorTest, indexFileCountsOnlyWrittenBatches) {
+  auto storedCount = [this] {
+    std::ifstream indexes(m_indexesFileName, std::ios::binary);
+    uint64_t count = 0;
+    indexes.read(reinterpret_cast<char*>(&count), sizeof count);
+    return count;
+  };
+
+  MappedVector<Item> items;
+  ASSERT_TRUE(items.open(m_itemsFileName, m_indexesFileName, 1024));
+  items.setIndexBatchSize(10);
+  for (uint64_t i = 0; i < 15; ++i) {
+    items.push_back(makeItem(i));
+  }
+
+  EXPECT_EQ(10, storedCount());
+
+  items.setIndexBatchSize(1);
+  EXPECT_EQ(15, storedCount());
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "cryptonote_core/RingSignatureVerifier.h"
+
+using namespace cryptonote;
+
+namespace {
+  const size_t RING_SIZE = 3;
+
+  class RingSignatureVerifierTest : public ::testing::Test {
+  protected:
+    // Every job gets its own ring and a valid signature by the middle key of the ring.
+    void makeJobs(size_t count) {
+      m_signatures.assign(count, std::vector<crypto::signature>(RING_SIZE));
+      m_jobs.resize(count);
+      for (size_t i = 0; i < count; ++i) {
+        RingSignatureJob& job = m_jobs[i];
+        job.prefixHash = crypto::cn_fast_hash(&i, sizeof(i));
+        job.outputKeys.resize(RING_SIZE);
+
+        crypto::secret_key realKey;
+        for (size_t j = 0; j < RING_SIZE; ++j) {
+          crypto::secret_key secretKey;
+          crypto::generate_keys(job.outputKeys[j], secretKey);
+          if (j == RING_SIZE / 2) {
+            realKey = secretKey;
+          }
+        }
+
+        crypto::generate_key_image(job.outputKeys[RING_SIZE / 2], realKey, job.keyImage);
+
+        std::vector<const crypto::public_key*> keys;
+        for (const crypto::public_key& key : job.outputKeys) {
+          keys.push_back(&key);
+        }
+
+        crypto::generate_ring_signature(job.prefixHash, job.keyImage, keys, realKey, RING_SIZE / 2, m_signatures[i].data());
+        job.signatures = m_signatures[i].data();
+      }
+    }
+
+    void breakJob(size_t index) {
+      m_jobs[index].prefixHash = crypto::cn_fast_hash(&m_jobs[index].prefixHash, sizeof(m_jobs[index].prefixHash));
+    }
+
+    std::vector<std::vector<crypto::signature>> m_signatures;
+    std::vector<RingSignatureJob> m_jobs;
+  };
+}
+
+TEST_F(RingSignatureVerifierTest, acceptsValidSignatures) {
+  makeJobs(16);
+
+  RingSignatureVerifier verifier(3);
+  ASSERT_EQ(m_jobs.size(), verifier.verify(m_jobs));
+}
+
+TEST_F(RingSignatureVerifierTest, acceptsEmptyBatch) {
+  RingSignatureVerifier verifier(3);
+  ASSERT_EQ(0, verifier.verify(m_jobs));
+}
+
+TEST_F(RingSignatureVerifierTest, reportsFirstFailure) {
+  makeJobs(32);
+  breakJob(9);
+  breakJob(10);
+  breakJob(30);
+
+  RingSignatureVerifier serialVerifier(0);
+  RingSignatureVerifier verifier(3);
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_EQ(9, serialVerifier.verify(m_jobs));
+    ASSERT_EQ(9, verifier.verify(m_jobs));
+  }
+}
+
+TEST_F(RingSignatureVerifierTest, reportsFailureOfLastJob) {
+  makeJobs(8);
+  breakJob(7);
+
+  RingSignatureVerifier verifier(3);
+  ASSERT_EQ(7, verifier.verify(m_jobs));
+}
+
+TEST_F(RingSignatureVerifierTest, cachedSignaturesAreNotCheckedAgain) {
+  makeJobs(4);
+
+  RingSignatureVerifier verifier(3, 16);
+  ASSERT_EQ(4, verifier.verify(m_jobs));
+  ASSERT_EQ(4, verifier.verify(m_jobs));
+
+  RingSignatureCacheStatistics statistics = verifier.getCacheStatistics();
+  ASSERT_EQ(4, statistics.items);
+  ASSERT_EQ(4, statistics.hits);
+  ASSERT_EQ(4, statistics.misses);
+}
+
+TEST_F(RingSignatureVerifierTest, reportsFailureBehindCachedJobs) {
+  makeJobs(8);
+
+  RingSignatureVerifier verifier(3, 16);
+  std::vector<RingSignatureJob> firstJobs(m_jobs.begin(), m_jobs.begin() + 4);
+  ASSERT_EQ(4, verifier.verify(firstJobs));
+
+  breakJob(6);
+  ASSERT_EQ(6, verifier.verify(m_jobs));
+  // the jobs before the failure are remembered, the failed one is not
+  ASSERT_EQ(6, verifier.getCacheStatistics().items);
+  ASSERT_EQ(6, verifier.verify(m_jobs));
+}
+
+TEST_F(RingSignatureVerifierTest, changedSignatureIsCheckedAgain) {
+  makeJobs(2);
+
+  RingSignatureVerifier verifier(0, 16);
+  ASSERT_EQ(2, verifier.verify(m_jobs));
+
+  m_signatures[1][0] = m_signatures[1][1];
+  ASSERT_EQ(1, verifier.verify(m_jobs));
+}
+
+TEST_F(RingSignatureVerifierTest, cacheDropsOldestSignatures) {
+  makeJobs(4);
+
+  RingSignatureVerifier verifier(0, 2);
+  ASSERT_EQ(4, verifier.verify(m_jobs));
+  ASSERT_EQ(2, verifier.getCacheStatistics().items);
+
+  std::vector<RingSignatureJob> newestJobs(m_jobs.begin() + 2, m_jobs.end());
+  ASSERT_EQ(2, verifier.verify(newestJobs));
+  ASSERT_EQ(2, verifier.getCacheStatistics().hits);
+}
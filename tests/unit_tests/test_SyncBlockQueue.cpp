@@ -0,0 +1,177 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "cryptonote_core/SyncBlockQueue.h"
+
+using namespace cryptonote;
+
+namespace {
+  const std::chrono::milliseconds NO_WAIT(0);
+  const std::chrono::steady_clock::time_point NOW;
+
+  epee::net_utils::connection_context_base makeConnection() {
+    return epee::net_utils::connection_context_base(boost::uuids::random_generator()(), 0, 0, false);
+  }
+
+  crypto::hash blockId(uint64_t height) {
+    return crypto::cn_fast_hash(&height, sizeof(height));
+  }
+
+  SyncBlock makeBlock(uint64_t height, const epee::net_utils::connection_context_base& source) {
+    return SyncBlock{ height, blockId(height), block_complete_entry(), source };
+  }
+
+  void claimAndPush(SyncBlockQueue& queue, uint64_t height, const epee::net_utils::connection_context_base& source) {
+    ASSERT_TRUE(queue.claim(blockId(height), height, source.m_connection_id, NOW));
+    queue.push(makeBlock(height, source));
+  }
+}
+
+TEST(SyncBlockQueue, claimIsExclusive) {
+  SyncBlockQueue queue(10);
+  auto first = makeConnection();
+  auto second = makeConnection();
+
+  ASSERT_TRUE(queue.claim(blockId(1), 1, first.m_connection_id, NOW));
+  ASSERT_FALSE(queue.claim(blockId(1), 1, second.m_connection_id, NOW));
+  ASSERT_FALSE(queue.idle());
+
+  queue.releaseConnection(first.m_connection_id);
+  ASSERT_TRUE(queue.idle());
+  ASSERT_TRUE(queue.claim(blockId(1), 1, second.m_connection_id, NOW));
+}
+
+TEST(SyncBlockQueue, fullAtCapacity) {
+  SyncBlockQueue queue(2);
+  auto connection = makeConnection();
+
+  ASSERT_TRUE(queue.claim(blockId(1), 1, connection.m_connection_id, NOW));
+  ASSERT_FALSE(queue.full());
+  ASSERT_TRUE(queue.claim(blockId(2), 2, connection.m_connection_id, NOW));
+  ASSERT_TRUE(queue.full());
+
+  queue.complete(blockId(1));
+  ASSERT_FALSE(queue.full());
+}
+
+TEST(SyncBlockQueue, popsInHeightOrderAcrossConnections) {
+  SyncBlockQueue queue(10);
+  auto first = makeConnection();
+  auto second = makeConnection();
+
+  claimAndPush(queue, 12, second);
+  claimAndPush(queue, 11, second);
+  claimAndPush(queue, 10, first);
+
+  std::vector<SyncBlock> blocks;
+  ASSERT_TRUE(queue.pop(10, 10, blocks, NO_WAIT));
+  ASSERT_EQ(3, blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    ASSERT_EQ(10 + i, blocks[i].height);
+    ASSERT_EQ(blockId(10 + i), blocks[i].id);
+  }
+}
+
+TEST(SyncBlockQueue, waitsForMissingBlock) {
+  SyncBlockQueue queue(10);
+  auto connection = makeConnection();
+
+  claimAndPush(queue, 10, connection);
+  claimAndPush(queue, 12, connection);
+
+  std::vector<SyncBlock> blocks;
+  ASSERT_FALSE(queue.pop(9, 10, blocks, NO_WAIT));
+
+  ASSERT_TRUE(queue.pop(10, 10, blocks, NO_WAIT));
+  ASSERT_EQ(1, blocks.size());
+  ASSERT_EQ(10, blocks.front().height);
+
+  blocks.clear();
+  ASSERT_FALSE(queue.pop(11, 10, blocks, NO_WAIT));
+
+  claimAndPush(queue, 11, connection);
+  ASSERT_TRUE(queue.pop(11, 10, blocks, NO_WAIT));
+  ASSERT_EQ(2, blocks.size());
+}
+
+TEST(SyncBlockQueue, popHonorsMaxCount) {
+  SyncBlockQueue queue(10);
+  auto connection = makeConnection();
+
+  for (uint64_t height = 0; height < 5; ++height) {
+    claimAndPush(queue, height, connection);
+  }
+
+  std::vector<SyncBlock> blocks;
+  ASSERT_TRUE(queue.pop(0, 3, blocks, NO_WAIT));
+  ASSERT_EQ(3, blocks.size());
+
+  blocks.clear();
+  ASSERT_TRUE(queue.pop(3, 3, blocks, NO_WAIT));
+  ASSERT_EQ(2, blocks.size());
+}
+
+TEST(SyncBlockQueue, releaseDropsQueuedBlocksOfConnection) {
+  SyncBlockQueue queue(10);
+  auto first = makeConnection();
+  auto second = makeConnection();
+
+  claimAndPush(queue, 10, first);
+  claimAndPush(queue, 11, second);
+  ASSERT_TRUE(queue.claim(blockId(12), 12, first.m_connection_id, NOW));
+
+  queue.releaseConnection(first.m_connection_id);
+
+  // a block arriving after the release is not queued
+  queue.push(makeBlock(12, first));
+
+  std::vector<SyncBlock> blocks;
+  ASSERT_TRUE(queue.pop(11, 10, blocks, NO_WAIT));
+  ASSERT_EQ(1, blocks.size());
+  ASSERT_EQ(11, blocks.front().height);
+
+  queue.complete(blocks.front().id);
+  ASSERT_TRUE(queue.idle());
+}
+
+TEST(SyncBlockQueue, stalledConnectionsHoldNextBlock) {
+  SyncBlockQueue queue(10);
+  auto first = makeConnection();
+  auto second = makeConnection();
+  const std::chrono::seconds timeout(15);
+
+  ASSERT_TRUE(queue.claim(blockId(10), 10, first.m_connection_id, NOW));
+  ASSERT_TRUE(queue.claim(blockId(11), 11, second.m_connection_id, NOW));
+
+  ASSERT_TRUE(queue.getStalledConnections(10, NOW + timeout - std::chrono::seconds(1), timeout).empty());
+  auto stalled = queue.getStalledConnections(10, NOW + timeout, timeout);
+  ASSERT_EQ(1, stalled.size());
+  ASSERT_EQ(first.m_connection_id, stalled.front());
+
+  // a delivered block does not stall the chain, it waits for validation
+  queue.push(makeBlock(10, first));
+  ASSERT_TRUE(queue.getStalledConnections(10, NOW + timeout, timeout).empty());
+}
+
+TEST(SyncBlockQueue, waitingConnectionsAreTakenOnce) {
+  SyncBlockQueue queue(10);
+  auto connection = makeConnection();
+
+  queue.addWaiting(connection.m_connection_id);
+  ASSERT_EQ(1, queue.takeWaiting().size());
+  ASSERT_TRUE(queue.takeWaiting().empty());
+}
+
+TEST(SyncBlockQueue, stopInterruptsPop) {
+  SyncBlockQueue queue(10);
+  queue.stop();
+
+  std::vector<SyncBlock> blocks;
+  ASSERT_FALSE(queue.pop(0, 10, blocks, std::chrono::milliseconds(60000)));
+}
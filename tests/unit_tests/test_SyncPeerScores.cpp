@@ -0,0 +1,115 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_core/SyncPeerScores.h"
+
+using namespace cryptonote;
+
+namespace {
+  const uint32_t FAST_PEER = 1;
+  const uint32_t SLOW_PEER = 2;
+  const uint32_t NEW_PEER = 3;
+  const size_t DISCONNECTED_LIMIT = 10;
+
+  void addResponses(SyncPeerScores& scores, uint32_t address, uint64_t bytesPerSecond, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      scores.addResponse(address, std::chrono::milliseconds(1500), std::chrono::seconds(1), bytesPerSecond);
+    }
+  }
+}
+
+TEST(SyncPeerScores, measuresThroughputAndRoundTrip) {
+  SyncPeerScores scores(DISCONNECTED_LIMIT);
+  scores.addConnection(FAST_PEER);
+  scores.addResponse(FAST_PEER, std::chrono::milliseconds(3000), std::chrono::milliseconds(500), 1000000);
+
+  auto stats = scores.getStats();
+  ASSERT_EQ(1, stats.size());
+  ASSERT_EQ(FAST_PEER, stats[0].first);
+  ASSERT_EQ(1, stats[0].second.responses);
+  ASSERT_EQ(3000, stats[0].second.roundTrip.count());
+  ASSERT_EQ(2000000, stats[0].second.bytesPerSecond);
+  ASSERT_DOUBLE_EQ(2000000, scores.score(FAST_PEER));
+}
+
+TEST(SyncPeerScores, slowPeersAreRankedLast) {
+  SyncPeerScores scores(DISCONNECTED_LIMIT);
+  scores.addConnection(SLOW_PEER);
+  scores.addConnection(FAST_PEER);
+  scores.addConnection(NEW_PEER);
+  addResponses(scores, FAST_PEER, 1000000, 3);
+  addResponses(scores, SLOW_PEER, 100000, 3);
+
+  ASSERT_FALSE(scores.isSlow(FAST_PEER));
+  ASSERT_TRUE(scores.isSlow(SLOW_PEER));
+  ASSERT_FALSE(scores.isSlow(NEW_PEER));
+
+  // unmeasured peers get the average score
+  ASSERT_DOUBLE_EQ(550000, scores.score(NEW_PEER));
+
+  auto stats = scores.getStats();
+  ASSERT_EQ(3, stats.size());
+  ASSERT_EQ(FAST_PEER, stats[0].first);
+  ASSERT_EQ(NEW_PEER, stats[1].first);
+  ASSERT_EQ(SLOW_PEER, stats[2].first);
+}
+
+TEST(SyncPeerScores, failuresLowerScore) {
+  SyncPeerScores scores(DISCONNECTED_LIMIT);
+  scores.addConnection(FAST_PEER);
+  addResponses(scores, FAST_PEER, 1000000, 4);
+  double score = scores.score(FAST_PEER);
+
+  scores.addStall(FAST_PEER);
+  ASSERT_LT(scores.score(FAST_PEER), score);
+  score = scores.score(FAST_PEER);
+
+  scores.addInvalid(FAST_PEER);
+  ASSERT_LT(scores.score(FAST_PEER), score);
+}
+
+TEST(SyncPeerScores, measuredPeersOutliveConnections) {
+  SyncPeerScores scores(DISCONNECTED_LIMIT);
+  scores.addConnection(FAST_PEER);
+  scores.addConnection(NEW_PEER);
+  addResponses(scores, FAST_PEER, 1000000, 1);
+
+  scores.removeConnection(FAST_PEER);
+  scores.removeConnection(NEW_PEER);
+
+  auto stats = scores.getStats();
+  ASSERT_EQ(1, stats.size());
+  ASSERT_EQ(FAST_PEER, stats[0].first);
+  ASSERT_EQ(0, stats[0].second.connections);
+
+  scores.addConnection(FAST_PEER);
+  ASSERT_DOUBLE_EQ(1000000, scores.score(FAST_PEER));
+}
+
+TEST(SyncPeerScores, disconnectedPeersAreCapped) {
+  SyncPeerScores scores(DISCONNECTED_LIMIT);
+  for (uint32_t address = 100; address < 100 + 2 * DISCONNECTED_LIMIT; ++address) {
+    scores.addConnection(address);
+    addResponses(scores, address, 1000000, 1);
+    scores.removeConnection(address);
+  }
+
+  auto stats = scores.getStats();
+  ASSERT_EQ(DISCONNECTED_LIMIT, stats.size());
+  for (const auto& peer : stats) {
+    ASSERT_LE(100 + DISCONNECTED_LIMIT, peer.first);
+  }
+
+  // a reconnected peer is not counted against the limit
+  scores.addConnection(100 + DISCONNECTED_LIMIT);
+  scores.addConnection(FAST_PEER);
+  addResponses(scores, FAST_PEER, 1000000, 1);
+  scores.removeConnection(FAST_PEER);
+  stats = scores.getStats();
+  ASSERT_EQ(DISCONNECTED_LIMIT + 1, stats.size());
+  ASSERT_DOUBLE_EQ(1000000, scores.score(100 + DISCONNECTED_LIMIT));
+}
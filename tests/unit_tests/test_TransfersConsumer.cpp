@@ -584,6 +584,42 @@ TEST_F(TransfersConsumerTest, onNewBlocks_getTransactionOutsGlobalIndicesIsNotCa
   ASSERT_FALSE(node.called);
 }
 
+TEST_F(TransfersConsumerTest, onNewBlocks_globalIndicesFromBlockAreUsed) {
+  class INodeGlobalIndicesStub: public INodeDummyStub {
+  public:
+    INodeGlobalIndicesStub() : called(false) {};
+
+    virtual void getTransactionOutsGlobalIndices(const crypto::hash& transactionHash,
+      std::vector<uint64_t>& outsGlobalIndices, const Callback& callback) override {
+      outsGlobalIndices.push_back(3);
+      called = true;
+      callback(std::error_code());
+    };
+
+    bool called;
+  };
+
+  INodeGlobalIndicesStub node;
+  TransfersConsumer consumer(m_currency, node, m_accountKeys.viewSecretKey);
+  auto& container = addSubscription(consumer).getContainer();
+
+  std::shared_ptr<ITransaction> tx(createTransaction());
+  addTestInput(*tx, 10000);
+  auto out = addTestKeyOutput(*tx, 10000, 7, m_accountKeys);
+
+  CompleteBlock block;
+  block.block = cryptonote::Block();
+  block.block->timestamp = 0;
+  block.transactions.push_back(tx);
+  block.globalOutputIndexes.push_back({ 7 });
+  ASSERT_TRUE(consumer.onNewBlocks(&block, 0, 1));
+
+  ASSERT_FALSE(node.called);
+  auto outs = container.getTransactionOutputs(tx->getTransactionHash(), ITransfersContainer::IncludeAll);
+  ASSERT_EQ(1, outs.size());
+  ASSERT_EQ(out.globalOutputIndex, outs[0].globalOutputIndex);
+}
+
 TEST_F(TransfersConsumerTest, onNewBlocks_markTransactionConfirmed) {
   auto& container = addSubscription().getContainer();
 
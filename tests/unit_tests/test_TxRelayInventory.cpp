@@ -0,0 +1,185 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <unordered_set>
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "cryptonote_core/TxRelayInventory.h"
+
+using namespace cryptonote;
+
+namespace {
+  crypto::hash txId(uint32_t n) {
+    return crypto::cn_fast_hash(&n, sizeof(n));
+  }
+
+  std::vector<crypto::hash> txIds(uint32_t begin, uint32_t end) {
+    std::vector<crypto::hash> ids;
+    for (uint32_t n = begin; n < end; ++n) {
+      ids.push_back(txId(n));
+    }
+
+    return ids;
+  }
+
+  //expired requests come in no particular order
+  std::unordered_set<crypto::hash> txIdSet(const std::vector<crypto::hash>& ids) {
+    return std::unordered_set<crypto::hash>(ids.begin(), ids.end());
+  }
+}
+
+TEST(TxRelayInventory, takeUnknownSkipsKnownIds) {
+  TxRelayInventory inventory(100, std::chrono::seconds(30));
+  boost::uuids::uuid connection = boost::uuids::random_generator()();
+  inventory.addConnection(connection);
+  inventory.addKnown(connection, txIds(0, 5));
+
+  std::vector<crypto::hash> unknown;
+  inventory.takeUnknown(connection, txIds(3, 8), unknown);
+  ASSERT_EQ(txIds(5, 8), unknown);
+
+  unknown.clear();
+  inventory.takeUnknown(connection, txIds(0, 8), unknown);
+  ASSERT_TRUE(unknown.empty());
+
+  inventory.removeConnection(connection);
+  inventory.takeUnknown(connection, txIds(0, 2), unknown);
+  ASSERT_EQ(txIds(0, 2), unknown);
+}
+
+TEST(TxRelayInventory, knownIdsAreForgottenAfterTwoGenerations) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  boost::uuids::uuid connection = boost::uuids::random_generator()();
+  inventory.addConnection(connection);
+  inventory.addKnown(connection, txIds(0, 10));
+  inventory.addKnown(connection, txIds(10, 20));
+
+  std::vector<crypto::hash> unknown;
+  inventory.takeUnknown(connection, txIds(0, 20), unknown);
+  ASSERT_TRUE(unknown.empty());
+
+  inventory.addKnown(connection, txIds(20, 21));
+  inventory.takeUnknown(connection, txIds(0, 1), unknown);
+  ASSERT_EQ(txIds(0, 1), unknown);
+}
+
+TEST(TxRelayInventory, queuedIdsAreTakenOnce) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  inventory.queue(txIds(0, 3));
+  inventory.queue(txIds(3, 4));
+  ASSERT_EQ(txIds(0, 4), inventory.takeQueued());
+  ASSERT_TRUE(inventory.takeQueued().empty());
+}
+
+TEST(TxRelayInventory, idsAreRequestedFromFirstAnnouncer) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  boost::uuids::uuid first = boost::uuids::random_generator()();
+  boost::uuids::uuid second = boost::uuids::random_generator()();
+  auto now = std::chrono::steady_clock::now();
+
+  std::vector<crypto::hash> request;
+  inventory.takeRequests(first, txIds(0, 3), now, request);
+  ASSERT_EQ(txIds(0, 3), request);
+
+  request.clear();
+  inventory.takeRequests(second, txIds(0, 4), now + std::chrono::seconds(10), request);
+  ASSERT_EQ(txIds(3, 4), request);
+
+  request.clear();
+  inventory.received(txIds(0, 1));
+  inventory.takeRequests(second, txIds(0, 4), now + std::chrono::seconds(20), request);
+  ASSERT_EQ(txIds(0, 1), request);
+
+  std::map<boost::uuids::uuid, std::vector<crypto::hash>> requests;
+  inventory.takeExpiredRequests(now + std::chrono::seconds(20), requests);
+  ASSERT_TRUE(requests.empty());
+}
+
+TEST(TxRelayInventory, silentPeerIsReplacedByNextAnnouncer) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  boost::uuids::uuid silent = boost::uuids::random_generator()();
+  boost::uuids::uuid second = boost::uuids::random_generator()();
+  boost::uuids::uuid third = boost::uuids::random_generator()();
+  auto now = std::chrono::steady_clock::now();
+
+  std::vector<crypto::hash> request;
+  inventory.takeRequests(silent, txIds(0, 3), now, request);
+  inventory.takeRequests(second, txIds(0, 2), now, request);
+  inventory.takeRequests(third, txIds(0, 3), now, request);
+  inventory.takeRequests(second, txIds(0, 2), now, request);
+  ASSERT_EQ(txIds(0, 3), request);
+
+  std::map<boost::uuids::uuid, std::vector<crypto::hash>> requests;
+  inventory.takeExpiredRequests(now + std::chrono::seconds(29), requests);
+  ASSERT_TRUE(requests.empty());
+
+  inventory.takeExpiredRequests(now + std::chrono::seconds(30), requests);
+  ASSERT_EQ(2, requests.size());
+  ASSERT_EQ(txIdSet(txIds(0, 2)), txIdSet(requests[second]));
+  ASSERT_EQ(txIdSet(txIds(2, 3)), txIdSet(requests[third]));
+
+  //the second peer stays silent too, only the third one is left for its transactions
+  requests.clear();
+  inventory.takeExpiredRequests(now + std::chrono::seconds(60), requests);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(txIdSet(txIds(0, 2)), txIdSet(requests[third]));
+
+  //without announcers left the requests are forgotten, a new announcement is requested right away
+  requests.clear();
+  inventory.takeExpiredRequests(now + std::chrono::seconds(90), requests);
+  ASSERT_TRUE(requests.empty());
+
+  request.clear();
+  inventory.takeRequests(silent, txIds(0, 3), now + std::chrono::seconds(90), request);
+  ASSERT_EQ(txIds(0, 3), request);
+}
+
+TEST(TxRelayInventory, missedIdsAreRequestedFromNextAnnouncerRightAway) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  boost::uuids::uuid first = boost::uuids::random_generator()();
+  boost::uuids::uuid second = boost::uuids::random_generator()();
+  auto now = std::chrono::steady_clock::now();
+
+  std::vector<crypto::hash> request;
+  inventory.takeRequests(first, txIds(0, 3), now, request);
+  inventory.takeRequests(second, txIds(0, 3), now, request);
+
+  //a peer that was not asked for them cannot expire the requests
+  inventory.missed(second, txIds(0, 3));
+  std::map<boost::uuids::uuid, std::vector<crypto::hash>> requests;
+  inventory.takeExpiredRequests(now, requests);
+  ASSERT_TRUE(requests.empty());
+
+  inventory.missed(first, txIds(1, 2));
+  inventory.takeExpiredRequests(now, requests);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(txIdSet(txIds(1, 2)), txIdSet(requests[second]));
+}
+
+TEST(TxRelayInventory, requestsOfRemovedConnectionMoveToNextAnnouncer) {
+  TxRelayInventory inventory(10, std::chrono::seconds(30));
+  boost::uuids::uuid first = boost::uuids::random_generator()();
+  boost::uuids::uuid second = boost::uuids::random_generator()();
+  boost::uuids::uuid third = boost::uuids::random_generator()();
+  auto now = std::chrono::steady_clock::now();
+  inventory.addConnection(first);
+  inventory.addConnection(second);
+  inventory.addConnection(third);
+
+  std::vector<crypto::hash> request;
+  inventory.takeRequests(first, txIds(0, 2), now, request);
+  inventory.takeRequests(second, txIds(0, 2), now, request);
+  inventory.takeRequests(third, txIds(0, 2), now, request);
+
+  inventory.removeConnection(second);
+  inventory.removeConnection(first);
+  std::map<boost::uuids::uuid, std::vector<crypto::hash>> requests;
+  inventory.takeExpiredRequests(now, requests);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(txIdSet(txIds(0, 2)), txIdSet(requests[third]));
+}
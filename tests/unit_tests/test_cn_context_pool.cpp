@@ -0,0 +1,49 @@
+// Copyright (c) 2011-2015 The Cryptonote developers
+// Copyright (c) 2014-2015 XDN developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "crypto/hash.h"
+#include "string_tools.h"
+
+namespace {
+  crypto::hash expectedSlowHash() {
+    crypto::hash h;
+    epee::string_tools::hex_to_pod("2f8e3df40bd11f9ac90c743ca8e32bb391da4fb98612aa3b6cdc639ee00b31f5", h);
+    return h;
+  }
+
+  const std::string SLOW_HASH_INPUT = "de omnibus dubitandum";
+}
+
+TEST(cn_context_pool, releasedContextIsReused) {
+  const crypto::cn_context* first;
+  {
+    crypto::pooled_cn_context context;
+    first = &context.get();
+  }
+
+  ASSERT_LE(1, crypto::cn_context_pool::idle());
+
+  crypto::pooled_cn_context context;
+  ASSERT_EQ(first, &context.get());
+}
+
+TEST(cn_context_pool, borrowedContextsAreDistinct) {
+  crypto::pooled_cn_context first;
+  crypto::pooled_cn_context second;
+  ASSERT_NE(&first.get(), &second.get());
+}
+
+TEST(cn_context_pool, reusedContextHashesCorrectly) {
+  for (size_t i = 0; i < 2; ++i) {
+    crypto::pooled_cn_context context;
+    crypto::hash h;
+    crypto::cn_slow_hash(context, SLOW_HASH_INPUT.data(), SLOW_HASH_INPUT.size(), h);
+    ASSERT_EQ(expectedSlowHash(), h);
+  }
+}
@@ -30,3 +30,41 @@ TEST(protocol_pack, protocol_pack_command)
     ASSERT_TRUE(r.total_height == 3);
   }
 }
+
+namespace
+{
+  // CORE_SYNC_DATA of the peers that don't know compact blocks
+  struct OldCoreSyncData
+  {
+    uint64_t current_height;
+    crypto::hash top_id;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(current_height)
+      KV_SERIALIZE_VAL_POD_AS_BLOB(top_id)
+    END_KV_SERIALIZE_MAP()
+  };
+}
+
+TEST(protocol_pack, core_sync_data_compact_blocks_flag)
+{
+  OldCoreSyncData oldData = boost::value_initialized<OldCoreSyncData>();
+  oldData.current_height = 100;
+  std::string buff;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(oldData, buff));
+
+  cryptonote::CORE_SYNC_DATA data = boost::value_initialized<cryptonote::CORE_SYNC_DATA>();
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(data, buff));
+  ASSERT_EQ(100, data.current_height);
+  ASSERT_FALSE(data.compact_blocks);
+
+  data.compact_blocks = true;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(data, buff));
+  cryptonote::CORE_SYNC_DATA data2 = boost::value_initialized<cryptonote::CORE_SYNC_DATA>();
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(data2, buff));
+  ASSERT_TRUE(data2.compact_blocks);
+
+  OldCoreSyncData oldData2 = boost::value_initialized<OldCoreSyncData>();
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(oldData2, buff));
+  ASSERT_EQ(100, oldData2.current_height);
+}
@@ -27,6 +27,72 @@ class TransactionValidator : public CryptoNote::ITransactionValidator {
   virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx) {
     return false;
   }
+
+  virtual bool isInCheckpointZone() const {
+    return false;
+  }
+};
+
+// Admits transactions as checked against block 0 and counts the checks fill_block_template runs.
+class ReadyCheckValidator : public CryptoNote::ITransactionValidator {
+public:
+  ReadyCheckValidator() : admit(true), ready(true), checks(0) {}
+
+  bool admit;
+  bool ready;
+  size_t checks;
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock) {
+    maxUsedBlock.height = 0;
+    maxUsedBlock.id = get_transaction_hash(tx);
+    return admit;
+  }
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) {
+    ++checks;
+    return ready;
+  }
+
+  virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx) {
+    return false;
+  }
+
+  virtual bool isInCheckpointZone() const {
+    return false;
+  }
+};
+
+// Adds another transaction to the pool while the inputs of the first one are checked, as a concurrent
+// core::handle_incoming_tx may do.
+class InterleavingValidator : public CryptoNote::ITransactionValidator {
+public:
+  InterleavingValidator() : pool(nullptr) {}
+
+  tx_memory_pool* pool;
+  Transaction interleaved;
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock) {
+    if (pool != nullptr) {
+      tx_memory_pool* p = pool;
+      pool = nullptr;
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      p->add_tx(interleaved, tvc, false);
+    }
+
+    return true;
+  }
+
+  virtual bool checkTransactionInputs(const cryptonote::Transaction& tx, BlockInfo& maxUsedBlock, BlockInfo& lastFailed) {
+    return true;
+  }
+
+  virtual bool haveSpentKeyImages(const cryptonote::Transaction& tx) {
+    return false;
+  }
+
+  virtual bool isInCheckpointZone() const {
+    return false;
+  }
 };
 
 class FakeTimeProvider : public ITimeProvider {
@@ -411,3 +477,139 @@ TEST(tx_pool, add_tx_after_cleanup)
   ASSERT_EQ(1, pool.get_transactions_count());
 
 }
+
+namespace {
+  std::vector<crypto::hash> fillBlock(tx_memory_pool& pool) {
+    Block bl;
+    InitBlock(bl);
+    size_t totalSize = 0;
+    uint64_t txFee = 0;
+    EXPECT_TRUE(pool.fill_block_template(bl, 5000, textMaxCumulativeSize, 0, totalSize, txFee));
+    return bl.txHashes;
+  }
+}
+
+TEST(tx_pool, fillblock_takes_admitted_transactions_without_checks)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<ReadyCheckValidator, RealTimeProvider> pool(currency);
+
+  for (int i = 0; i < 3; ++i) {
+    Transaction tx;
+    GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+    tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+    ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+  }
+
+  std::vector<crypto::hash> txHashes = fillBlock(pool);
+  ASSERT_EQ(3, txHashes.size());
+  ASSERT_EQ(txHashes, fillBlock(pool));
+  ASSERT_EQ(0, pool.validator.checks);
+}
+
+TEST(tx_pool, fillblock_rechecks_failed_transactions_after_new_block)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<ReadyCheckValidator, RealTimeProvider> pool(currency);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  pool.validator.admit = false;
+  pool.validator.ready = false;
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, true));
+
+  ASSERT_TRUE(fillBlock(pool).empty());
+  ASSERT_EQ(1, pool.validator.checks);
+
+  // not checked again on the same chain
+  pool.validator.ready = true;
+  ASSERT_TRUE(fillBlock(pool).empty());
+  ASSERT_EQ(1, pool.validator.checks);
+
+  pool.on_blockchain_inc(2, null_hash);
+  ASSERT_EQ(1, fillBlock(pool).size());
+  ASSERT_EQ(2, pool.validator.checks);
+}
+
+TEST(tx_pool, take_tx_rechecks_transactions_with_same_inputs)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<ReadyCheckValidator, RealTimeProvider> pool(currency);
+  TestTransactionGenerator txGenerator(currency, 1);
+  txGenerator.createSources();
+
+  Transaction tx;
+  Transaction txDouble;
+  txGenerator.construct(txGenerator.m_source_amount, currency.minimumFee(), 1, tx);
+  txGenerator.rv_acc.generate();
+  txGenerator.construct(txGenerator.m_source_amount, currency.minimumFee(), 1, txDouble);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, true));
+  ASSERT_TRUE(pool.add_tx(txDouble, tvc, true));
+  ASSERT_EQ(1, fillBlock(pool).size());
+
+  Transaction txOut;
+  size_t blobSize;
+  uint64_t fee;
+  ASSERT_TRUE(pool.take_tx(get_transaction_hash(tx), txOut, blobSize, fee));
+
+  pool.validator.ready = false;
+  ASSERT_TRUE(fillBlock(pool).empty());
+  ASSERT_EQ(1, pool.validator.checks);
+}
+
+TEST(tx_pool, on_blockchain_dec_rechecks_ready_transactions)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<ReadyCheckValidator, RealTimeProvider> pool(currency);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+  ASSERT_EQ(1, fillBlock(pool).size());
+
+  pool.on_blockchain_dec(1, null_hash);
+  pool.validator.ready = false;
+  ASSERT_TRUE(fillBlock(pool).empty());
+  ASSERT_EQ(1, pool.validator.checks);
+}
+
+TEST(tx_pool, add_tx_rejects_double_spend_added_during_input_check)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<InterleavingValidator, RealTimeProvider> pool(currency);
+
+  TestTransactionGenerator txGenerator(currency, 1);
+  txGenerator.createSources();
+  Transaction tx;
+  txGenerator.construct(txGenerator.m_source_amount, currency.minimumFee(), 1, tx);
+  txGenerator.rv_acc.generate();
+  txGenerator.construct(txGenerator.m_source_amount, currency.minimumFee(), 1, pool.validator.interleaved);
+  pool.validator.pool = &pool;
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_FALSE(pool.add_tx(tx, tvc, false));
+  ASSERT_TRUE(tvc.m_verifivation_failed);
+  ASSERT_EQ(1, pool.get_transactions_count());
+  ASSERT_TRUE(pool.have_tx(get_transaction_hash(pool.validator.interleaved)));
+}
+
+TEST(tx_pool, add_tx_ignores_same_transaction_added_during_input_check)
+{
+  cryptonote::Currency currency = cryptonote::CurrencyBuilder().currency();
+  TestPool<InterleavingValidator, RealTimeProvider> pool(currency);
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+  pool.validator.interleaved = tx;
+  pool.validator.pool = &pool;
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool.add_tx(tx, tvc, false));
+  ASSERT_FALSE(tvc.m_verifivation_failed);
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_EQ(1, pool.get_transactions_count());
+}